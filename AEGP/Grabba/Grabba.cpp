@@ -9,14 +9,18 @@ namespace py = pybind11;
 
 AEGP_PluginID myID = 3927L;
 
-void saveFrame(int i, LayerRenderOptionsPtr layerRenderOptions) {
-	LayerRenderOptionsSuite().setTime(layerRenderOptions, FramesToTime(i)); // Set the time of the layer render options
-	AsyncRenderManager rmanager; // Create an instance of the AsyncRenderManager class
-	rmanager.renderAsync(layerRenderOptions, [i](WorldPtr world) { // Call the renderAsync method with a lambda function
-		if (world) {
-			std::string folder = "C:\\Users\\tjerf\\Downloads\\pdf_output\\New folder\\";
-			auto data = Image::data(world); // Get the image data from the world
-			Image::saveImage(folder + "\\frame" + std::to_string(i) + ".png", "png", data); // Save the image to disk
+void saveFrames(LayerRenderOptionsPtr layerRenderOptions, int first, int count) {
+	auto context = ae::TimeContext::mostRecent(); // One lookup for every frame time
+	tk::vector<A_Time> times;
+	for (int i = first; i < first + count; ++i) {
+		times.push_back(context.framesToTime(i));
+	}
+	std::string folder = "C:\\Users\\tjerf\\Downloads\\pdf_output\\New folder\\";
+	// At most four frames render at once, and frames arrive here in order
+	ae::RenderPipeline::run(layerRenderOptions, times, [&](ae::RenderedFrame &frame) {
+		if (frame.ok()) {
+			auto data = Image::data(frame.world); // Get the image data from the world
+			Image::saveImage(folder + "\\frame" + std::to_string(first + frame.index) + ".png", "png", data); // Save the image to disk
 		}
 		});
 }
@@ -77,31 +77,28 @@ private:
     }
 
     // Logging property details with improved structure
-    inline void logPropertyDetails(const std::shared_ptr<BaseProperty>& prop, std::ofstream& outFile, int indentLevel) {
-        auto propName = prop->getName();
-        auto matchName = prop->matchName();
-        auto propType = StreamTypeToString(prop->getType());
-        auto numKeys = prop->numKeys();
+    inline void logPropertyDetails(const PropertyTree& tree, int node, std::ofstream& outFile, int indentLevel) {
+        const auto& prop = tree[node];
+        auto numKeys = prop.numKeys; // Read with the rest of the snapshot, no task per leaf
 
         outFile << indent(indentLevel) << "Property:\n"
-            << indent(indentLevel + 1) << "Name: " << propName << "\n"
-            << indent(indentLevel + 1) << "Match Name: " << matchName << "\n"
-            << indent(indentLevel + 1) << "Type: " << propType << "\n"
+            << indent(indentLevel + 1) << "Name: " << prop.name << "\n"
+            << indent(indentLevel + 1) << "Match Name: " << tree.matchName(node) << "\n"
+            << indent(indentLevel + 1) << "Type: " << StreamTypeToString(prop.type) << "\n"
             << indent(indentLevel + 1) << "# of KeyFrames: " << numKeys << "\n";
     }
 
     // Enhanced property processing with clearer group delineation
-    inline void processProperty(const std::shared_ptr<BaseProperty>& prop, std::ofstream& outFile, int indentLevel) {
+    inline void processProperty(const PropertyTree& tree, int node, std::ofstream& outFile, int indentLevel) {
         try {
             // Property details logging
-            logPropertyDetails(prop, outFile, indentLevel);
+            logPropertyDetails(tree, node, outFile, indentLevel);
 
-            if (prop->getType() == StreamType::NONE && DynamicStreamSuite().GetStreamGroupingType(prop->getStream()) != StreamGroupingType::LEAF) {
+            if (tree[node].isGroup()) {
                 // Clearer delineation for groups with sub-properties
                 outFile << indent(indentLevel) << "Contains Sub-properties:\n";
-                auto group = std::static_pointer_cast<PropertyGroup>(prop);
-                for (int i = 0; i < group->getNumProperties(); ++i) {
-                    processProperty(group->getPropertyByIndex(i), outFile, indentLevel + 1);
+                for (int child : tree.children(node)) {
+                    processProperty(tree, child, outFile, indentLevel + 1);
                 }
             }
             outFile << "\n"; // Adds spacing after each property or group for better readability
@@ -111,29 +108,25 @@ private:
             outFile << logOss.str(); // Ensure consistent structure in case of exceptions
         }
     }
-    // Function to check if a specific flag is set
-    bool IsFlagSet(DynStreamFlag flags, DynStreamFlag flagToCheck) {
-        return static_cast<int>(flags) & static_cast<int>(flagToCheck);
-    }
 
     // Simplifying the layer processing for better readability
     inline void processLayer(const std::shared_ptr<Layer>& layer, std::ofstream& outFile, int indentLevel = 0) {
         try {
+            auto tree = PropertyTree::snapshot(layer->getLayer()); // Reads the whole property tree in one go
             outFile << indent(indentLevel) << "Layer Details:\n"
                 << indent(indentLevel + 1) << "Name: " << layer->getName() << "\n"
-                << indent(indentLevel + 1) << "Match Name: " << layer->matchName() << "\n"
+                << indent(indentLevel + 1) << "Match Name: " << tree.matchName(0) << "\n"
                 << indent(indentLevel + 1) << "Layer Duration: " << layer->duration() << "\n"
                 << indent(indentLevel + 1) << "Layer InPoint: " << layer->inPoint() << "\n"
-                << indent(indentLevel + 1) << "Properties Count: " << layer->getNumProperties() << "\n";
-            for (int i = 0; i < layer->getNumProperties(); ++i) {
-                auto prop = layer->getPropertyByIndex(i);
-                auto flags = DynamicStreamSuite().GetDynamicStreamFlags(prop->getStream());
-                if (IsFlagSet(flags, DynStreamFlag::HIDDEN) || IsFlagSet(flags, DynStreamFlag::DISABLED) || IsFlagSet(flags, DynStreamFlag::ELIDED))
+                << indent(indentLevel + 1) << "Properties Count: " << tree[0].numChildren << "\n";
+            for (int child : tree.children(0)) {
+                const auto& prop = tree[child];
+                if (prop.hasFlag(DynStreamFlag::HIDDEN) || prop.hasFlag(DynStreamFlag::DISABLED) || prop.hasFlag(DynStreamFlag::ELIDED))
                 {
 					continue; // Skip hidden or disabled properties
 				}
                 else {
-					processProperty(prop, outFile, indentLevel + 1);
+					processProperty(tree, child, outFile, indentLevel + 1);
 				}
             }
             outFile << "\n"; // Adds a space after each layer for separation
@@ -21,53 +21,37 @@
 #include "AETK/AEGP/Template/Plugin.hpp"
 
 #include "AETK/AEGP/Util/AssetManager.hpp"
+#include "AETK/AEGP/Util/AtomTable.hpp"
+#include "AETK/AEGP/Util/CompGraph.hpp"
+#include "AETK/AEGP/Util/CompQuery.hpp"
 #include "AETK/AEGP/Util/Context.hpp"
+#include "AETK/AEGP/Util/CurveFitter.hpp"
+#include "AETK/AEGP/Util/EffectRegistry.hpp"
 #include "AETK/AEGP/Util/Effects.hpp"
 #include "AETK/AEGP/Util/Factories.hpp"
+#include "AETK/AEGP/Util/FrameCache.hpp"
+#include "AETK/AEGP/Util/IdentityMap.hpp"
 #include "AETK/AEGP/Util/Image.hpp"
 #include "AETK/AEGP/Util/Keyframe.hpp"
+#include "AETK/AEGP/Util/KeyframeDiff.hpp"
+#include "AETK/AEGP/Util/LayerQuery.hpp"
+#include "AETK/AEGP/Util/MarkerTrack.hpp"
+#include "AETK/AEGP/Util/MaskRasterizer.hpp"
 #include "AETK/AEGP/Util/Masks.hpp"
+#include "AETK/AEGP/Util/Parallel.hpp"
 #include "AETK/AEGP/Util/Properties.hpp"
+#include "AETK/AEGP/Util/ProjectIndex.hpp"
+#include "AETK/AEGP/Util/PropertyTree.hpp"
+#include "AETK/AEGP/Util/RenderPipeline.hpp"
 #include "AETK/AEGP/Util/TaskScheduler.hpp"
+#include "AETK/AEGP/Util/ThumbnailService.hpp"
+#include "AETK/AEGP/Util/TiledRenderer.hpp"
+#include "AETK/AEGP/Util/TransformGraph.hpp"
+#include "AETK/AEGP/Util/WorldUtil.hpp"
 
 #include "AETK/AEGP/App.hpp"     // Application Class
 #include "AETK/AEGP/Items.hpp"   // Item Classes
 #include "AETK/AEGP/Layers.hpp"  // Layer Classes
 #include "AETK/AEGP/Project.hpp" // Project Class
 
-
-class AsyncRenderManager
-    {
-  public:
-    AsyncRenderManager() {}
-
-    // Method to initiate async rendering with an optional custom callback
-    void renderAsync(LayerRenderOptionsPtr optionsH, std::function<void(WorldPtr)> callbackF)
-    {
-        auto callbackPtr = new std::function<void(WorldPtr)>(callbackF);
-
-        auto ret = std::async(std::launch::async, [optionsH, callbackPtr]() {
-            RenderSuite().renderAndCheckoutLayerFrameAsync(optionsH, callback,
-                                                           reinterpret_cast<AEGP_AsyncFrameRequestRefcon>(callbackPtr));
-        });
-    }
-
-
-    // Existing static callback method remains unchanged
-    static A_Err callback(AEGP_AsyncRequestId request_id, A_Boolean was_canceled, A_Err error,
-                          AEGP_FrameReceiptH receiptH, AEGP_AsyncFrameRequestRefcon refconP0)
-    {
-        auto callbackPtr = reinterpret_cast<std::function<void(WorldPtr)> *>(refconP0);
-
-        if (callbackPtr && *callbackPtr)
-        {
-            FrameReceiptPtr ptr = makeFrameReceiptPtr(receiptH);
-            auto& world = RenderSuite().getReceiptWorld(ptr);
-            (*callbackPtr)(world);
-            delete callbackPtr;
-        }
-        return error;
-    }
-};
-
 #endif // AEGP_HPP
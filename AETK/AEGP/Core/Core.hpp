@@ -11,7 +11,9 @@
 #include "AETK/AEGP/Core/Allocator.hpp" /* Custom Allocator FOr After Effects*/
 #include "AETK/AEGP/Core/Enums.hpp"     /*  Enums For After Effects*/
 #include "AETK/AEGP/Core/Exception.hpp" /* Custom Exception For After Effects*/
+#include "AETK/AEGP/Core/RationalTime.hpp" /* Exact Time Arithmetic*/
 #include "AETK/AEGP/Core/Suites.hpp"    /* Suite Wrappers For After Effects*/
+#include "AETK/AEGP/Core/TimeContext.hpp" /* Comp-Bound Time Conversions*/
 #include "AETK/AEGP/Core/Types.hpp"     /*  Types For After Effects*/
 #include "AETK/AEGP/Core/Utility.hpp"   /* Utility For After Effects*/
 
@@ -0,0 +1,324 @@
+/*****************************************************************/ /**
+                                                                     * \file   Matrix.hpp
+                                                                     * \brief  Fixed-size vectors and matrices for
+                                                                     *layer transforms.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef MATRIX_HPP
+#define MATRIX_HPP
+
+#include <cmath>
+#include <optional>
+
+namespace ae
+{
+
+/**
+ * @brief Three doubles, stored contiguously.
+ */
+struct Vec3
+{
+    double x = 0.0, y = 0.0, z = 0.0;
+
+    constexpr Vec3() = default;
+    constexpr Vec3(double x, double y, double z) : x(x), y(y), z(z) {}
+
+    constexpr Vec3 operator+(const Vec3 &o) const { return {x + o.x, y + o.y, z + o.z}; }
+    constexpr Vec3 operator-(const Vec3 &o) const { return {x - o.x, y - o.y, z - o.z}; }
+    constexpr Vec3 operator-() const { return {-x, -y, -z}; }
+    constexpr Vec3 operator*(double s) const { return {x * s, y * s, z * s}; }
+    constexpr bool operator==(const Vec3 &o) const { return x == o.x && y == o.y && z == o.z; }
+    constexpr bool operator!=(const Vec3 &o) const { return !(*this == o); }
+
+    constexpr double dot(const Vec3 &o) const { return x * o.x + y * o.y + z * o.z; }
+    constexpr Vec3 cross(const Vec3 &o) const { return {y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x}; }
+    double length() const { return std::sqrt(dot(*this)); }
+    Vec3 normalized() const
+    {
+        double len = length();
+        return len > 0.0 ? *this * (1.0 / len) : Vec3();
+    }
+};
+
+/**
+ * @brief Four doubles, stored contiguously. Homogeneous points have w = 1.
+ */
+struct Vec4
+{
+    double x = 0.0, y = 0.0, z = 0.0, w = 0.0;
+
+    constexpr Vec4() = default;
+    constexpr Vec4(double x, double y, double z, double w) : x(x), y(y), z(z), w(w) {}
+    constexpr Vec4(const Vec3 &v, double w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+    constexpr Vec3 xyz() const { return {x, y, z}; }
+    constexpr bool operator==(const Vec4 &o) const { return x == o.x && y == o.y && z == o.z && w == o.w; }
+    constexpr bool operator!=(const Vec4 &o) const { return !(*this == o); }
+};
+
+/**
+ * @brief Row-major 3x3 matrix, same layout as A_Matrix3.
+ */
+struct Mat3
+{
+    double m[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+
+    static constexpr Mat3 identity() { return Mat3(); }
+
+    constexpr double &operator()(int row, int col) { return m[row * 3 + col]; }
+    constexpr double operator()(int row, int col) const { return m[row * 3 + col]; }
+
+    constexpr Mat3 operator*(const Mat3 &o) const
+    {
+        Mat3 r;
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                r.m[i * 3 + j] = m[i * 3] * o.m[j] + m[i * 3 + 1] * o.m[3 + j] + m[i * 3 + 2] * o.m[6 + j];
+            }
+        }
+        return r;
+    }
+
+    constexpr Mat3 transposed() const
+    {
+        Mat3 r;
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                r.m[j * 3 + i] = m[i * 3 + j];
+            }
+        }
+        return r;
+    }
+
+    constexpr bool operator==(const Mat3 &o) const
+    {
+        for (int i = 0; i < 9; ++i)
+        {
+            if (m[i] != o.m[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Row-major 4x4 matrix, same layout and convention as A_Matrix4.
+ *
+ * Points are row vectors transformed as p * M, so the translation lives in the
+ * last row and A * B applies A first. A layer's world matrix is therefore
+ * local * parentWorld, which is what AEGP_GetLayerToWorldXform returns.
+ *
+ * Storage is a flat array of 16 doubles and every loop has a constant trip
+ * count, so products and point transforms vectorize without intrinsics.
+ */
+struct Mat4
+{
+    double m[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+    static constexpr Mat4 identity() { return Mat4(); }
+
+    static constexpr Mat4 translation(const Vec3 &t)
+    {
+        Mat4 r;
+        r.m[12] = t.x;
+        r.m[13] = t.y;
+        r.m[14] = t.z;
+        return r;
+    }
+
+    static constexpr Mat4 scale(const Vec3 &s)
+    {
+        Mat4 r;
+        r.m[0] = s.x;
+        r.m[5] = s.y;
+        r.m[10] = s.z;
+        return r;
+    }
+
+    /**
+     * @brief Rotations in degrees, matching AE's X, Y and Z Rotation streams
+     * (Y down, positive Z rotation is clockwise on screen).
+     */
+    static Mat4 rotationX(double degrees)
+    {
+        double a = degrees * (3.14159265358979323846 / 180.0), c = std::cos(a), s = std::sin(a);
+        Mat4 r;
+        r.m[5] = c;
+        r.m[6] = s;
+        r.m[9] = -s;
+        r.m[10] = c;
+        return r;
+    }
+
+    static Mat4 rotationY(double degrees)
+    {
+        double a = degrees * (3.14159265358979323846 / 180.0), c = std::cos(a), s = std::sin(a);
+        Mat4 r;
+        r.m[0] = c;
+        r.m[2] = -s;
+        r.m[8] = s;
+        r.m[10] = c;
+        return r;
+    }
+
+    static Mat4 rotationZ(double degrees)
+    {
+        double a = degrees * (3.14159265358979323846 / 180.0), c = std::cos(a), s = std::sin(a);
+        Mat4 r;
+        r.m[0] = c;
+        r.m[1] = s;
+        r.m[4] = -s;
+        r.m[5] = c;
+        return r;
+    }
+
+    /**
+     * @brief Orientation stream (X, Y, Z degrees), applied X then Y then Z.
+     */
+    static Mat4 orientation(const Vec3 &degrees)
+    {
+        return rotationX(degrees.x) * rotationY(degrees.y) * rotationZ(degrees.z);
+    }
+
+    /**
+     * @brief Rotation that points +Z from eye towards target, keeping +Y down.
+     * Used for cameras and lights that auto-orient towards their point of interest.
+     */
+    static Mat4 lookAt(const Vec3 &eye, const Vec3 &target)
+    {
+        Vec3 forward = (target - eye).normalized();
+        if (forward == Vec3())
+        {
+            return Mat4();
+        }
+        Vec3 right = Vec3(0, 1, 0).cross(forward);
+        if (right.dot(right) < 1e-12) // Looking straight up or down
+        {
+            right = Vec3(1, 0, 0);
+        }
+        right = right.normalized();
+        Vec3 down = forward.cross(right);
+
+        Mat4 r;
+        const Vec3 rows[3] = {right, down, forward};
+        for (int i = 0; i < 3; ++i)
+        {
+            r.m[i * 4] = rows[i].x;
+            r.m[i * 4 + 1] = rows[i].y;
+            r.m[i * 4 + 2] = rows[i].z;
+        }
+        return r;
+    }
+
+    constexpr double &operator()(int row, int col) { return m[row * 4 + col]; }
+    constexpr double operator()(int row, int col) const { return m[row * 4 + col]; }
+
+    constexpr Mat4 operator*(const Mat4 &o) const
+    {
+        Mat4 r;
+        for (int i = 0; i < 4; ++i)
+        {
+            const double *a = m + i * 4;
+            for (int j = 0; j < 4; ++j)
+            {
+                r.m[i * 4 + j] = a[0] * o.m[j] + a[1] * o.m[4 + j] + a[2] * o.m[8 + j] + a[3] * o.m[12 + j];
+            }
+        }
+        return r;
+    }
+
+    constexpr Vec4 transform(const Vec4 &v) const
+    {
+        return {v.x * m[0] + v.y * m[4] + v.z * m[8] + v.w * m[12], v.x * m[1] + v.y * m[5] + v.z * m[9] + v.w * m[13],
+                v.x * m[2] + v.y * m[6] + v.z * m[10] + v.w * m[14],
+                v.x * m[3] + v.y * m[7] + v.z * m[11] + v.w * m[15]};
+    }
+
+    constexpr Vec3 transformPoint(const Vec3 &p) const { return transform(Vec4(p, 1.0)).xyz(); }
+    constexpr Vec3 transformVector(const Vec3 &v) const { return transform(Vec4(v, 0.0)).xyz(); }
+
+    constexpr Vec3 translationPart() const { return {m[12], m[13], m[14]}; }
+
+    constexpr Mat3 linearPart() const
+    {
+        Mat3 r;
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                r.m[i * 3 + j] = m[i * 4 + j];
+            }
+        }
+        return r;
+    }
+
+    constexpr Mat4 transposed() const
+    {
+        Mat4 r;
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                r.m[j * 4 + i] = m[i * 4 + j];
+            }
+        }
+        return r;
+    }
+
+    /**
+     * @brief Inverse of an affine matrix (last column 0, 0, 0, 1), or nullopt if it is singular, e.g. at 0% scale.
+     */
+    std::optional<Mat4> affineInverse() const
+    {
+        double a = m[0], b = m[1], c = m[2];
+        double d = m[4], e = m[5], f = m[6];
+        double g = m[8], h = m[9], k = m[10];
+        double c0 = e * k - f * h, c1 = f * g - d * k, c2 = d * h - e * g;
+        double det = a * c0 + b * c1 + c * c2;
+        if (std::abs(det) < 1e-300)
+        {
+            return std::nullopt;
+        }
+        double inv = 1.0 / det;
+        Mat4 r;
+        r.m[0] = c0 * inv;
+        r.m[1] = (c * h - b * k) * inv;
+        r.m[2] = (b * f - c * e) * inv;
+        r.m[4] = c1 * inv;
+        r.m[5] = (a * k - c * g) * inv;
+        r.m[6] = (c * d - a * f) * inv;
+        r.m[8] = c2 * inv;
+        r.m[9] = (b * g - a * h) * inv;
+        r.m[10] = (a * e - b * d) * inv;
+        Vec3 t = -r.transformVector(translationPart());
+        r.m[12] = t.x;
+        r.m[13] = t.y;
+        r.m[14] = t.z;
+        return r;
+    }
+
+    constexpr bool operator==(const Mat4 &o) const
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            if (m[i] != o.m[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    constexpr bool operator!=(const Mat4 &o) const { return !(*this == o); }
+};
+
+} // namespace ae
+
+#endif // MATRIX_HPP
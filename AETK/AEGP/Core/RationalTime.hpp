@@ -0,0 +1,362 @@
+/*****************************************************************/ /**
+                                                                     * \file   RationalTime.hpp
+                                                                     * \brief  Exact rational time arithmetic for A_Time,
+                                                                     *and layer/comp time mapping without AE.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef RATIONAL_TIME_HPP
+#define RATIONAL_TIME_HPP
+
+#include "AETK/AEGP/Core/Types.hpp"
+
+#include <cstdint>
+#include <limits>
+
+namespace ae
+{
+
+enum class TimeRounding
+{
+    Floor,
+    Nearest, // Halves round away from zero
+    Ceil
+};
+
+namespace detail
+{
+
+constexpr uint64_t magnitude(int64_t v)
+{
+    return v < 0 ? uint64_t(0) - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+}
+
+constexpr uint64_t gcd(uint64_t a, uint64_t b)
+{
+    while (b != 0)
+    {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+constexpr int64_t checkedMul(int64_t a, int64_t b)
+{
+    if (a == 0 || b == 0)
+    {
+        return 0;
+    }
+    const int64_t max = std::numeric_limits<int64_t>::max();
+    if (magnitude(a) > static_cast<uint64_t>(max) / magnitude(b))
+    {
+        throw AEException("RationalTime overflow");
+    }
+    return a * b;
+}
+
+constexpr int64_t checkedAdd(int64_t a, int64_t b)
+{
+    const int64_t max = std::numeric_limits<int64_t>::max();
+    const int64_t min = std::numeric_limits<int64_t>::min();
+    if ((b > 0 && a > max - b) || (b < 0 && a < min - b))
+    {
+        throw AEException("RationalTime overflow");
+    }
+    return a + b;
+}
+
+// Sign of a * b - c * d for b, d > 0, using a 128-bit product split into 32-bit halves.
+constexpr int compareProducts(int64_t a, int64_t b, int64_t c, int64_t d)
+{
+    const int signL = a < 0 ? -1 : a > 0 ? 1 : 0;
+    const int signR = c < 0 ? -1 : c > 0 ? 1 : 0;
+    if (signL != signR)
+    {
+        return signL < signR ? -1 : 1;
+    }
+    if (signL == 0)
+    {
+        return 0;
+    }
+    struct U128
+    {
+        uint64_t hi, lo;
+    };
+    auto mul = [](uint64_t x, uint64_t y) {
+        const uint64_t x0 = x & 0xFFFFFFFFu, x1 = x >> 32;
+        const uint64_t y0 = y & 0xFFFFFFFFu, y1 = y >> 32;
+        const uint64_t p00 = x0 * y0, p01 = x0 * y1, p10 = x1 * y0, p11 = x1 * y1;
+        const uint64_t mid = (p00 >> 32) + (p01 & 0xFFFFFFFFu) + (p10 & 0xFFFFFFFFu);
+        return U128{p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32), (mid << 32) | (p00 & 0xFFFFFFFFu)};
+    };
+    const U128 l = mul(magnitude(a), static_cast<uint64_t>(b));
+    const U128 r = mul(magnitude(c), static_cast<uint64_t>(d));
+    const int cmp = l.hi != r.hi ? (l.hi < r.hi ? -1 : 1) : l.lo != r.lo ? (l.lo < r.lo ? -1 : 1) : 0;
+    return signL > 0 ? cmp : -cmp;
+}
+
+// num / den rounded to an integer, den > 0.
+constexpr int64_t divide(int64_t num, int64_t den, TimeRounding rounding)
+{
+    int64_t q = num / den;
+    int64_t r = num % den;
+    if (r < 0) // Make q the floor
+    {
+        --q;
+        r += den;
+    }
+    switch (rounding)
+    {
+    case TimeRounding::Floor:
+        return q;
+    case TimeRounding::Ceil:
+        return r != 0 ? q + 1 : q;
+    default:
+        return (r > den - r || (r == den - r && r != 0 && num >= 0)) ? q + 1 : q;
+    }
+}
+
+} // namespace detail
+
+/**
+ * @class RationalTime
+ * @brief A time, duration or ratio held exactly as num / den in 64-bit integers.
+ *
+ * A_Time only keeps 32 bits and differing scales, so adding an offset to a
+ * stretched time or stepping through 29.97 fps frames in doubles drifts.
+ * RationalTime is always reduced (den > 0, gcd(num, den) == 1), so equal times
+ * compare equal whatever scale they came from. Sums and products cross-reduce
+ * before multiplying and comparisons use 128-bit products; an operation whose
+ * reduced result does not fit in 64 bits throws AEException.
+ *
+ * Everything is constexpr and touches nothing in AE.
+ *
+ * @example
+ * constexpr ae::RationalTime frame(1001, 30000); // 29.97 fps
+ * auto t = ae::RationalTime(layerTime) + frame * 3;
+ * A_Time onFrame = t.snap(frame).toAEGP();
+ */
+class RationalTime
+{
+  public:
+    constexpr RationalTime() : m_num(0), m_den(1) {}
+    constexpr RationalTime(int64_t num, int64_t den = 1) : m_num(num), m_den(den)
+    {
+        if (den == 0)
+        {
+            throw AEException("RationalTime with a zero denominator");
+        }
+        normalize();
+    }
+    constexpr RationalTime(const A_Time &time) : RationalTime(time.value, static_cast<int64_t>(time.scale)) {}
+
+    /**
+     * @brief A stretch or other ratio, e.g. GetLayerStretch.
+     */
+    static constexpr RationalTime fromRatio(const A_Ratio &ratio)
+    {
+        return RationalTime(ratio.num, static_cast<int64_t>(ratio.den));
+    }
+
+    /**
+     * @brief seconds rounded to the nearest 1 / den.
+     */
+    static constexpr RationalTime fromSeconds(double seconds, int64_t den)
+    {
+        const double ticks = seconds * static_cast<double>(den);
+        return RationalTime(static_cast<int64_t>(ticks >= 0.0 ? ticks + 0.5 : ticks - 0.5), den);
+    }
+
+    static constexpr RationalTime fromFrames(int64_t frames, const RationalTime &frameDuration)
+    {
+        return frameDuration * frames;
+    }
+
+    constexpr int64_t num() const { return m_num; }
+    constexpr int64_t den() const { return m_den; }
+    constexpr bool isZero() const { return m_num == 0; }
+    constexpr double seconds() const { return static_cast<double>(m_num) / static_cast<double>(m_den); }
+
+    /**
+     * @brief The exact A_Time. Throws if num or den do not fit A_Time; use toAEGP(scale) to round instead.
+     */
+    constexpr A_Time toAEGP() const
+    {
+        if (m_num < std::numeric_limits<A_long>::min() || m_num > std::numeric_limits<A_long>::max() ||
+            m_den > static_cast<int64_t>(std::numeric_limits<A_u_long>::max()))
+        {
+            throw AEException("RationalTime does not fit an A_Time");
+        }
+        return {static_cast<A_long>(m_num), static_cast<A_u_long>(m_den)};
+    }
+
+    /**
+     * @brief The A_Time on time scale scale, rounded.
+     */
+    constexpr A_Time toAEGP(A_u_long scale, TimeRounding rounding = TimeRounding::Nearest) const
+    {
+        const int64_t value = (*this * static_cast<int64_t>(scale)).round(rounding);
+        if (value < std::numeric_limits<A_long>::min() || value > std::numeric_limits<A_long>::max())
+        {
+            throw AEException("RationalTime does not fit an A_Time");
+        }
+        return {static_cast<A_long>(value), scale};
+    }
+
+    /**
+     * @brief This value rounded to an integer.
+     */
+    constexpr int64_t round(TimeRounding rounding = TimeRounding::Nearest) const
+    {
+        return detail::divide(m_num, m_den, rounding);
+    }
+
+    /**
+     * @brief The frame number of this time, for frames of frameDuration starting at 0.
+     */
+    constexpr int64_t frames(const RationalTime &frameDuration, TimeRounding rounding = TimeRounding::Floor) const
+    {
+        return (*this / frameDuration).round(rounding);
+    }
+
+    /**
+     * @brief This time moved onto the frame grid of frameDuration.
+     */
+    constexpr RationalTime snap(const RationalTime &frameDuration, TimeRounding rounding = TimeRounding::Nearest) const
+    {
+        return frameDuration * frames(frameDuration, rounding);
+    }
+
+    constexpr RationalTime operator-() const { return RationalTime(Raw{}, detail::checkedMul(m_num, -1), m_den); }
+
+    friend constexpr RationalTime operator+(const RationalTime &a, const RationalTime &b)
+    {
+        const int64_t g = static_cast<int64_t>(detail::gcd(static_cast<uint64_t>(a.m_den), static_cast<uint64_t>(b.m_den)));
+        const int64_t num = detail::checkedAdd(detail::checkedMul(a.m_num, b.m_den / g),
+                                               detail::checkedMul(b.m_num, a.m_den / g));
+        return RationalTime(num, detail::checkedMul(a.m_den / g, b.m_den));
+    }
+    friend constexpr RationalTime operator-(const RationalTime &a, const RationalTime &b) { return a + (-b); }
+
+    friend constexpr RationalTime operator*(const RationalTime &a, const RationalTime &b)
+    {
+        if (a.m_num == 0 || b.m_num == 0)
+        {
+            return RationalTime();
+        }
+        const int64_t g1 = static_cast<int64_t>(detail::gcd(detail::magnitude(a.m_num), static_cast<uint64_t>(b.m_den)));
+        const int64_t g2 = static_cast<int64_t>(detail::gcd(detail::magnitude(b.m_num), static_cast<uint64_t>(a.m_den)));
+        return RationalTime(Raw{}, detail::checkedMul(a.m_num / g1, b.m_num / g2),
+                            detail::checkedMul(a.m_den / g2, b.m_den / g1));
+    }
+    friend constexpr RationalTime operator*(const RationalTime &a, int64_t b) { return a * RationalTime(b); }
+    friend constexpr RationalTime operator*(int64_t a, const RationalTime &b) { return RationalTime(a) * b; }
+
+    friend constexpr RationalTime operator/(const RationalTime &a, const RationalTime &b)
+    {
+        if (b.m_num == 0)
+        {
+            throw AEException("RationalTime division by zero");
+        }
+        const RationalTime inverse = b.m_num < 0 ? RationalTime(Raw{}, -b.m_den, detail::checkedMul(b.m_num, -1))
+                                                 : RationalTime(Raw{}, b.m_den, b.m_num);
+        return a * inverse;
+    }
+    friend constexpr RationalTime operator/(const RationalTime &a, int64_t b) { return a / RationalTime(b); }
+
+    constexpr RationalTime &operator+=(const RationalTime &o) { return *this = *this + o; }
+    constexpr RationalTime &operator-=(const RationalTime &o) { return *this = *this - o; }
+    constexpr RationalTime &operator*=(const RationalTime &o) { return *this = *this * o; }
+    constexpr RationalTime &operator/=(const RationalTime &o) { return *this = *this / o; }
+
+    // Reduced, so equality is member-wise.
+    friend constexpr bool operator==(const RationalTime &a, const RationalTime &b)
+    {
+        return a.m_num == b.m_num && a.m_den == b.m_den;
+    }
+    friend constexpr bool operator!=(const RationalTime &a, const RationalTime &b) { return !(a == b); }
+    friend constexpr bool operator<(const RationalTime &a, const RationalTime &b)
+    {
+        return detail::compareProducts(a.m_num, b.m_den, b.m_num, a.m_den) < 0;
+    }
+    friend constexpr bool operator>(const RationalTime &a, const RationalTime &b) { return b < a; }
+    friend constexpr bool operator<=(const RationalTime &a, const RationalTime &b) { return !(b < a); }
+    friend constexpr bool operator>=(const RationalTime &a, const RationalTime &b) { return !(a < b); }
+
+  private:
+    struct Raw
+    {
+    };
+    // Already reduced, with den > 0.
+    constexpr RationalTime(Raw, int64_t num, int64_t den) : m_num(num), m_den(den) {}
+
+    constexpr void normalize()
+    {
+        if (m_den < 0)
+        {
+            m_num = detail::checkedMul(m_num, -1);
+            m_den = detail::checkedMul(m_den, -1);
+        }
+        const uint64_t g = detail::gcd(detail::magnitude(m_num), static_cast<uint64_t>(m_den));
+        if (g > 1)
+        {
+            m_num /= static_cast<int64_t>(g);
+            m_den /= static_cast<int64_t>(g);
+        }
+        if (m_num == 0)
+        {
+            m_den = 1;
+        }
+    }
+
+    int64_t m_num;
+    int64_t m_den;
+};
+
+/**
+ * @class LayerTimeMap
+ * @brief Comp time to layer time and back, from the layer's offset and stretch.
+ *
+ * compTime = offset + layerTime * stretch, which is what
+ * AEGP_ConvertCompToLayerTime and AEGP_ConvertLayerToCompTime compute for a
+ * layer without time remapping. Read the map once with fromLayer and convert
+ * locally instead of making a main-thread round trip per time.
+ *
+ * @example
+ * auto map = ae::LayerTimeMap::fromLayer(layer->getLayer());
+ * A_Time local = map.toLayer(compTime).toAEGP(compTime.scale);
+ */
+class LayerTimeMap
+{
+  public:
+    constexpr LayerTimeMap() = default;
+    constexpr LayerTimeMap(const RationalTime &offset, const RationalTime &stretch) : m_offset(offset), m_stretch(stretch)
+    {
+        if (stretch.isZero())
+        {
+            throw AEException("LayerTimeMap with a zero stretch");
+        }
+    }
+
+    /**
+     * @brief Reads offset and stretch of layer, in one task.
+     */
+    static LayerTimeMap fromLayer(LayerPtr layer);
+
+    constexpr const RationalTime &offset() const { return m_offset; }
+    constexpr const RationalTime &stretch() const { return m_stretch; } // 1 is 100%, negative when reversed
+
+    constexpr RationalTime toLayer(const RationalTime &compTime) const { return (compTime - m_offset) / m_stretch; }
+    constexpr RationalTime toComp(const RationalTime &layerTime) const { return m_offset + layerTime * m_stretch; }
+
+  private:
+    RationalTime m_offset;
+    RationalTime m_stretch{1};
+};
+
+} // namespace ae
+
+#endif // RATIONAL_TIME_HPP
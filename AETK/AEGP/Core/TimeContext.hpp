@@ -0,0 +1,114 @@
+/*****************************************************************/ /**
+                                                                     * \file   TimeContext.hpp
+                                                                     * \brief  Seconds, frames and A_Time conversions
+                                                                     *bound to one comp's frame duration.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef TIME_CONTEXT_HPP
+#define TIME_CONTEXT_HPP
+
+#include "AETK/AEGP/Core/Types.hpp"
+
+namespace ae
+{
+
+/**
+ * @class TimeContext
+ * @brief The frame duration of a comp, kept as AE reports it (e.g. 1001/30000
+ * for 29.97 fps), and conversions that need nothing else.
+ *
+ * SecondsToTime, TimeToFrames and FramesToTime look up the most recently used
+ * comp on every call. A TimeContext is read once, with fromComp or mostRecent,
+ * and converts with integer arithmetic after that, so it may be used from any
+ * thread and inside main-thread tasks.
+ *
+ * @example
+ * auto ctx = ae::TimeContext::fromComp(comp->getComp());
+ * layer->setTimeContext(ctx);
+ * A_Time t = ctx.framesToTime(120); // Exactly frame 120, at any frame rate
+ */
+class TimeContext
+{
+  public:
+    /**
+     * @brief A context for the frame duration value / scale seconds.
+     */
+    constexpr TimeContext(A_long value, A_u_long scale) : m_frame{value > 0 ? value : 1, scale > 0 ? scale : 1} {}
+    constexpr explicit TimeContext(const A_Time &frameDuration)
+        : TimeContext(frameDuration.value, frameDuration.scale)
+    {
+    }
+
+    /**
+     * @brief Reads the frame duration of comp, in one task.
+     */
+    static TimeContext fromComp(CompPtr comp);
+
+    /**
+     * @brief Reads the frame duration of the most recently used comp, in one task. Throws if there is none.
+     */
+    static TimeContext mostRecent();
+
+    constexpr A_Time frameDuration() const { return m_frame; }
+    constexpr double frameRate() const { return static_cast<double>(m_frame.scale) / m_frame.value; }
+
+    /**
+     * @brief Exact seconds of time, with no rounding.
+     */
+    static constexpr double toSeconds(const A_Time &time)
+    {
+        return static_cast<double>(time.value) / static_cast<double>(time.scale);
+    }
+
+    /**
+     * @brief The frame boundary nearest to seconds, like SecondsToTime.
+     */
+    constexpr A_Time toTime(double seconds) const
+    {
+        return framesToTime(nearest(seconds * m_frame.scale / m_frame.value));
+    }
+
+    /**
+     * @brief The tick of the comp's time scale nearest to seconds, without snapping to a frame.
+     */
+    constexpr A_Time toTimeExact(double seconds) const { return {nearest(seconds * m_frame.scale), m_frame.scale}; }
+
+    constexpr A_Time framesToTime(A_long frames) const { return {frames * m_frame.value, m_frame.scale}; }
+
+    /**
+     * @brief The nearest frame number, computed in 64-bit integers.
+     */
+    constexpr A_long toFrames(const A_Time &time) const
+    {
+        const int64_t num = static_cast<int64_t>(time.value) * m_frame.scale;
+        const int64_t den = static_cast<int64_t>(time.scale) * m_frame.value;
+        // Round half away from zero, as std::round does.
+        return static_cast<A_long>(num >= 0 ? (2 * num + den) / (2 * den) : -((-2 * num + den) / (2 * den)));
+    }
+
+    /**
+     * @brief time moved to the nearest frame boundary.
+     */
+    constexpr A_Time snap(const A_Time &time) const { return framesToTime(toFrames(time)); }
+
+    constexpr bool operator==(const TimeContext &o) const
+    {
+        return static_cast<int64_t>(m_frame.value) * o.m_frame.scale ==
+               static_cast<int64_t>(o.m_frame.value) * m_frame.scale;
+    }
+    constexpr bool operator!=(const TimeContext &o) const { return !(*this == o); }
+
+  private:
+    static constexpr A_long nearest(double x)
+    {
+        return x >= 0.0 ? static_cast<A_long>(x + 0.5) : -static_cast<A_long>(-x + 0.5);
+    }
+
+    A_Time m_frame;
+};
+
+} // namespace ae
+
+#endif // TIME_CONTEXT_HPP
@@ -14,6 +14,7 @@
 
 #include "AETK/AEGP/Core/Enums.hpp"
 #include "AETK/AEGP/Core/Exception.hpp"
+#include "AETK/AEGP/Core/Matrix.hpp"
 #include "AETK/AEGP/Core/Utility.hpp"
 #include "AETK/Common/Common.hpp"
 
@@ -1214,6 +1215,17 @@ class Matrix3
         }
     }
 
+    Matrix3(const ae::Mat3 &matrix3)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                mat[i][j] = matrix3(i, j);
+            }
+        }
+    }
+
     A_Matrix3 toAEGP()
     {
         A_Matrix3 matrix3;
@@ -1227,6 +1239,23 @@ class Matrix3
         return matrix3;
     }
 
+    /**
+     * @brief Fixed-size copy for arithmetic; does not allocate.
+     */
+    ae::Mat3 toMat() const
+    {
+        ae::Mat3 result;
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                result(i, j) = mat[i][j];
+            }
+        }
+        return result;
+    }
+
+    // Nested vectors for the Python bindings. Use toMat() from C++.
     tk::vector<tk::vector<double>> ToVector()
     {
         tk::vector<tk::vector<double>> result;
@@ -1270,6 +1299,17 @@ class Matrix4
         }
     }
 
+    Matrix4(const ae::Mat4 &matrix4)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                mat[i][j] = matrix4(i, j);
+            }
+        }
+    }
+
     A_Matrix4 toAEGP()
     {
         A_Matrix4 matrix4;
@@ -1283,6 +1323,23 @@ class Matrix4
         return matrix4;
     }
 
+    /**
+     * @brief Fixed-size copy for arithmetic; does not allocate.
+     */
+    ae::Mat4 toMat() const
+    {
+        ae::Mat4 result;
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                result(i, j) = mat[i][j];
+            }
+        }
+        return result;
+    }
+
+    // Nested vectors for the Python bindings. Use toMat() from C++.
     tk::vector<tk::vector<double>> ToVector()
     {
         tk::vector<tk::vector<double>> result;
@@ -1553,6 +1610,59 @@ class Marker
     MarkerValPtr m_markerP;
 };
 
+/**
+ * @brief A whole mask outline as flat arrays, one entry per vertex or feather.
+ *
+ * Tangents are relative to their vertex, as in AEGP_MaskVertex. For a closed
+ * outline the last vertex connects back to the first; it is not repeated.
+ */
+struct MaskOutlineData
+{
+    bool open = false;
+
+    tk::vector<double> x;
+    tk::vector<double> y;
+    tk::vector<double> inX;
+    tk::vector<double> inY;
+    tk::vector<double> outX;
+    tk::vector<double> outY;
+
+    tk::vector<int> featherSegment;
+    tk::vector<double> featherSegmentT; // 0-1 along the segment
+    tk::vector<double> featherRadius;
+    tk::vector<float> featherCornerAngle;
+    tk::vector<float> featherTension;
+    tk::vector<MaskFeatherInterp> featherInterp;
+    tk::vector<MaskFeatherType> featherType;
+
+    size_t numVertices() const { return x.size(); }
+    size_t numFeathers() const { return featherSegment.size(); }
+
+    void resize(size_t vertices, size_t feathers)
+    {
+        x.resize(vertices);
+        y.resize(vertices);
+        inX.resize(vertices);
+        inY.resize(vertices);
+        outX.resize(vertices);
+        outY.resize(vertices);
+        featherSegment.resize(feathers);
+        featherSegmentT.resize(feathers);
+        featherRadius.resize(feathers);
+        featherCornerAngle.resize(feathers);
+        featherTension.resize(feathers);
+        featherInterp.resize(feathers, MaskFeatherInterp::NORMAL);
+        featherType.resize(feathers, MaskFeatherType::OUTER);
+    }
+
+    MaskVertex vertex(size_t i) const { return MaskVertex(x[i], y[i], inX[i], inY[i], outX[i], outY[i]); }
+    MaskFeather feather(size_t i) const
+    {
+        return MaskFeather(featherSegment[i], featherSegmentT[i], featherRadius[i], featherCornerAngle[i],
+                           featherTension[i], featherInterp[i], featherType[i]);
+    }
+};
+
 /**
  * @class MaskOutline
  * @brief Represents a mask outline in After Effects.
@@ -1567,8 +1677,30 @@ class MaskOutline
   public:
     MaskOutline() = default;
     MaskOutline(MaskOutlineValPtr mask_outlineP) : m_mask_outlineP(mask_outlineP){};
+    /**
+     * @brief Wraps the outline held by a stream value, keeping the value alive.
+     */
+    MaskOutline(MaskOutlineValPtr mask_outlineP, StreamValue2Ptr owner)
+        : m_mask_outlineP(mask_outlineP), m_owner(owner){};
     ~MaskOutline() = default;
 
+    /**
+     * @brief Reads every vertex and feather in one main-thread task.
+     */
+    MaskOutlineData readAll() const;
+
+    /**
+     * @brief Replaces every vertex and feather, and the open state, in one main-thread task.
+     * Vertices are created or deleted at the end to match data.
+     */
+    void writeAll(const MaskOutlineData &data);
+
+    /**
+     * @brief readAll/writeAll on a raw handle, for callers already on the main thread.
+     */
+    static MaskOutlineData readUnscheduled(AEGP_MaskOutlineValH outlineH);
+    static void writeUnscheduled(AEGP_MaskOutlineValH outlineH, const MaskOutlineData &data);
+
     /**
      * @brief Checks if the mask outline is open.
      *
@@ -1673,6 +1805,7 @@ class MaskOutline
 
   private:
     MaskOutlineValPtr m_mask_outlineP;
+    StreamValue2Ptr m_owner; // Stream value the outline belongs to, if any
 };
 
 /**
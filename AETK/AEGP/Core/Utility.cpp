@@ -1,5 +1,8 @@
 #include "Utility.hpp"
 #include "Types.hpp"
+#include "Suites.hpp"
+#include "RationalTime.hpp"
+#include "TimeContext.hpp"
 #include "AETK/AEGP/Util/TaskScheduler.hpp"
 
 double TimeToSeconds(const A_Time &time)
@@ -12,42 +15,72 @@ double TimeToSeconds(const A_Time &time)
 
     // Scale the rounded value back down
     return rounded / 100.0;
-} // Will find active comp and convert using frame rate
+}
 
-A_Time SecondsToTime(double seconds)
+namespace
+{
+
+// Frame duration of the most recently used comp. Main thread only.
+A_Time mostRecentFrameDuration()
+{
+    auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+    AEGP_CompH comp = nullptr;
+    A_Time frameDuration{0, 1};
+    AE_CHECK(suites.CompSuite11()->AEGP_GetMostRecentlyUsedComp(&comp));
+    CheckNotNull(comp, "Error Converting Time. No Comp Available");
+    AE_CHECK(suites.CompSuite11()->AEGP_GetCompFrameDuration(comp, &frameDuration));
+    return frameDuration;
+}
+
+} // namespace
+
+ae::TimeContext ae::TimeContext::fromComp(CompPtr comp)
 {
-    auto future = ae::ScheduleOrExecute([seconds]() {
-        AEGP_CompH comp;
-        double frameRate;
-        SuiteManager::GetInstance().GetSuiteHandler().CompSuite11()->AEGP_GetMostRecentlyUsedComp(&comp);
-        SuiteManager::GetInstance().GetSuiteHandler().CompSuite11()->AEGP_GetCompFramerate(comp, &frameRate);
-        A_u_long scale = static_cast<A_u_long>(frameRate);
-        return A_Time{static_cast<A_long>(std::round(seconds * scale)), scale};
+    auto future = ae::ScheduleOrExecute([comp]() {
+        CheckNotNull(comp.get(), "Error Getting Time Context. Comp is Null");
+        A_Time frameDuration{0, 1};
+        AE_CHECK(SuiteManager::GetInstance().GetSuiteHandler().CompSuite11()->AEGP_GetCompFrameDuration(
+            *comp, &frameDuration));
+        return frameDuration;
     });
-    return future.get();
+    return TimeContext(future.get());
 }
 
-int TimeToFrames(const A_Time &time)
+ae::TimeContext ae::TimeContext::mostRecent()
+{
+    auto future = ae::ScheduleOrExecute([]() { return mostRecentFrameDuration(); });
+    return TimeContext(future.get());
+}
+
+ae::LayerTimeMap ae::LayerTimeMap::fromLayer(LayerPtr layer)
 {
-    auto future = ae::ScheduleOrExecute([time]() {
-        AEGP_CompH comp;
-        double frameRate;
-        SuiteManager::GetInstance().GetSuiteHandler().CompSuite11()->AEGP_GetMostRecentlyUsedComp(&comp);
-        SuiteManager::GetInstance().GetSuiteHandler().CompSuite11()->AEGP_GetCompFramerate(comp, &frameRate);
-        return static_cast<int>(std::round(TimeToSeconds(time) * frameRate));
+    auto future = ae::ScheduleOrExecute([layer]() {
+        CheckNotNull(layer.get(), "Error Getting Layer Time Map. Layer is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        A_Time offset{0, 1};
+        A_Ratio stretch{1, 1};
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerOffset(*layer, &offset));
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerStretch(*layer, &stretch));
+        return std::make_pair(offset, stretch);
     });
-    return future.get();
+    auto [offset, stretch] = future.get();
+    return LayerTimeMap(RationalTime(offset), RationalTime::fromRatio(stretch));
+}
+
+// The functions below look up the most recently used comp on every call. Prefer
+// a TimeContext when converting more than once.
+
+A_Time SecondsToTime(double seconds)
+{
+    return ae::TimeContext::mostRecent().toTime(seconds);
+}
+
+int TimeToFrames(const A_Time &time)
+{
+    return ae::TimeContext::mostRecent().toFrames(time);
 }
 
 A_Time FramesToTime(int frames)
 {
-    auto future = ae::ScheduleOrExecute([frames]() {
-        AEGP_CompH comp;
-        double frameRate;
-        SuiteManager::GetInstance().GetSuiteHandler().CompSuite11()->AEGP_GetMostRecentlyUsedComp(&comp);
-        SuiteManager::GetInstance().GetSuiteHandler().CompSuite11()->AEGP_GetCompFramerate(comp, &frameRate);
-        A_u_long scale = static_cast<A_u_long>(frameRate);
-        return A_Time{frames, scale};
-    });
-    return future.get();
-}
\ No newline at end of file
+    return ae::TimeContext::mostRecent().framesToTime(frames);
+}
@@ -29,6 +29,9 @@ class FootageItem;
 class ItemCollection;
 class Layer;
 class LayerCollection;
+class LayerRange;
+class MarkerProperty;
+class ProjectIndex;
 
 /**
  * Item class is a wrapper for AEGP_ItemH, and its associated functions
@@ -45,6 +48,8 @@ class Item
     ItemPtr getItem() const { return m_item; }
     void setItem(ItemPtr item) { m_item = item; }
 
+    A_long id(); // Unique within the project. Cached after the first call
+
     virtual ItemType itemType() { return ItemType::NONE; }
     std::string typeName(); // Returns the type of the item as a string
 
@@ -88,6 +93,11 @@ class Item
 
   protected:
     ItemPtr m_item;
+    std::optional<A_long> m_id;
+    // Guards m_id. Wrappers from IdentityMap are shared between threads; never held across a task.
+    std::shared_ptr<std::mutex> m_cacheMutex = std::make_shared<std::mutex>();
+
+    friend class IdentityMap;
 };
 
 class FolderItem : public Item
@@ -102,6 +112,84 @@ class FolderItem : public Item
 
     private:
         tk::shared_ptr<ItemCollection> m_children;
+        tk::shared_ptr<const ProjectIndex> m_index; // Snapshot m_children was built from
+};
+
+/**
+ * @brief One layer for CompItem::addLayers.
+ *
+ * Optional fields are left at AE's defaults when unset. Times are comp times
+ * in seconds; transform values are in the units of the Transform group
+ * (scale and opacity in percent, rotation in degrees).
+ */
+struct LayerSpec
+{
+    enum class Kind
+    {
+        Source, // A layer of an existing comp or footage item
+        Solid,
+        Null,
+        Camera,
+        Light
+    };
+
+    Kind kind = Kind::Source;
+    ItemPtr source;             // Kind::Source
+    ColorVal color{1, 1, 1, 1}; // Kind::Solid
+    int width = 0;              // Kind::Solid, 0 uses the comp size
+    int height = 0;
+
+    std::string name; // Empty keeps the name AE gives the layer
+    std::optional<double> inPoint;
+    std::optional<double> outPoint;
+    int parent = -1; // Index of another spec in the same addLayers call
+    bool threeD = false;
+    std::optional<Label> label;
+
+    std::optional<ThreeDVal> anchorPoint;
+    std::optional<ThreeDVal> position;
+    std::optional<ThreeDVal> scale;
+    std::optional<double> rotation; // Z rotation
+    std::optional<double> opacity;
+
+    static LayerSpec fromItem(ItemPtr item, const std::string &name = "")
+    {
+        LayerSpec spec;
+        spec.source = item;
+        spec.name = name;
+        return spec;
+    }
+    static LayerSpec solid(const std::string &name, ColorVal color, int width = 0, int height = 0)
+    {
+        LayerSpec spec;
+        spec.kind = Kind::Solid;
+        spec.name = name;
+        spec.color = color;
+        spec.width = width;
+        spec.height = height;
+        return spec;
+    }
+    static LayerSpec null(const std::string &name)
+    {
+        LayerSpec spec;
+        spec.kind = Kind::Null;
+        spec.name = name;
+        return spec;
+    }
+    static LayerSpec camera(const std::string &name)
+    {
+        LayerSpec spec;
+        spec.kind = Kind::Camera;
+        spec.name = name;
+        return spec;
+    }
+    static LayerSpec light(const std::string &name)
+    {
+        LayerSpec spec;
+        spec.kind = Kind::Light;
+        spec.name = name;
+        return spec;
+    }
 };
 
 class CompItem : public Item
@@ -122,6 +210,22 @@ class CompItem : public Item
     void setFlag(CompFlag flag, bool value); // Sets the flag
 
     tk::shared_ptr<LayerCollection> layers();
+    LayerRange layerRange(size_t chunkSize = 64); // Lazily fetched layers, see LayerRange
+
+    tk::shared_ptr<MarkerProperty> markers(); // The comp's own marker stream
+
+    /**
+     * @brief Creates and sets up every spec in one task and one undo group.
+     *
+     * specs are listed top to bottom and end up above the existing layers. All
+     * sources are validated before anything is created. Returns the new layers
+     * in spec order.
+     */
+    tk::vector<tk::shared_ptr<Layer>> addLayers(const LayerSpec *specs, size_t count);
+    tk::vector<tk::shared_ptr<Layer>> addLayers(const tk::vector<LayerSpec> &specs)
+    {
+        return addLayers(specs.data(), specs.size());
+    }
 
     DownsampleFactor downsampleFactor();            // Returns the downsample factor
     void setDownsampleFactor(DownsampleFactor dsf); // Sets the downsample factor
@@ -28,7 +28,12 @@ class CompItem;
 class Layer : public PropertyGroup
 {
   public:
-    Layer(LayerPtr layer) : m_layer(layer), PropertyGroup(DynamicStreamSuite().GetNewStreamRefForLayer(layer)) {}
+    // The layer's stream ref is only acquired once a property is accessed, so
+    // wrappers made while enumerating a comp cost nothing until they are used.
+    Layer(LayerPtr layer) : PropertyGroup(), m_layer(layer)
+    {
+        m_resolveStream = [layer]() { return DynamicStreamSuite().GetNewStreamRefForLayer(layer); };
+    }
 
     virtual ~Layer() = default;
 
@@ -39,6 +44,8 @@ class Layer : public PropertyGroup
     LayerPtr getLayer() const { return m_layer; }
     void setLayer(LayerPtr layer) { m_layer = layer; }
 
+    AEGP_LayerIDVal id(); // Unique within the parent comp. Cached after the first call
+
     std::string getName();
     std::string getMatchName();
     void setName(const std::string &name);
@@ -68,6 +75,9 @@ class Layer : public PropertyGroup
     double stretch();
     void setStretch(double stretch);
 
+    // Offset and stretch, read in one task, for converting comp time to layer time and back without AE.
+    ae::LayerTimeMap timeMap();
+
     bool isFlagSet(LayerFlag flag);
     void setFlag(LayerFlag flag, bool value);
 
@@ -87,6 +97,8 @@ class Layer : public PropertyGroup
     int numEffects();
     // Properties
     tk::shared_ptr<BaseProperty> getProperty(LayerStream stream);
+    // Match-name path below the layer, e.g. "ADBE Transform Group/ADBE Position". Cached per layer.
+    tk::shared_ptr<BaseProperty> property(const std::string &path);
 
     // Property ShortCuts
     tk::shared_ptr<ThreeDProperty> AnchorPoint();
@@ -102,6 +114,13 @@ class Layer : public PropertyGroup
 
   protected:
     LayerPtr m_layer;
+    std::shared_ptr<PropertyPathCache> m_pathCache; // Created on first property(path) call
+    std::optional<AEGP_LayerIDVal> m_id;
+    std::weak_ptr<CompItem> m_parentComp; // Weak: the comp's LayerCollection owns its layers
+    // Guards the three caches above. Wrappers from IdentityMap are shared between threads; never held across a task.
+    std::shared_ptr<std::mutex> m_cacheMutex = std::make_shared<std::mutex>();
+
+    friend class IdentityMap;
 };
 
 class AVLayer : public Layer
@@ -181,6 +200,30 @@ class LightLayer : public Layer
     tk::shared_ptr<OneDProperty> LightFalloffDistance();
 };
 
+/**
+ * @brief Every glyph path of a text layer at one time, as flat arrays.
+ *
+ * Path p owns vertices [offsets[p], offsets[p + 1]). Positions are in layer
+ * space and tangents are relative to their vertex, as in PF_PathVertex. A
+ * closed path connects its last vertex back to its first.
+ */
+struct TextOutlineData
+{
+    tk::vector<double> x;
+    tk::vector<double> y;
+    tk::vector<double> inX;
+    tk::vector<double> inY;
+    tk::vector<double> outX;
+    tk::vector<double> outY;
+
+    tk::vector<size_t> offsets{0}; // numPaths() + 1 entries
+    tk::vector<char> closed;
+
+    size_t numPaths() const { return closed.size(); }
+    size_t numVertices() const { return x.size(); }
+    size_t pathSize(size_t p) const { return offsets[p + 1] - offsets[p]; }
+};
+
 class TextLayer : public Layer
 {
   public:
@@ -189,6 +232,16 @@ class TextLayer : public Layer
     virtual ~TextLayer() = default;
 
     ObjectType getObjectType() const override { return ObjectType::TEXT; }
+
+    /**
+     * @brief Glyph paths at a layer time in seconds, read in one main-thread task.
+     */
+    TextOutlineData outlines(double time) const;
+
+    /**
+     * @brief Glyph paths at each of times (layer seconds), all read in one main-thread task.
+     */
+    tk::vector<TextOutlineData> outlines(const tk::vector<double> &times) const;
 };
 
 class VectorLayer : public Layer
@@ -22,6 +22,7 @@
 
 
 class ItemCollection;
+class ProjectIndex;
 /**
  * @brief A class representing an After Effects Project
  *
@@ -148,6 +149,7 @@ class Project
      */
     inline ProjectPtr init();
     tk::shared_ptr<ItemCollection> m_itemCollection;
+    tk::shared_ptr<const ProjectIndex> m_index; // Snapshot m_itemCollection was built from
 };
 
 #endif // PROJECT_HPP
\ No newline at end of file
@@ -18,6 +18,7 @@ class Item;
 class CompItem;
 class FootageItem;
 class FolderItem;
+class ProjectIndex;
 /**
  * @brief A class representing a collection of items
  * *
@@ -35,6 +36,11 @@ class ItemCollection : public Collection<tk::shared_ptr<Item>>
   public:
     ItemCollection() = default;
     ItemCollection(tk::shared_ptr<Item> FolderItem) : baseItem(FolderItem) { createCollection(); }
+    ItemCollection(tk::shared_ptr<Item> FolderItem, const tk::shared_ptr<const ProjectIndex> &index)
+        : baseItem(FolderItem)
+    {
+        createCollection(index);
+    }
     ItemCollection(tk::vector<tk::shared_ptr<Item>> items) : Collection(items) {}
     ~ItemCollection() = default;
 
@@ -62,6 +68,11 @@ class ItemCollection : public Collection<tk::shared_ptr<Item>>
 
     void createCollection();
 
+    /**
+     * \brief Fill the collection with the children of baseItem listed in index.
+     */
+    void createCollection(const tk::shared_ptr<const ProjectIndex> &index);
+
     tk::vector<tk::shared_ptr<Item>> find(const std::function<bool(tk::shared_ptr<Item>)> &predicate);
 
   private:
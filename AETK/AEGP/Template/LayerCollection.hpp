@@ -15,6 +15,80 @@
 class CompItem;
 class Layer;
 class Item;
+
+/**
+ * @brief Layers of a comp, fetched on demand in chunks.
+ *
+ * Layer handles and object types are read chunkSize at a time, each chunk in a
+ * single main-thread task, and only when iteration reaches it. The Layer
+ * wrappers do not acquire stream refs until a property is accessed, so
+ * stopping early (find(), break) skips the cost of the remaining layers.
+ *
+ * The layer count is read with the first chunk; the range does not notice
+ * layers added or removed after that.
+ *
+ * @example
+ * auto layer = comp.layerRange().find([](auto l) { return l->getName() == "Camera"; });
+ */
+class LayerRange
+{
+  public:
+    class iterator
+    {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = tk::shared_ptr<Layer>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type *;
+        using reference = value_type;
+
+        iterator(LayerRange *range, size_t index) : m_range(range), m_index(index) {}
+
+        value_type operator*() const { return m_range->at(m_index); }
+        iterator &operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            iterator previous = *this;
+            ++m_index;
+            return previous;
+        }
+        bool operator==(const iterator &other) const { return m_index == other.m_index; }
+        bool operator!=(const iterator &other) const { return m_index != other.m_index; }
+
+      private:
+        LayerRange *m_range;
+        size_t m_index;
+    };
+
+    LayerRange(CompPtr comp, size_t chunkSize = 64) : m_comp(comp), m_chunkSize(chunkSize ? chunkSize : 1) {}
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size()); }
+
+    size_t size();
+    tk::shared_ptr<Layer> at(size_t index);
+
+    /**
+     * \brief The first layer matching predicate, or nullptr. Stops fetching at the match.
+     */
+    tk::shared_ptr<Layer> find(const std::function<bool(tk::shared_ptr<Layer>)> &predicate);
+
+    size_t fetchedCount() const { return m_fetched; }
+
+  private:
+    void fetch(size_t index);
+
+    CompPtr m_comp;
+    size_t m_chunkSize;
+    bool m_counted = false;
+    size_t m_fetched = 0;
+    tk::vector<tk::shared_ptr<Layer>> m_layers;
+};
+
 /**
  * @brief A class representing a collection of Layers
  * *
@@ -73,16 +147,41 @@ class LayerCollection : public Collection<tk::shared_ptr<Layer>>
     tk::vector<tk::shared_ptr<Layer>> slice(int start) override;
     tk::vector<tk::shared_ptr<Layer>> slice() override { return m_collection; }
 
+    /**
+     * \brief Reverse the layer order in the comp. Issues at most size() - 1 reorders.
+     */
     void reverse() override;
 
+    /**
+     * \brief Stable sort of the layers in the comp, index 0 (top) first.
+     *
+     * The target order is computed in memory and applied with the fewest
+     * ReorderLayer calls: layers already in relative order stay put. All moves
+     * run in one main-thread task inside one undo group.
+     */
     void sort(std::function<bool(tk::shared_ptr<Layer>, tk::shared_ptr<Layer>)> compare);
 
+    /**
+     * \brief Number of ReorderLayer calls made by the last sort() or reverse().
+     */
+    size_t lastReorderCount() const { return m_lastReorderCount; }
+
     void createCollection();
 
     tk::vector<tk::shared_ptr<Layer>> find(const std::function<bool(tk::shared_ptr<Layer>)> &predicate);
 
+    /**
+     * \brief The first layer matching predicate, or nullptr.
+     */
+    tk::shared_ptr<Layer> findFirst(const std::function<bool(tk::shared_ptr<Layer>)> &predicate);
+
   protected:
     CompPtr baseComp;
+
+  private:
+    void reorder(const tk::vector<tk::shared_ptr<Layer>> &target, const std::string &undoName);
+
+    size_t m_lastReorderCount = 0;
 };
 
 #endif // LAYERCOLLECTION_HPP
@@ -0,0 +1,92 @@
+/*****************************************************************/ /**
+                                                                     * \file   AtomTable.hpp
+                                                                     * \brief  Process-wide string interning, used for
+                                                                     *match names and property paths.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef ATOM_TABLE_HPP
+#define ATOM_TABLE_HPP
+
+#include "AETK/Common/Common.hpp"
+#include <deque>
+
+namespace ae
+{
+
+using Atom = int;
+constexpr Atom InvalidAtom = -1;
+
+/**
+ * @class AtomTable
+ * @brief Maps strings to small integer ids so they can be compared and hashed cheaply.
+ *
+ * Atoms are never released, which keeps the strings they refer to valid for the
+ * lifetime of the plugin. Safe to use from any thread.
+ */
+class AtomTable
+{
+  public:
+    static AtomTable &GetInstance()
+    {
+        static AtomTable instance;
+        return instance;
+    }
+
+    /**
+     * @brief Returns the atom for str, adding it if it has not been seen before.
+     */
+    Atom intern(const std::string &str)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_ids.find(str);
+        if (it != m_ids.end())
+        {
+            return it->second;
+        }
+        Atom id = static_cast<Atom>(m_strings.size());
+        m_strings.push_back(str);
+        m_ids.emplace(str, id);
+        return id;
+    }
+
+    /**
+     * @brief Returns the atom for str, or InvalidAtom if it was never interned.
+     */
+    Atom find(const std::string &str) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_ids.find(str);
+        return it != m_ids.end() ? it->second : InvalidAtom;
+    }
+
+    /**
+     * @brief Returns the string an atom was created from.
+     */
+    const std::string &str(Atom atom) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (atom < 0 || static_cast<size_t>(atom) >= m_strings.size())
+        {
+            throw std::out_of_range("Invalid atom");
+        }
+        return m_strings[atom]; // std::deque never moves existing elements
+    }
+
+  private:
+    AtomTable() = default;
+
+    mutable std::mutex m_mutex;
+    std::deque<std::string> m_strings;
+    std::unordered_map<std::string, Atom> m_ids;
+};
+
+inline Atom intern(const std::string &str)
+{
+    return AtomTable::GetInstance().intern(str);
+}
+
+} // namespace ae
+
+#endif // ATOM_TABLE_HPP
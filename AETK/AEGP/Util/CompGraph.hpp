@@ -0,0 +1,157 @@
+/*****************************************************************/ /**
+                                                                     * \file   CompGraph.hpp
+                                                                     * \brief  Dependency graph between the comps and
+                                                                     *footage of a project.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef COMP_GRAPH_HPP
+#define COMP_GRAPH_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+#include "AETK/AEGP/Util/ProjectIndex.hpp"
+
+/**
+ * @class CompGraph
+ * @brief Which comps and footage each comp depends on, through its layers.
+ *
+ * Nodes are the comp and footage items of a ProjectIndex; folders are left out.
+ * Every layer of every comp is read once, inside a single main-thread task,
+ * recording its source item, parent and track matte. A comp depends on the
+ * source items of its layers.
+ *
+ * Edges, dependents, topological order and levels are derived together in one
+ * pass after every build or update. AE does not allow precomp cycles, but the
+ * graph may be stale, so ordering is cycle-safe: nodes on a cycle are placed
+ * after everything else and listed by cyclic().
+ *
+ * Track mattes come from AEGP_GetTrackMatteLayer, so a matte anywhere in the
+ * layer stack is recorded by its own layer ID.
+ *
+ * Queries are const and may run on any thread. build, update and sync are not
+ * thread-safe.
+ *
+ * @example
+ * CompGraph graph(ProjectIndex::current(ProjSuite().GetProjectByIndex(0)));
+ * for (const auto &level : graph.levels())
+ *     renderInParallel(level); // each level only uses items from earlier levels
+ */
+class CompGraph
+{
+  public:
+    /**
+     * @brief What a layer points at. IDs are 0 when there is nothing.
+     */
+    struct LayerEdges
+    {
+        AEGP_LayerIDVal layer = 0;
+        A_long source = 0; // Item ID of the layer's source
+        AEGP_LayerIDVal parent = 0;
+        AEGP_LayerIDVal trackMatte = 0;
+        TrackMatte matteMode = TrackMatte::NO_TRACK_MATTE;
+    };
+
+    CompGraph() = default;
+    explicit CompGraph(const tk::shared_ptr<const ProjectIndex> &index) { build(index); }
+
+    /**
+     * @brief Reads the layers of every comp in index, in one task.
+     */
+    void build(const tk::shared_ptr<const ProjectIndex> &index);
+
+    /**
+     * @brief Re-reads the layers of one comp after it was edited.
+     */
+    void update(A_long compID);
+
+    /**
+     * @brief Matches the node set to a newer index. Layers are only read for comps
+     * that were not in the graph; call update() for comps that were edited.
+     */
+    void sync(const tk::shared_ptr<const ProjectIndex> &index);
+
+    int size() const { return static_cast<int>(m_ids.size()); }
+    A_long id(int n) const { return m_ids.at(n); }
+    ItemType type(int n) const { return m_types.at(n); }
+    AEGP_ItemH handle(int n) const { return m_handles.at(n); }
+
+    /**
+     * @brief Node of an item ID, or -1.
+     */
+    int find(A_long id) const;
+
+    /**
+     * @brief Layers of a comp node, top to bottom. Empty for footage.
+     */
+    const tk::vector<LayerEdges> &layers(int n) const { return m_layers.at(n); }
+
+    /**
+     * @brief Nodes used as layer sources by n, without duplicates.
+     */
+    const tk::vector<int> &dependencies(int n) const { return m_dependencies.at(n); }
+
+    /**
+     * @brief Comps with a layer whose source is n.
+     */
+    const tk::vector<int> &dependents(int n) const { return m_dependents.at(n); }
+
+    /**
+     * @brief Every node, each after all of its dependencies.
+     */
+    const tk::vector<int> &topologicalOrder() const { return m_order; }
+
+    /**
+     * @brief Nodes grouped so that each level only depends on earlier ones.
+     * Nodes in one level can be processed in parallel. Cyclic nodes are not included.
+     */
+    const tk::vector<tk::vector<int>> &levels() const { return m_levels; }
+
+    /**
+     * @brief Nodes on or behind a dependency cycle.
+     */
+    const tk::vector<int> &cyclic() const { return m_cyclic; }
+    bool hasCycles() const { return !m_cyclic.empty(); }
+
+    /**
+     * @brief True if from depends on to, directly or through precomps.
+     */
+    bool reaches(int from, int to) const;
+
+    /**
+     * @brief Everything from depends on, directly or through precomps. Excludes from.
+     */
+    tk::vector<int> reachable(int from) const;
+
+    /**
+     * @brief Nodes not reachable from any of roots (roots themselves are used).
+     */
+    tk::vector<int> unused(const tk::vector<int> &roots) const;
+
+    /**
+     * @brief Footage that no comp uses as a layer source. Equivalent to unused() with every comp as a root.
+     */
+    tk::vector<int> unused() const;
+
+    tk::shared_ptr<const ProjectIndex> index() const { return m_index; }
+
+  private:
+    // Rebuilds edges, dependents, order, levels and cycles from m_layers.
+    void link();
+
+    tk::shared_ptr<const ProjectIndex> m_index;
+
+    tk::vector<A_long> m_ids;
+    tk::vector<ItemType> m_types;
+    tk::vector<AEGP_ItemH> m_handles;
+    tk::vector<tk::vector<LayerEdges>> m_layers;
+    std::unordered_map<A_long, int> m_byID;
+
+    tk::vector<tk::vector<int>> m_dependencies;
+    tk::vector<tk::vector<int>> m_dependents;
+    tk::vector<int> m_order;
+    tk::vector<tk::vector<int>> m_levels;
+    tk::vector<int> m_cyclic;
+};
+
+#endif // COMP_GRAPH_HPP
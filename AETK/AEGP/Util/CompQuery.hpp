@@ -0,0 +1,93 @@
+/*****************************************************************/ /**
+                                                                     * \file   CompQuery.hpp
+                                                                     * \brief  Reads the same layer streams for every
+                                                                     *layer of a comp in one main-thread task.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef COMP_QUERY_HPP
+#define COMP_QUERY_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+#include "AETK/AEGP/Util/Keyframe.hpp"
+
+/**
+ * @brief Result of CompQuery::values, one row per layer and one column per stream.
+ *
+ * Cells are stored row-major. A cell is std::monostate when the stream is not
+ * legal for that layer (e.g. ZOOM on a footage layer) or has no numeric value
+ * (MARKER, SOURCE_TEXT).
+ */
+struct StreamTable
+{
+    using Value = KeyFrame::TangentValue;
+
+    tk::vector<LayerPtr> layers;         // In comp order, index 0 is the top layer
+    tk::vector<AEGP_LayerIDVal> layerIDs; // Stable across reorders, unlike the row index
+    tk::vector<LayerStream> streams;
+    tk::vector<Value> cells;
+
+    size_t rows() const { return layers.size(); }
+    size_t columns() const { return streams.size(); }
+
+    const Value &at(size_t row, size_t column) const { return cells.at(row * streams.size() + column); }
+
+    /**
+     * @brief Typed access, e.g. table.get<TwoDVal>(row, 0). Throws std::bad_variant_access
+     * if the cell holds a different type.
+     */
+    template <typename T> const T &get(size_t row, size_t column) const { return std::get<T>(at(row, column)); }
+
+    bool has(size_t row, size_t column) const { return !std::holds_alternative<std::monostate>(at(row, column)); }
+
+    /**
+     * @brief Column index of stream, or -1 if it was not queried.
+     */
+    int column(LayerStream stream) const
+    {
+        auto it = std::find(streams.begin(), streams.end(), stream);
+        return it == streams.end() ? -1 : static_cast<int>(it - streams.begin());
+    }
+};
+
+/**
+ * @class CompQuery
+ * @brief Bulk reads of layer stream values across a comp.
+ *
+ * Reading Position(), Scale(), Rotation() etc. through the Layer wrappers costs a
+ * stream ref, a value handle and several marshalled calls per layer per stream.
+ * values() enumerates the comp's layers and reads every requested stream with
+ * AEGP_GetLayerStreamValue inside a single task, so a frame of a whole comp is
+ * one round trip to the main thread. Times in seconds are snapped to this
+ * comp's frame grid inside the same task.
+ *
+ * @example
+ * CompQuery query(comp.getComp());
+ * auto table = query.values(comp.currentTime(), {LayerStream::POSITION, LayerStream::SCALE,
+ *                                                LayerStream::ROTATION, LayerStream::OPACITY});
+ * for (size_t row = 0; row < table.rows(); ++row)
+ *     send(table.layerIDs[row], table.get<ThreeDVal>(row, 0));
+ */
+class CompQuery
+{
+  public:
+    CompQuery(CompPtr comp) : m_comp(comp) {}
+
+    /**
+     * @brief Values of streams for every layer at a comp time in seconds, rounded to this comp's nearest frame.
+     */
+    StreamTable values(double time, const tk::vector<LayerStream> &streams, bool preExpression = false) const;
+
+    /**
+     * @brief Values of streams for every layer at a comp time.
+     */
+    StreamTable values(Time time, const tk::vector<LayerStream> &streams, bool preExpression = false) const;
+
+    CompPtr comp() const { return m_comp; }
+
+  private:
+    CompPtr m_comp;
+};
+
+#endif // COMP_QUERY_HPP
@@ -0,0 +1,109 @@
+/*****************************************************************/ /**
+                                                                     * \file   CurveFitter.hpp
+                                                                     * \brief  Reduces densely baked animation to a
+                                                                     *minimal set of keyframes within an error bound.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef CURVE_FITTER_HPP
+#define CURVE_FITTER_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+#include "AETK/AEGP/Util/KeyframeDiff.hpp"
+
+namespace ae
+{
+
+/**
+ * @brief Dense samples of one stream, e.g. one value per frame.
+ *
+ * values is interleaved, holding dimensions() doubles per entry in times.
+ * Colors are stored as red, green, blue, alpha. stream is optional and only
+ * carried through to the KeyframeTrack returned by CurveFitter::fitTracks.
+ */
+struct CurveSamples
+{
+    StreamType type = StreamType::OneD;
+    tk::vector<double> times;
+    tk::vector<double> values;
+    StreamRefPtr stream;
+
+    int dimensions() const;
+    bool spatial() const { return type == StreamType::TwoD_SPATIAL || type == StreamType::ThreeD_SPATIAL; }
+    size_t size() const { return times.size(); }
+};
+
+enum class CurveFitMode
+{
+    Bezier, // Cubic segments with temporal ease (and spatial tangents for spatial streams)
+    Linear  // Ramer-Douglas-Peucker with linear interpolation
+};
+
+struct CurveFitOptions
+{
+    double tolerance = 0.5; // Max distance between a sample and the fitted curve, in stream units
+    CurveFitMode mode = CurveFitMode::Bezier;
+    unsigned int maxThreads = 0; // 0 uses std::thread::hardware_concurrency()
+};
+
+struct CurveFitResult
+{
+    tk::vector<KeyFrame> keys;
+    size_t numSamples = 0;
+    double maxError = 0.0;   // Largest deviation of any sample from the fitted curve
+    double fitSeconds = 0.0; // Wall time spent fitting this curve
+
+    double compressionRatio() const { return keys.empty() ? 0.0 : double(numSamples) / double(keys.size()); }
+};
+
+/**
+ * @class CurveFitter
+ * @brief Turns baked per-frame samples into a small set of bezier keys.
+ *
+ * Keys are chosen by recursive subdivision: a segment is fitted with a cubic
+ * whose end slopes come from the samples, and split at the worst sample until
+ * every sample lies within the tolerance. Each key gets a matching in/out
+ * KeyframeEase (speed = slope, 33.3% influence), and spatial streams also get
+ * spatial tangents, so the keys written by AE reproduce the fitted cubic.
+ *
+ * AE keys are shared by all dimensions of a stream, so dimensions are fitted
+ * together. Non-spatial streams with more than one dimension (scale, color)
+ * only have one KeyframeEase per key in KeyFrame, so they fall back to Linear
+ * mode. Separate dimensions into their own streams to fit them independently.
+ *
+ * @example
+ * ae::CurveFitter fitter({0.1});
+ * auto tracks = fitter.fitTracks(bakedSamples);
+ * KeyframeDiff::sync(tracks);
+ */
+class CurveFitter
+{
+  public:
+    CurveFitter(CurveFitOptions options = {}) : m_options(options) {}
+
+    /**
+     * @brief Fit one curve.
+     */
+    CurveFitResult fit(const CurveSamples &samples) const;
+
+    /**
+     * @brief Fit many curves in parallel. Results are in input order.
+     */
+    tk::vector<CurveFitResult> fit(const tk::vector<CurveSamples> &curves) const;
+
+    /**
+     * @brief Fit many curves in parallel and pair the keys with their streams,
+     * ready for KeyframeDiff::sync.
+     */
+    tk::vector<KeyframeTrack> fitTracks(const tk::vector<CurveSamples> &curves) const;
+
+    const CurveFitOptions &options() const { return m_options; }
+
+  private:
+    CurveFitOptions m_options;
+};
+
+} // namespace ae
+
+#endif // CURVE_FITTER_HPP
@@ -0,0 +1,86 @@
+/*****************************************************************/ /**
+                                                                     * \file   EffectRegistry.hpp
+                                                                     * \brief  Installed effects, enumerated once and
+                                                                     *looked up by match name.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef EFFECT_REGISTRY_HPP
+#define EFFECT_REGISTRY_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+
+class Effect;
+class Layer;
+
+struct InstalledEffect
+{
+    AEGP_InstalledEffectKey key = AEGP_InstalledEffectKey_NONE;
+    std::string name;
+    std::string matchName;
+    std::string category;
+};
+
+/**
+ * @class EffectRegistry
+ * @brief Match name -> installed effect key and category.
+ *
+ * Finding an effect through the effect suite means stepping through every
+ * installed effect with GetNextInstalledEffect and GetEffectMatchName, one
+ * marshalled call each. The registry walks the list once inside a single task
+ * and keeps it in a hash map. Every lookup first checks the installed-effect
+ * count (one call) and only enumerates again when it has changed.
+ *
+ * @example
+ * auto effects = EffectRegistry::GetInstance().applyMany(layers, "ADBE Gaussian Blur 2");
+ */
+class EffectRegistry
+{
+  public:
+    static EffectRegistry &GetInstance()
+    {
+        static EffectRegistry instance;
+        return instance;
+    }
+
+    /**
+     * @brief The installed effect with matchName, if any.
+     */
+    std::optional<InstalledEffect> find(const std::string &matchName);
+
+    /**
+     * @brief Every installed effect, in AE's enumeration order.
+     */
+    tk::vector<InstalledEffect> effects();
+
+    /**
+     * @brief Applies matchName to layer. Returns nullptr if it is not installed.
+     */
+    tk::shared_ptr<Effect> apply(const tk::shared_ptr<Layer> &layer, const std::string &matchName);
+
+    /**
+     * @brief Applies matchName to every layer in one task and one undo group.
+     * Returns the new effects in layer order, or an empty vector if it is not installed.
+     */
+    tk::vector<tk::shared_ptr<Effect>> applyMany(const tk::vector<tk::shared_ptr<Layer>> &layers,
+                                                 const std::string &matchName);
+
+    /**
+     * @brief Forces the next lookup to enumerate again.
+     */
+    void invalidate();
+
+  private:
+    EffectRegistry() = default;
+
+    // Re-enumerates if the installed-effect count changed. Never holds m_mutex across the task.
+    void refresh();
+
+    std::mutex m_mutex;
+    A_long m_count = -1;
+    tk::vector<InstalledEffect> m_effects;
+    std::unordered_map<std::string, size_t> m_byMatchName;
+};
+
+#endif // EFFECT_REGISTRY_HPP
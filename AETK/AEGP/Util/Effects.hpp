@@ -12,17 +12,45 @@
 
 class BaseProperty;
 class Layer;
+
+/**
+ * @brief One parameter stream of an applied effect.
+ */
+struct EffectParam
+{
+    int index = 0;
+    std::string name;      // Display name, in English
+    std::string matchName; // Stable across languages and versions
+    StreamGroupingType grouping = StreamGroupingType::NONE;
+    StreamType type = StreamType::NONE; // NONE for parameter groups
+    StreamRefPtr stream;
+};
+
+/**
+ * @brief Every parameter of an effect, looked up by index, name or match name.
+ */
+struct EffectParamIndex
+{
+    AEGP_InstalledEffectKey key = AEGP_InstalledEffectKey_NONE;
+    tk::vector<EffectParam> params;
+    std::unordered_map<std::string, int> byName;
+    std::unordered_map<std::string, int> byMatchName;
+
+    const EffectParam *find(const std::string &nameOrMatchName) const;
+};
+
 /**
  * @brief The Effect class represents an After Effects effect.
  *
+ * The parameters are discovered once, the first time any of them is asked for:
+ * one task reads the installed key and every parameter's name, match name,
+ * type and stream ref. Later param() calls are served from that index without
+ * calling into AE.
  */
 class Effect
 {
   public:
-    Effect() : m_effect(nullptr)
-    // m_key(m_effSuite.getInstalledKeyFromLayerEffect(m_effect))
-    {
-    }
+    Effect() : m_effect(nullptr) {}
     Effect(EffectRefPtr effect) : m_effect(effect){};
 
     ~Effect() = default;
@@ -32,15 +60,21 @@ class Effect
     std::string category();  // get the category of the effect
 
     tk::shared_ptr<BaseProperty> param(int index);               // get the parameter at the index
-    tk::shared_ptr<BaseProperty> param(const std::string &name); // get the parameter by name
+    tk::shared_ptr<BaseProperty> param(const std::string &name); // get the parameter by name or match name
+
+    const tk::vector<EffectParam> &params(); // every parameter, in index order
+    int numParams();
 
     void callGeneric(double time, PF_Cmd cmd, void *extra); // call the generic function of the effect
 
     tk::shared_ptr<Effect> duplicate(); // duplicate the effect
 
   private:
+    // The parameter index, built on first use and never replaced once published.
+    const EffectParamIndex &index();
+
     EffectRefPtr m_effect;
-    int m_key;
+    tk::shared_ptr<const EffectParamIndex> m_index;
 };
 
 #endif // EFFECTS_HPP
@@ -12,15 +12,19 @@
 #include "AETK/AEGP/Core/Core.hpp"
 #include "AETK/AEGP/Items.hpp"
 #include "AETK/AEGP/Layers.hpp"
+#include "AETK/AEGP/Util/IdentityMap.hpp"
 #include "AETK/AEGP/Util/Properties.hpp"
 
 
 class ItemFactory
 {
   public:
-    inline static tk::shared_ptr<Item> createItem(ItemPtr item)
+    // Returns the live wrapper for item if there is one; see IdentityMap.
+    inline static tk::shared_ptr<Item> createItem(ItemPtr item) { return IdentityMap::GetInstance().item(item); }
+
+    // Always constructs a new wrapper. Used by IdentityMap.
+    inline static tk::shared_ptr<Item> createItem(ItemPtr item, ItemType type)
     {
-        ItemType type = ItemSuite().GetItemType(item);
         switch (type)
         {
         case ItemType::FOLDER:
@@ -42,13 +46,24 @@ class PropertyFactory
     {
 
         StreamGroupingType groupType = DynamicStreamSuite().GetStreamGroupingType(property);
+        StreamType streamType = StreamType::NONE;
+        if (groupType == StreamGroupingType::LEAF)
+        {
+            streamType = StreamSuite().GetStreamType(property);
+        }
+        return CreateProperty(property, groupType, streamType);
+    }
+
+    // Use when the grouping and stream type are already known (e.g. from a PropertyTree snapshot).
+    static tk::shared_ptr<BaseProperty> CreateProperty(StreamRefPtr property, StreamGroupingType groupType,
+                                                       StreamType streamType)
+    {
         if (groupType == StreamGroupingType::INDEXED_GROUP || groupType == StreamGroupingType::NAMED_GROUP)
         {
             return tk::make_shared<PropertyGroup>(property);
         }
         else if (groupType == StreamGroupingType::LEAF)
         {
-            StreamType streamType = StreamSuite().GetStreamType(property);
             switch (streamType)
             {
             case StreamType::OneD:
@@ -85,11 +100,13 @@ class LayerFactory
   public:
     inline static tk::shared_ptr<Layer> createLayer(LayerPtr layer)
     {
-        if (layer == nullptr)
-		{
-			return nullptr;
-		}
-        ObjectType type = LayerSuite().GetLayerObjectType(layer);
+        // Returns the live wrapper for layer if there is one; see IdentityMap.
+        return IdentityMap::GetInstance().layer(layer);
+    }
+
+    // Always constructs a new wrapper. Used by IdentityMap.
+    inline static tk::shared_ptr<Layer> createLayer(LayerPtr layer, ObjectType type)
+    {
         switch (type)
         {
         case ObjectType::AV:
@@ -0,0 +1,148 @@
+/*****************************************************************/ /**
+                                                                     * \file   FrameCache.hpp
+                                                                     * \brief  LRU cache of rendered item frames,
+                                                                     *validated against AE's change timestamps.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef FRAME_CACHE_HPP
+#define FRAME_CACHE_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+
+#include <list>
+
+namespace ae
+{
+
+/**
+ * @brief Everything about a render request that changes its pixels.
+ */
+struct FrameKey
+{
+    A_long itemID = 0;
+    int64_t timeNum = 0; // Render time, reduced, so 1/24 and 1001/24024 match
+    int64_t timeDen = 1;
+    int64_t stepNum = 0; // Time step, which drives motion blur
+    int64_t stepDen = 1;
+    A_short downsampleX = 1;
+    A_short downsampleY = 1;
+    A_LRect roi{0, 0, 0, 0};
+    AEGP_WorldType worldType = AEGP_WorldType_NONE;
+    AEGP_MatteMode matteMode = AEGP_MatteMode_STRAIGHT;
+    AEGP_ChannelOrder channelOrder = AEGP_ChannelOrder_ARGB;
+
+    bool operator==(const FrameKey &o) const;
+    bool operator!=(const FrameKey &o) const { return !(*this == o); }
+};
+
+struct FrameKeyHash
+{
+    size_t operator()(const FrameKey &key) const;
+};
+
+struct FrameCacheOptions
+{
+    size_t byteBudget = size_t(512) << 20; // Least recently used frames are dropped beyond this
+    bool checkinToAE = false;              // insert() also hands frames to AE's own cache
+};
+
+struct FrameCacheStats
+{
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t invalidated = 0; // Entries dropped because the item changed
+    size_t evicted = 0;     // Entries dropped for the byte budget
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+/**
+ * @class FrameCache
+ * @brief Rendered frames by item and render options, least recently used first out.
+ *
+ * Each entry remembers the project timestamp it was rendered at. A lookup reads
+ * the key fields and AEGP_GetCurrentTimestamp in one task; if the project has
+ * not changed since, the hit costs that task and a hash lookup. Otherwise
+ * AEGP_HasItemChangedSinceTimestamp decides, over the frame's time step,
+ * whether the entry is stale or just needs its timestamp moved forward.
+ *
+ * Frames are copies owned by the cache, so receipts go back to AE at once.
+ * Returned worlds stay valid after eviction; they are shared, not lent.
+ *
+ * Frames rendered outside AE can be added with insert(). With checkinToAE
+ * they are also given to AEGP_CheckinRenderedFrame, when AE reports the frame
+ * worth caching and the item has not changed since rendering started.
+ *
+ * Lookups match keys exactly. isRenderedFrameSufficient is not consulted, since
+ * a sufficient frame (e.g. full resolution for a half resolution request) would
+ * not have the size the caller asked for.
+ *
+ * @example
+ * ae::FrameCache cache({size_t(256) << 20});
+ * auto options = RenderOptionsSuite().newFromItem(comp->getItem());
+ * RenderOptionsSuite().setTime(options, time);
+ * WorldPtr frame = cache.render(comp->getItem(), options); // Renders once, then hits until the comp changes
+ */
+class FrameCache
+{
+  public:
+    explicit FrameCache(const FrameCacheOptions &options = {});
+
+    /**
+     * @brief The cached frame for item with options, rendering and caching it on a miss.
+     */
+    WorldPtr render(ItemPtr item, RenderOptionsPtr options);
+
+    /**
+     * @brief The cached frame if it is still valid, otherwise nullptr. Never renders.
+     */
+    WorldPtr find(ItemPtr item, RenderOptionsPtr options);
+
+    /**
+     * @brief Adds a frame rendered outside AE. startedAt is the timestamp taken before rendering; nullptr means now.
+     * ticksToRender is the render time in 1/60 s, for AE's cache.
+     */
+    void insert(ItemPtr item, RenderOptionsPtr options, WorldPtr world, TimeStampPtr startedAt = nullptr,
+                A_u_long ticksToRender = 0);
+
+    /**
+     * @brief Drops every frame of item.
+     */
+    void invalidate(ItemPtr item);
+    void clear();
+
+    void setByteBudget(size_t bytes);
+    size_t byteBudget() const;
+    FrameCacheStats stats() const;
+
+  private:
+    struct Entry
+    {
+        WorldPtr world;
+        size_t bytes = 0;
+        AEGP_TimeStamp stamp;
+        A_Time start{0, 1};    // Item time range the frame depends on
+        A_Time duration{0, 1};
+        std::list<FrameKey>::iterator lru;
+    };
+
+    struct Probe; // Key and timestamp read in one task, defined in the source file
+
+    Probe probe(ItemPtr item, RenderOptionsPtr options);
+    WorldPtr lookup(ItemPtr item, const Probe &probe);
+    void store(const FrameKey &key, Entry entry);
+    void evict(); // Called with m_mutex held
+
+    FrameCacheOptions m_options;
+    mutable std::mutex m_mutex;
+    std::unordered_map<FrameKey, Entry, FrameKeyHash> m_entries;
+    std::list<FrameKey> m_lru; // Front is most recently used
+    size_t m_bytes = 0;
+    FrameCacheStats m_stats;
+};
+
+} // namespace ae
+
+#endif // FRAME_CACHE_HPP
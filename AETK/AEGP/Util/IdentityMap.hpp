@@ -0,0 +1,107 @@
+/*****************************************************************/ /**
+                                                                     * \file   IdentityMap.hpp
+                                                                     * \brief  One wrapper object per AE layer and
+                                                                     *project item.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef IDENTITY_MAP_HPP
+#define IDENTITY_MAP_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+
+class Item;
+class Layer;
+
+/**
+ * @class IdentityMap
+ * @brief Maps AE layer and item IDs to the wrapper already handed out for them.
+ *
+ * LayerFactory and ItemFactory go through this map, so navigating to the same
+ * layer twice (parent chains, source items, active layer) returns the same
+ * object. Attributes cached on that object (ID, parent comp, resolved stream
+ * refs) are therefore reused, and wrappers can be compared by pointer.
+ *
+ * Wrappers are held weakly; the map never keeps one alive. Layers are keyed by
+ * (parent comp, AEGP_LayerIDVal) since layer IDs are only unique within a comp;
+ * items by their item ID. Entries are dropped when the wrapper is deleted
+ * through AETK (Layer::Delete, Item::deleteItem and the collections' remove,
+ * pop and clear) and the whole map is cleared when the open project changes.
+ *
+ * Since one wrapper is shared by every thread that looks it up, the attributes
+ * a wrapper caches lazily are guarded by a per-wrapper mutex.
+ */
+class IdentityMap
+{
+  public:
+    static IdentityMap &GetInstance()
+    {
+        static IdentityMap instance;
+        return instance;
+    }
+
+    /**
+     * @brief The wrapper for layer, created if none is alive. Resolves its key in one task.
+     */
+    tk::shared_ptr<Layer> layer(LayerPtr layer);
+
+    /**
+     * @brief As layer(LayerPtr), for callers that already read the key and object type.
+     */
+    tk::shared_ptr<Layer> layer(AEGP_ProjectH project, LayerPtr layer, AEGP_CompH comp, AEGP_LayerIDVal id,
+                                ObjectType type);
+
+    /**
+     * @brief The wrapper for item, created if none is alive. Resolves its key in one task.
+     */
+    tk::shared_ptr<Item> item(ItemPtr item);
+
+    /**
+     * @brief As item(ItemPtr), for callers that already read the ID and item type.
+     */
+    tk::shared_ptr<Item> item(AEGP_ProjectH project, ItemPtr item, A_long id, ItemType type);
+
+    /**
+     * @brief Drops the entry for a wrapper whose AE object was deleted.
+     */
+    void forget(const Layer *layer);
+    void forget(const Item *item);
+
+    /**
+     * @brief Drops every entry.
+     */
+    void clear();
+
+    size_t size() const;
+
+  private:
+    IdentityMap() = default;
+
+    struct LayerKey
+    {
+        AEGP_CompH comp;
+        AEGP_LayerIDVal id;
+        bool operator==(const LayerKey &other) const { return comp == other.comp && id == other.id; }
+    };
+    struct LayerKeyHash
+    {
+        size_t operator()(const LayerKey &key) const
+        {
+            return std::hash<const void *>()(key.comp) ^ (std::hash<AEGP_LayerIDVal>()(key.id) * 0x9E3779B97F4A7C15ull);
+        }
+    };
+
+    // Clears the map if project differs from the one it was filled from. Caller holds m_mutex.
+    void checkProject(AEGP_ProjectH project);
+    // Drops expired entries once the maps have doubled since the last sweep. Caller holds m_mutex.
+    void prune();
+
+    mutable std::mutex m_mutex;
+    AEGP_ProjectH m_project = nullptr;
+    std::unordered_map<LayerKey, std::weak_ptr<Layer>, LayerKeyHash> m_layers;
+    std::unordered_map<A_long, std::weak_ptr<Item>> m_items;
+    size_t m_pruneAt = 64;
+};
+
+#endif // IDENTITY_MAP_HPP
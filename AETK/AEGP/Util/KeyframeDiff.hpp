@@ -0,0 +1,171 @@
+/*****************************************************************/ /**
+                                                                     * \file   KeyframeDiff.hpp
+                                                                     * \brief  Diff/patch engine for re-applying
+                                                                     *keyframes to a stream incrementally.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef KEYFRAME_DIFF_HPP
+#define KEYFRAME_DIFF_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+#include "AETK/AEGP/Util/Keyframe.hpp"
+
+/**
+ * @brief Options controlling how two keyframe lists are matched and compared.
+ *
+ * Keys whose times are within timeTolerance (in seconds) of each other are
+ * treated as the same key. The default absorbs the 1/100s rounding that
+ * getKeyframes() applies on a property without a TimeContext. With one, read
+ * times are exact and inserted keys land on its frames, so anything under
+ * half a frame works.
+ * Numeric components (values, ease, tangents) are compared with valueTolerance.
+ */
+struct KeyframeDiffOptions
+{
+    double timeTolerance = 0.005;
+    double valueTolerance = 1e-6;
+};
+
+enum class KeyframeOpType
+{
+    Insert,
+    Update,
+    Delete
+};
+
+/**
+ * @brief A single edit produced by KeyframeDiff::diff.
+ *
+ * index refers to the key in the snapshot the diff was computed against. It is
+ * -1 for inserts. key holds the desired key for inserts/updates and the
+ * snapshot key for deletes.
+ */
+struct KeyframeOp
+{
+    KeyframeOpType type;
+    int index;
+    KeyFrame key;
+};
+
+/**
+ * @brief The set of edits needed to turn a stream's keys into a desired list.
+ */
+class KeyframePatch
+{
+  public:
+    KeyframePatch() = default;
+
+    bool empty() const { return ops.empty(); }
+    size_t size() const { return ops.size(); }
+
+    size_t numInserts() const { return count(KeyframeOpType::Insert); }
+    size_t numUpdates() const { return count(KeyframeOpType::Update); }
+    size_t numDeletes() const { return count(KeyframeOpType::Delete); }
+
+    tk::vector<KeyframeOp> ops;
+
+  private:
+    size_t count(KeyframeOpType type) const
+    {
+        return std::count_if(ops.begin(), ops.end(), [type](const KeyframeOp &op) { return op.type == type; });
+    }
+};
+
+/**
+ * @brief A stream together with the keys it should end up with.
+ */
+struct KeyframeTrack
+{
+    StreamRefPtr stream;
+    tk::vector<KeyFrame> keys;
+};
+
+/**
+ * @class KeyframeDiff
+ * @brief Computes and applies minimal keyframe edits.
+ *
+ * Re-applying animation by deleting every key and calling addKeys floods the
+ * undo stack and re-creates keys that did not change. KeyframeDiff instead
+ * reads the current keys of a stream in one main-thread task, compares them
+ * against the desired keys off the main thread, and writes only the inserts,
+ * updates and deletes that are needed in one more task.
+ *
+ * Optional fields on a desired KeyFrame (interp, easeIn/easeOut, tangents)
+ * are only compared when set. Flags are only compared when the desired key
+ * lists at least one flag.
+ *
+ * Inserted keys are snapped to the frames of the given TimeContext, or of the
+ * most recently used comp without one.
+ *
+ * @example
+ * auto position = layer->Position();
+ * auto patch = KeyframeDiff::sync(position->getStream(), desiredKeys);
+ */
+class KeyframeDiff
+{
+  public:
+    /**
+     * @brief Read every keyframe of a stream in a single main-thread task.
+     *
+     * Keys are returned in index (time) order with all attributes filled in.
+     */
+    static tk::vector<KeyFrame> snapshot(StreamRefPtr stream);
+
+    /**
+     * @brief Read the keyframes of many streams in a single main-thread task.
+     */
+    static tk::vector<tk::vector<KeyFrame>> snapshot(const tk::vector<StreamRefPtr> &streams);
+
+    /**
+     * @brief Compare the current keys against the desired keys.
+     *
+     * Both lists are sorted by time before matching, so the desired keys may
+     * be given in any order. Runs without touching After Effects.
+     */
+    static KeyframePatch diff(const tk::vector<KeyFrame> &current, const tk::vector<KeyFrame> &desired,
+                              const KeyframeDiffOptions &options = {});
+
+    /**
+     * @brief Apply a patch to the stream it was computed against.
+     *
+     * All edits are made in one main-thread task inside one undo group.
+     */
+    static void apply(StreamRefPtr stream, const KeyframePatch &patch, const std::string &undoName = "Sync Keyframes",
+                      const std::optional<ae::TimeContext> &context = std::nullopt);
+
+    /**
+     * @brief Snapshot, diff and apply in one call.
+     *
+     * \return The patch that was applied.
+     */
+    static KeyframePatch sync(StreamRefPtr stream, const tk::vector<KeyFrame> &desired,
+                              const KeyframeDiffOptions &options = {},
+                              const std::optional<ae::TimeContext> &context = std::nullopt);
+
+    /**
+     * @brief Sync many streams at once.
+     *
+     * Uses one task to read all streams and one task to write all non-empty
+     * patches, grouped under a single undo entry.
+     *
+     * \return One patch per track, in the same order as tracks.
+     */
+    static tk::vector<KeyframePatch> sync(const tk::vector<KeyframeTrack> &tracks,
+                                          const KeyframeDiffOptions &options = {},
+                                          const std::optional<ae::TimeContext> &context = std::nullopt);
+
+    /**
+     * @brief Whether a current key already satisfies a desired key.
+     */
+    static bool matches(const KeyFrame &current, const KeyFrame &desired, const KeyframeDiffOptions &options = {});
+
+  private:
+    static void applyUnscheduled(AEGP_StreamRefH stream, const KeyframePatch &patch, const ae::TimeContext &context);
+    static tk::vector<KeyFrame> snapshotUnscheduled(AEGP_StreamRefH stream);
+    static void applyAll(const tk::vector<std::pair<StreamRefPtr, const KeyframePatch *>> &patches,
+                         const std::string &undoName, const std::optional<ae::TimeContext> &context);
+};
+
+#endif // KEYFRAME_DIFF_HPP
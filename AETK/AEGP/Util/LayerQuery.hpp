@@ -0,0 +1,165 @@
+/*****************************************************************/ /**
+                                                                     * \file   LayerQuery.hpp
+                                                                     * \brief  Declarative layer filtering over a comp,
+                                                                     *fetched in one main-thread task.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef LAYER_QUERY_HPP
+#define LAYER_QUERY_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+#include <functional>
+
+class Layer;
+
+/**
+ * @brief Layer attributes a LayerQuery can fetch. Combine with |.
+ */
+enum class LayerColumn : unsigned
+{
+    None = 0,
+    Name = 1 << 0,         // name, sourceName
+    Flags = 1 << 1,        // flags
+    Label = 1 << 2,        // label
+    ObjectType = 1 << 3,   // type
+    InOut = 1 << 4,        // inPoint, outPoint
+    Parent = 1 << 5,       // parentID
+    SourceItemID = 1 << 6, // sourceItemID
+    VideoActive = 1 << 7,  // videoActive, at the query time
+    All = 0xFF
+};
+
+inline LayerColumn operator|(LayerColumn a, LayerColumn b)
+{
+    return LayerColumn(unsigned(a) | unsigned(b));
+}
+
+inline LayerColumn operator&(LayerColumn a, LayerColumn b)
+{
+    return LayerColumn(unsigned(a) & unsigned(b));
+}
+
+/**
+ * @brief Fetched attributes of one layer. Fields whose column was not selected
+ * keep their defaults.
+ */
+struct LayerRow
+{
+    AEGP_LayerIDVal id = 0;
+    int index = 0; // Comp order at fetch time, 0 is the top layer
+    LayerPtr layer;
+
+    std::string name;       // Layer name, empty if it has none
+    std::string sourceName; // Name AE shows when the layer has no name
+    LayerFlag flags = LayerFlag::NONE;
+    Label label = Label::NONE;
+    ObjectType type = ObjectType::NONE;
+    double inPoint = 0.0; // Comp time, seconds
+    double outPoint = 0.0;
+    AEGP_LayerIDVal parentID = 0; // 0 if the layer has no parent
+    A_long sourceItemID = 0;      // 0 for layers without a source item (text, shape, camera, light)
+    bool videoActive = false;
+
+    bool hasFlag(LayerFlag flag) const { return (int(flags) & int(flag)) != 0; }
+
+    /**
+     * @brief The name shown in the timeline.
+     */
+    const std::string &displayName() const { return name.empty() ? sourceName : name; }
+};
+
+/**
+ * @class LayerQuery
+ * @brief Selects layers of a comp by a predicate over their attributes.
+ *
+ * Filtering through the Layer wrappers costs several marshalled calls per layer
+ * per attribute. LayerQuery asks which columns the predicate reads, fetches
+ * exactly those for every layer of the comp inside a single task, and then
+ * evaluates the predicate off the main thread. Only layer IDs cross back, so
+ * the result stays valid across reorders.
+ *
+ * @example
+ * std::regex pattern("^BG_.*");
+ * auto ids = LayerQuery(comp.getComp())
+ *                .select(LayerColumn::Flags | LayerColumn::Label | LayerColumn::ObjectType |
+ *                        LayerColumn::Name | LayerColumn::VideoActive)
+ *                .at(comp.currentTime())
+ *                .where([&](const LayerRow &row) {
+ *                    return row.type == ObjectType::AV && row.hasFlag(LayerFlag::LAYER_IS_3D) &&
+ *                           row.label == Label::LABEL_5 && row.videoActive &&
+ *                           std::regex_match(row.displayName(), pattern);
+ *                })
+ *                .ids();
+ */
+class LayerQuery
+{
+  public:
+    using Predicate = std::function<bool(const LayerRow &)>;
+
+    LayerQuery(CompPtr comp) : m_comp(comp) {}
+
+    /**
+     * @brief Columns the predicate reads. Only these are fetched.
+     */
+    LayerQuery &select(LayerColumn columns)
+    {
+        m_columns = columns;
+        return *this;
+    }
+
+    /**
+     * @brief Predicate a layer must satisfy. Without one, every layer matches.
+     */
+    LayerQuery &where(Predicate predicate)
+    {
+        m_predicate = std::move(predicate);
+        return *this;
+    }
+
+    /**
+     * @brief Comp time in seconds used for LayerColumn::VideoActive, rounded to the comp's nearest frame.
+     * Defaults to 0.
+     */
+    LayerQuery &at(double time)
+    {
+        m_time = time;
+        return *this;
+    }
+
+    /**
+     * @brief Selected columns of every layer, in comp order. One task.
+     */
+    tk::vector<LayerRow> rows() const;
+
+    /**
+     * @brief Fetches on the calling thread, then evaluates the predicate on a worker.
+     * The future yields the IDs of matching layers, in comp order.
+     */
+    std::future<tk::vector<AEGP_LayerIDVal>> run() const;
+
+    /**
+     * @brief run().get()
+     */
+    tk::vector<AEGP_LayerIDVal> ids() const { return run().get(); }
+
+    /**
+     * @brief Wrappers for the matching layers, through IdentityMap.
+     */
+    tk::vector<tk::shared_ptr<Layer>> layers() const;
+
+    CompPtr comp() const { return m_comp; }
+    LayerColumn columns() const { return m_columns; }
+
+  private:
+    tk::vector<LayerRow> fetch(LayerColumn columns, AEGP_ProjectH *project) const;
+    static tk::vector<AEGP_LayerIDVal> match(const tk::vector<LayerRow> &rows, const Predicate &predicate);
+
+    CompPtr m_comp;
+    LayerColumn m_columns = LayerColumn::None;
+    Predicate m_predicate;
+    double m_time = 0.0;
+};
+
+#endif // LAYER_QUERY_HPP
@@ -0,0 +1,75 @@
+/*****************************************************************/ /**
+                                                                     * \file   MarkerTrack.hpp
+                                                                     * \brief  Every marker of a layer or comp marker
+                                                                     *stream, read and written in one batch.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef MARKER_TRACK_HPP
+#define MARKER_TRACK_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+
+/**
+ * @brief One marker key, fully copied out of AE.
+ *
+ * Times are kept as A_Time so that a snapshot applied back lands on exactly
+ * the same times.
+ */
+struct MarkerEntry
+{
+    A_Time time{0, 1};     // Comp time
+    A_Time duration{0, 1}; // 0 for a point marker
+    int label = 0;
+
+    std::string comment;
+    std::string chapter;
+    std::string url;
+    std::string frameTarget;
+    std::string cuePointName;
+
+    bool navigation = false;    // Otherwise an event marker
+    bool protectRegion = false; // Protected against time stretching in precomps
+
+    tk::vector<std::pair<std::string, std::string>> cuePointParams; // Key, value
+
+    double seconds() const { return static_cast<double>(time.value) / time.scale; }
+    double durationSeconds() const { return static_cast<double>(duration.value) / duration.scale; }
+};
+
+/**
+ * @class MarkerTrack
+ * @brief All markers of one marker stream, in time order.
+ *
+ * Marker and MarkerSuite make one marshalled call per string, flag, duration
+ * and cue-point parameter. snapshot() reads every key and every field inside a
+ * single main-thread task, and apply() replaces the stream's markers with a
+ * track in a single task and undo group.
+ *
+ * @example
+ * auto track = layer->Marker()->snapshot();
+ * for (auto &marker : track.markers)
+ *     marker.comment = "Shot " + marker.comment;
+ * layer->Marker()->apply(track);
+ */
+class MarkerTrack
+{
+  public:
+    tk::vector<MarkerEntry> markers;
+
+    bool empty() const { return markers.empty(); }
+    size_t size() const { return markers.size(); }
+
+    /**
+     * @brief Reads every marker of a layer or comp marker stream.
+     */
+    static MarkerTrack snapshot(StreamRefPtr stream);
+
+    /**
+     * @brief Removes every marker of stream, then adds the markers of track.
+     */
+    static void apply(StreamRefPtr stream, const MarkerTrack &track, const std::string &undoName = "Set Markers");
+};
+
+#endif // MARKER_TRACK_HPP
@@ -0,0 +1,58 @@
+/*****************************************************************/ /**
+                                                                     * \file   Parallel.hpp
+                                                                     * \brief  Minimal parallel loop for CPU-side work
+                                                                     *that never calls into AE.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+
+namespace ae
+{
+
+/**
+ * @brief Runs job(i) for i in [0, count) on up to maxThreads workers; 0 uses
+ * std::thread::hardware_concurrency(). Indices are handed out one at a time,
+ * so uneven jobs balance. Returns once every job is done and rethrows the
+ * first exception.
+ *
+ * Jobs run on worker threads, so they must not wait on main-thread tasks.
+ */
+template <typename Job> void parallelFor(size_t count, unsigned int maxThreads, const Job &job)
+{
+    unsigned int threads = maxThreads ? maxThreads : std::thread::hardware_concurrency();
+    threads = std::max(1u, std::min<unsigned int>(threads, static_cast<unsigned int>(count)));
+    if (threads <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            job(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            job(i);
+        }
+    };
+    tk::vector<std::future<void>> workers;
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        workers.push_back(std::async(std::launch::async, worker));
+    }
+    for (auto &w : workers)
+    {
+        w.get();
+    }
+}
+
+} // namespace ae
+
+#endif // PARALLEL_HPP
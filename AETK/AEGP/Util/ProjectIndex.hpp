@@ -0,0 +1,125 @@
+/*****************************************************************/ /**
+                                                                     * \file   ProjectIndex.hpp
+                                                                     * \brief  Flat index of every item in a project,
+                                                                     *built in a single traversal.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef PROJECT_INDEX_HPP
+#define PROJECT_INDEX_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+#include "AETK/AEGP/Util/AtomTable.hpp"
+#include <atomic>
+
+class Item;
+
+/**
+ * @class ProjectIndex
+ * @brief Item ID, parent, type, name and children of every project item.
+ *
+ * Finding the children of a folder through the item suite means walking the
+ * whole project and asking each item for its parent, so expanding a folder
+ * tree costs O(folders x items) marshalled calls. build() walks the project
+ * once inside a single main-thread task and stores the result in flat arrays;
+ * children lists are kept contiguous, so children(i) is a pointer range.
+ *
+ * Entries are addressed by a dense index. Entry 0 is the root folder.
+ *
+ * current() hands out a shared snapshot and only rebuilds it when:
+ *  - it was invalidated by an AETK call that adds, removes, moves or renames items,
+ *  - ProjectIsDirty has changed since the snapshot was built (edit or save), or
+ *  - the project itself has changed.
+ * Edits made by the user while the project is already dirty are not visible to
+ * the dirty flag; call invalidate() from an idle or command hook if you need them.
+ *
+ * @example
+ * auto index = ProjectIndex::current(ProjSuite().GetProjectByIndex(0));
+ * for (int child : index->children(index->root()))
+ *     std::cout << index->name(child) << "\n";
+ */
+class ProjectIndex
+{
+  public:
+    /**
+     * @brief Walks the whole project in one task.
+     */
+    static tk::shared_ptr<const ProjectIndex> build(ProjectPtr project);
+
+    /**
+     * @brief The shared snapshot for project, rebuilt if it is stale.
+     */
+    static tk::shared_ptr<const ProjectIndex> current(ProjectPtr project);
+
+    /**
+     * @brief Forces the next current() call to rebuild.
+     */
+    static void invalidate() { s_generation.fetch_add(1, std::memory_order_relaxed); }
+
+    struct Range
+    {
+        const int *first;
+        const int *last;
+        const int *begin() const { return first; }
+        const int *end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        bool empty() const { return first == last; }
+    };
+
+    int size() const { return static_cast<int>(m_ids.size()); }
+    int root() const { return 0; }
+
+    A_long id(int i) const { return m_ids.at(i); }
+    AEGP_ItemH handle(int i) const { return m_handles.at(i); }
+    ItemPtr item(int i) const { return makeItemPtr(m_handles.at(i)); }
+    int parent(int i) const { return m_parents.at(i); } // -1 for the root
+    ItemType type(int i) const { return m_types.at(i); }
+    ae::Atom nameAtom(int i) const { return m_names.at(i); }
+    const std::string &name(int i) const { return ae::AtomTable::GetInstance().str(m_names.at(i)); }
+
+    /**
+     * @brief Direct children of entry i, in project order.
+     */
+    Range children(int i) const
+    {
+        const int *base = m_childList.data();
+        return {base + m_childStart.at(i), base + m_childStart.at(i + 1)};
+    }
+
+    /**
+     * @brief Entry for an item ID or handle, or -1 if it is not in the index.
+     */
+    int findID(A_long id) const;
+    int find(AEGP_ItemH item) const;
+    int find(const ItemPtr &item) const { return item ? find(AEGP_ItemH(*item)) : -1; }
+
+    /**
+     * @brief Item wrapper for entry i, typed from the indexed item type.
+     */
+    tk::shared_ptr<Item> createItem(int i) const;
+
+    ProjectPtr project() const { return m_project; }
+    bool builtDirty() const { return m_dirty; }
+
+  private:
+    ProjectPtr m_project;
+    bool m_dirty = false;
+    uint64_t m_generation = 0;
+
+    tk::vector<A_long> m_ids;
+    tk::vector<AEGP_ItemH> m_handles;
+    tk::vector<int> m_parents;
+    tk::vector<ItemType> m_types;
+    tk::vector<ae::Atom> m_names;
+    tk::vector<int> m_childStart; // size() + 1 offsets into m_childList
+    tk::vector<int> m_childList;
+    std::unordered_map<A_long, int> m_byID;
+    std::unordered_map<AEGP_ItemH, int> m_byHandle;
+
+    inline static std::atomic<uint64_t> s_generation{0};
+    inline static std::mutex s_mutex;
+    inline static tk::shared_ptr<const ProjectIndex> s_current;
+};
+
+#endif // PROJECT_INDEX_HPP
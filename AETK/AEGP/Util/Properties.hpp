@@ -15,7 +15,11 @@
 #include <AETK/AEGP/Core/Core.hpp>
 
 
+#include <AETK/AEGP/Util/AtomTable.hpp>
 #include <AETK/AEGP/Util/Keyframe.hpp>
+#include <AETK/AEGP/Util/KeyframeDiff.hpp>
+#include <AETK/AEGP/Util/MarkerTrack.hpp>
+#include <atomic>
 #include <cmath>  // For std::abs
 #include <limits> // Include this at the top of your file
 
@@ -30,7 +34,7 @@ class BaseProperty
 
     std::string getName() const;
     void setName(const std::string &name);
-    StreamRefPtr getStream() const { return m_property; }
+    StreamRefPtr getStream() const { return stream(); }
    std::shared_ptr<BaseProperty> duplicate();
     std::string matchName() const;
 
@@ -67,7 +71,21 @@ class BaseProperty
 
     inline void addKeys(const tk::vector<KeyFrame> &keyframes);
 
+    // Brings the keys in line with keyframes, touching only the keys that differ. New keys snap to the time context.
+    KeyframePatch syncKeys(const tk::vector<KeyFrame> &keyframes, const KeyframeDiffOptions &options = {});
+
+    // Times passed to and returned from this property are converted with context
+    // rather than the most recently used comp. Key times are then exact, not
+    // rounded to 1/100 s.
+    void setTimeContext(const ae::TimeContext &context) { m_timeContext = context; }
+    void clearTimeContext() { m_timeContext.reset(); }
+    const std::optional<ae::TimeContext> &timeContext() const { return m_timeContext; }
+
   protected:
+    // Seconds <-> A_Time through m_timeContext if set, else SecondsToTime/TimeToSeconds.
+    A_Time toTime(double seconds) const;
+    double toSeconds(const A_Time &time) const;
+
     inline void setKeyFlags(AEGP_KeyframeIndex keyIndex, tk::vector<KeyframeFlag> flags);
 
     inline void setKeyInterpolation(AEGP_KeyframeIndex keyIndex, KeyInterp inInterp, KeyInterp outInterp);
@@ -81,7 +99,13 @@ class BaseProperty
 
     KeyFrame::TangentValue convertToTangentValue(AEGP_StreamValue2 value);
 
-    StreamRefPtr m_property;
+    // m_property, acquired through m_resolveStream on first use if it was not
+    // passed to the constructor. Use this rather than reading m_property directly.
+    StreamRefPtr stream() const;
+
+    mutable StreamRefPtr m_property;
+    std::function<StreamRefPtr()> m_resolveStream;
+    std::optional<ae::TimeContext> m_timeContext;
 };
 
 class PropertyGroup : public BaseProperty
@@ -174,6 +198,19 @@ class MarkerProperty : public BaseProperty
                                     bool preExpression = TRUE) const;
 
    std::shared_ptr<Marker> addMarker(double time);
+
+   /**
+    * @brief Every marker on the stream, read in one task. See MarkerTrack.
+    */
+   MarkerTrack snapshot() const { return MarkerTrack::snapshot(stream()); }
+
+   /**
+    * @brief Replaces every marker on the stream with track, in one task and one undo group.
+    */
+   void apply(const MarkerTrack &track, const std::string &undoName = "Set Markers")
+   {
+       MarkerTrack::apply(stream(), track, undoName);
+   }
 };
 
 class LayerIDProperty : public BaseProperty
@@ -211,6 +248,21 @@ class MaskOutlineProperty : public BaseProperty // maskOutlineValPtr
 
    std::shared_ptr<MaskOutline> getValue(LTimeMode timeMode = LTimeMode::CompTime, double time = 0.0,
                                          bool preExpression = TRUE) const;
+
+   /**
+    * @brief Sets the (unkeyed) outline from flat arrays in one task.
+    */
+   void setValue(const MaskOutlineData &outline);
+
+   /**
+    * @brief Writes an animated outline as one keyframe per time, in one task and one undo group.
+    *
+    * times are in seconds of comp time, on the time scale of the property's
+    * TimeContext or else the most recently used comp's; times and outlines
+    * must be the same length.
+    */
+   void setKeys(const tk::vector<double> &times, const tk::vector<MaskOutlineData> &outlines,
+                const std::string &undoName = "Set Mask Keyframes");
 };
 
 class TextDocumentProperty : public BaseProperty
@@ -226,4 +278,43 @@ class TextDocumentProperty : public BaseProperty
                                           bool preExpression = TRUE) const;
 };
 
+/**
+ * @brief Resolves '/'-separated match-name paths below a root stream and
+ * remembers the result.
+ *
+ * Paths are interned, so a repeated lookup is a single hash lookup. Every
+ * resolved prefix is cached as well, which lets sibling paths share the walk.
+ * The whole cache is dropped whenever streams are added, removed, reordered
+ * or duplicated through BaseProperty/PropertyGroup, or effects are applied.
+ *
+ * @example
+ * auto position = layer->property("ADBE Transform Group/ADBE Position");
+ */
+class PropertyPathCache
+{
+  public:
+    PropertyPathCache(StreamRefPtr root) : m_root(std::move(root)) {}
+
+    /**
+     * @brief The property at path, or nullptr if any segment does not exist.
+     */
+    std::shared_ptr<BaseProperty> get(const std::string &path);
+
+    void clear();
+
+    /**
+     * @brief Marks every PropertyPathCache as stale. Called by operations that
+     * change the shape of a stream tree.
+     */
+    static void invalidateAll() { s_generation.fetch_add(1, std::memory_order_relaxed); }
+
+  private:
+    StreamRefPtr m_root;
+    std::mutex m_mutex;
+    uint64_t m_generation = 0;
+    std::unordered_map<ae::Atom, std::shared_ptr<BaseProperty>> m_cache;
+
+    inline static std::atomic<uint64_t> s_generation{0};
+};
+
 #endif // PROPERTY_HPP
@@ -0,0 +1,115 @@
+/*****************************************************************/ /**
+                                                                     * \file   PropertyTree.hpp
+                                                                     * \brief  Flat, one-shot snapshot of a layer's
+                                                                     *dynamic stream tree.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef PROPERTY_TREE_HPP
+#define PROPERTY_TREE_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+#include "AETK/AEGP/Util/AtomTable.hpp"
+#include "AETK/AEGP/Util/Properties.hpp"
+
+/**
+ * @brief One stream in a PropertyTree.
+ *
+ * Nodes are stored in depth-first pre-order, so the subtree of node i is the
+ * range [i + 1, end). Node 0 is the layer's own stream group.
+ */
+struct PropertyNode
+{
+    int parent = -1; // -1 for the root
+    int depth = 0;   // 0 for the root
+    int index = 0;   // Index within the parent group
+    int end = 0;     // One past the last node of this subtree
+    int numChildren = 0;
+    StreamGroupingType grouping = StreamGroupingType::NONE;
+    StreamType type = StreamType::NONE; // NONE for groups
+    ae::Atom matchName = ae::InvalidAtom;
+    std::string name;
+    DynStreamFlag flags = DynStreamFlag(0);
+    int numKeys = 0; // Keyframes of a leaf at snapshot time; 0 for groups and streams without data
+
+    bool isGroup() const
+    {
+        return grouping == StreamGroupingType::NAMED_GROUP || grouping == StreamGroupingType::INDEXED_GROUP;
+    }
+    bool isLeaf() const { return grouping == StreamGroupingType::LEAF; }
+    bool hasFlag(DynStreamFlag flag) const { return (int(flags) & int(flag)) != 0; }
+};
+
+/**
+ * @class PropertyTree
+ * @brief A layer's whole property hierarchy, read in a single main-thread task.
+ *
+ * Walking a layer through getNumProperties/getPropertyByIndex costs several
+ * marshalled calls per node. snapshot() reads names, match names, types,
+ * flags and keyframe counts for every node at once and releases the stream refs it used. A
+ * node's stream ref is only re-acquired when stream() or property() is
+ * called for it, and is then cached along with its ancestors.
+ *
+ * @example
+ * auto tree = PropertyTree::snapshot(layer->getLayer());
+ * for (int i = 0; i < tree.size(); ++i)
+ * {
+ *     if (tree[i].isLeaf())
+ *         std::cout << tree.path(i) << "\n";
+ * }
+ */
+class PropertyTree
+{
+  public:
+    PropertyTree() = default;
+
+    static PropertyTree snapshot(LayerPtr layer);
+
+    int size() const { return static_cast<int>(m_nodes.size()); }
+    bool empty() const { return m_nodes.empty(); }
+    const PropertyNode &operator[](int i) const { return m_nodes.at(i); }
+    const tk::vector<PropertyNode> &nodes() const { return m_nodes; }
+    LayerPtr layer() const { return m_layer; }
+
+    const std::string &matchName(int i) const { return ae::AtomTable::GetInstance().str(m_nodes.at(i).matchName); }
+
+    /**
+     * @brief Indices of the direct children of node i.
+     */
+    tk::vector<int> children(int i) const;
+
+    /**
+     * @brief Index of the direct child of parent with the given match name, or -1.
+     */
+    int find(int parent, const std::string &matchName) const;
+
+    /**
+     * @brief Index of the node at a '/'-separated match-name path below the root, or -1.
+     */
+    int find(const std::string &path) const;
+
+    /**
+     * @brief '/'-separated match-name path from the root to node i.
+     */
+    std::string path(int i) const;
+
+    /**
+     * @brief Stream ref for node i, acquired on first use.
+     */
+    StreamRefPtr stream(int i) const;
+
+    /**
+     * @brief Property wrapper for node i. Uses the snapshotted grouping and
+     * stream type instead of querying them again.
+     */
+    tk::shared_ptr<BaseProperty> property(int i) const;
+
+  private:
+    LayerPtr m_layer;
+    tk::vector<PropertyNode> m_nodes;
+    mutable tk::vector<StreamRefPtr> m_streams;
+    mutable std::shared_ptr<std::mutex> m_streamsMutex = std::make_shared<std::mutex>();
+};
+
+#endif // PROPERTY_TREE_HPP
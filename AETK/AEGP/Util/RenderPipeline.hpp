@@ -0,0 +1,113 @@
+/*****************************************************************/ /**
+                                                                     * \file   RenderPipeline.hpp
+                                                                     * \brief  Bounded, ordered asynchronous layer
+                                                                     *frame rendering.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef RENDER_PIPELINE_HPP
+#define RENDER_PIPELINE_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+
+namespace ae
+{
+
+struct RenderPipelineOptions
+{
+    size_t maxInFlight = 4; // AE async requests outstanding at once
+    size_t maxBuffered = 4; // Finished frames waiting for the consumer before submit() blocks
+    bool ordered = true;    // Deliver in submission order; otherwise as frames complete
+};
+
+/**
+ * @brief One finished request.
+ */
+struct RenderedFrame
+{
+    size_t index = 0; // Position in submission order
+    A_Time time{0, 1};
+    WorldPtr world; // A copy owned by the pipeline; released back to its pool when the last reference goes
+    bool canceled = false;
+    A_Err error = A_Err_NONE;
+
+    bool ok() const { return world && !canceled && error == A_Err_NONE; }
+};
+
+/**
+ * @class RenderPipeline
+ * @brief Renders a layer at many times through AEGP_RenderAndCheckoutLayerFrame_Async,
+ * with a bounded number of requests in flight.
+ *
+ * submit() queues a time and blocks while maxInFlight + maxBuffered frames are
+ * undelivered, so a slow consumer holds back rendering instead of piling up
+ * frames. Requests are issued on the main thread; as each completes, its
+ * pixels are copied into a world from the pipeline's pool and the next queued
+ * time is requested straight from the completion callback. The receipt is
+ * never held past the callback, so AE's frame memory stays at maxInFlight.
+ *
+ * next() hands frames out in submission order, or as they complete when
+ * ordered is false. Releasing a frame's world returns it to the pool for the
+ * next frame of the same size and type.
+ *
+ * submit() and next() block, so call them off the main thread; completion
+ * callbacks arrive during AE's idle processing. cancel() calls
+ * AEGP_CancelAsyncRequest for everything in flight and drops queued times.
+ *
+ * @example
+ * auto options = LayerRenderOptionsSuite().newFromLayer(layer->getLayer());
+ * ae::RenderPipeline::run(options, times, [](ae::RenderedFrame &frame) {
+ *     if (frame.ok())
+ *         Image::saveImage(pathFor(frame.index), "png", Image::data(frame.world));
+ * });
+ */
+class RenderPipeline
+{
+  public:
+    explicit RenderPipeline(LayerRenderOptionsPtr options, const RenderPipelineOptions &pipelineOptions = {});
+    ~RenderPipeline(); // Cancels anything still in flight
+
+    RenderPipeline(const RenderPipeline &) = delete;
+    RenderPipeline &operator=(const RenderPipeline &) = delete;
+
+    /**
+     * @brief Queues a render at time and returns its index. Blocks while the pipeline is full.
+     */
+    size_t submit(const A_Time &time);
+
+    /**
+     * @brief True when submit() would block.
+     */
+    bool full() const;
+
+    /**
+     * @brief No more submits; next() returns nullopt once everything submitted has been delivered.
+     */
+    void close();
+
+    /**
+     * @brief The next frame, blocking until it is ready. nullopt after close() or cancel() once drained.
+     */
+    std::optional<RenderedFrame> next();
+
+    /**
+     * @brief Cancels every request in flight and drops queued and undelivered frames.
+     */
+    void cancel();
+
+    /**
+     * @brief Renders every time and passes each frame to sink, on the calling thread.
+     */
+    static void run(LayerRenderOptionsPtr options, const tk::vector<A_Time> &times,
+                    const std::function<void(RenderedFrame &)> &sink, const RenderPipelineOptions &pipelineOptions = {});
+
+    struct State; // Shared with completion callbacks, defined in the source file
+
+  private:
+    std::shared_ptr<State> m_state;
+};
+
+} // namespace ae
+
+#endif // RENDER_PIPELINE_HPP
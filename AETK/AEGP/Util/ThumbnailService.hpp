@@ -0,0 +1,158 @@
+/*****************************************************************/ /**
+                                                                     * \file   ThumbnailService.hpp
+                                                                     * \brief  Downsampled item thumbnails with a
+                                                                     *content-addressed disk cache.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef THUMBNAIL_SERVICE_HPP
+#define THUMBNAIL_SERVICE_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+
+#include <chrono>
+
+namespace ae
+{
+
+enum class ThumbnailFit
+{
+    Fit, // The whole frame, inside width x height, aspect kept
+    Fill // Exactly width x height, the centre of the frame cropped to the aspect
+};
+
+enum class ThumbnailFilter
+{
+    Box,    // Area average; fastest, softest
+    Lanczos // Lanczos-3; sharper, for near-1:1 and upscaled thumbnails
+};
+
+struct ThumbnailRequest
+{
+    int width = 256;
+    int height = 256;
+    double time = 0.0; // Item time, in seconds; snapped to the item's nearest frame
+    ThumbnailFit fit = ThumbnailFit::Fit;
+    ThumbnailFilter filter = ThumbnailFilter::Lanczos;
+};
+
+struct ThumbnailServiceOptions
+{
+    std::string cacheDirectory;  // UTF-8; empty uses "AETK Thumbnails" in the temp directory
+    unsigned int maxThreads = 0; // Resample and disk workers; 0 uses std::thread::hardware_concurrency()
+    size_t chunkSize = 64;       // Items validated per pair of main-thread tasks
+    std::chrono::milliseconds renderInterval{0}; // Least idle time left between two renders, so a cold cache
+                                                 // leaves AE room to respond; 0 renders a miss every idle pass
+};
+
+/**
+ * @brief RGBA8 pixels, width * 4 bytes per row, premultiplied as AE renders them. Empty if the item has no frame.
+ */
+struct Thumbnail
+{
+    int width = 0;
+    int height = 0;
+    tk::vector<A_u_char> pixels;
+    bool cached = false; // Read from the disk cache rather than rendered
+
+    bool empty() const { return pixels.empty(); }
+};
+
+struct ThumbnailStats
+{
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t failures = 0; // Items without a frame, e.g. folders
+};
+
+/**
+ * @class ThumbnailService
+ * @brief Renders small previews of project items and keeps them on disk.
+ *
+ * Misses are rendered at the largest downsample factor that still gives at
+ * least the requested size, with a region of interest for Fill crops, then
+ * resampled to the exact size on worker threads. An 8K comp renders a
+ * 256 pixel thumbnail at 1/16 resolution instead of in full.
+ *
+ * Files are named by a hash of the project path, item ID, frame time, size, fit and
+ * filter, and hold the AE timestamp taken before their render. A file from
+ * this session is current while AEGP_HasItemChangedSinceTimestamp says so.
+ * A file from an earlier session is only trusted if it was written while the
+ * project was saved, the project file has not been saved again since, and the
+ * item has not changed since this service was created with the project clean.
+ *
+ * Items are validated a chunk at a time: one main-thread task reads their
+ * IDs, sizes and frame rates, the cache file headers are read off the main
+ * thread, and one more task asks AE whether the cached items changed. That
+ * task is skipped when no file in the chunk is usable. A cached thumbnail
+ * thus costs part of two tasks and a file read on a worker; no disk access
+ * happens on the main thread.
+ *
+ * Misses render one per task, so thousands of items never hold up AE's idle
+ * loop for long.
+ *
+ * Misses render synchronously: AE has no asynchronous render of a whole
+ * item, so each one holds the main thread, and the UI, for as long as its
+ * render takes. A cold cache of heavy comps is felt. renderInterval spaces
+ * renders across every batch of the service, leaving AE that much idle time
+ * between them; interactive panels should set it.
+ *
+ * Call get() and wait on generate() off the main thread.
+ *
+ * @example
+ * ae::ThumbnailService thumbnails;
+ * auto done = thumbnails.generate(items, {128, 128}, [&](size_t index, const ae::Thumbnail &thumb) {
+ *     browser.setIcon(index, thumb);
+ * });
+ */
+class ThumbnailService
+{
+  public:
+    /**
+     * @brief Creates the cache directory and takes the timestamp earlier sessions' files are checked against.
+     */
+    explicit ThumbnailService(const ThumbnailServiceOptions &options = {});
+    ~ThumbnailService(); // Cancels running batches
+
+    /**
+     * @brief The thumbnail of item, from the cache or rendered. Blocks.
+     */
+    Thumbnail get(ItemPtr item, const ThumbnailRequest &request = {});
+
+    /**
+     * @brief Makes thumbnails of items on a background thread, calling onReady(index, thumbnail) as each is ready.
+     * onReady runs on worker threads, several at a time, in no particular order. The future ends with the batch
+     * and rethrows its first error.
+     */
+    std::future<void> generate(tk::vector<ItemPtr> items, const ThumbnailRequest &request,
+                               std::function<void(size_t, const Thumbnail &)> onReady);
+
+    /**
+     * @brief Stops running batches after the items they are on.
+     */
+    void cancel();
+
+    /**
+     * @brief Deletes every cached file.
+     */
+    void purge();
+
+    const std::string &cacheDirectory() const;
+    ThumbnailStats stats() const;
+
+    /**
+     * @brief Resamples RGBA8 pixels, rowBytes apart, to width x height.
+     */
+    static Thumbnail resample(const A_u_char *pixels, int srcWidth, int srcHeight, size_t rowBytes, int width,
+                              int height, ThumbnailFilter filter);
+
+  private:
+    struct State; // Shared with running batches, defined in the source file
+
+    std::shared_ptr<State> m_state;
+};
+
+} // namespace ae
+
+#endif // THUMBNAIL_SERVICE_HPP
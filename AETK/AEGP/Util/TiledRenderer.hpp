@@ -0,0 +1,110 @@
+/*****************************************************************/ /**
+                                                                     * \file   TiledRenderer.hpp
+                                                                     * \brief  Renders large item frames as
+                                                                     *region-of-interest tiles, processed in parallel.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef TILED_RENDERER_HPP
+#define TILED_RENDERER_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+
+namespace ae
+{
+
+struct TiledRenderOptions
+{
+    int tileSize = 0;                    // Square tiles in output pixels; 0 picks one from cacheBytes
+    size_t cacheBytes = size_t(4) << 20; // Target bytes per tile when tileSize is 0
+    unsigned int maxThreads = 0;         // Tile workers; 0 uses std::thread::hardware_concurrency()
+    size_t maxPendingTiles = 0;          // Tiles rendered or requested but not yet processed; 0 is twice the workers
+};
+
+/**
+ * @brief One rendered tile, handed to the tile callback. pixels is only valid during the callback.
+ */
+struct RenderTile
+{
+    int x = 0; // Position in the output frame, in output (downsampled) pixels
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    AEGP_WorldType type = AEGP_WorldType_NONE;
+    const char *pixels = nullptr; // width * pixelBytes per row, no padding
+    size_t rowBytes = 0;
+};
+
+/**
+ * @class TiledRenderer
+ * @brief Splits an item frame into region-of-interest tiles and renders them one request each.
+ *
+ * A single AEGP_RenderAndCheckoutFrame of an 8K comp makes one huge world and
+ * leaves everything after it single-threaded. Here each tile is its own
+ * main-thread task: the tile's ROI is set on a private copy of the options,
+ * the tile is rendered and copied out, and the receipt is checked in before the
+ * next tile. Worker threads pick tiles up as they arrive, copy them into the
+ * caller's buffer and run the tile callback, so encoding starts with the first
+ * tile and overlaps the rest of the render.
+ *
+ * At most maxPendingTiles tiles exist at once, in buffers that are reused,
+ * so memory beyond the caller's buffer is proportional to the tile size.
+ * Without a buffer, only the tiles are kept.
+ *
+ * AE only renders item frames synchronously, so tiles are requested in order
+ * rather than all at once; what runs in parallel is everything after the
+ * render. Call render() off the main thread.
+ *
+ * @example
+ * auto options = RenderOptionsSuite().newFromItem(comp->getItem());
+ * ae::TiledRenderer renderer(comp->getItem(), options, {256});
+ * std::vector<char> frame(renderer.rowBytes() * renderer.height());
+ * renderer.render(frame.data(), renderer.rowBytes(), [&](const ae::RenderTile &tile) { encoder.add(tile); });
+ */
+class TiledRenderer
+{
+  public:
+    /**
+     * @brief Reads the frame size, downsample and world type of options, in one task. options are not modified.
+     */
+    TiledRenderer(ItemPtr item, RenderOptionsPtr options, const TiledRenderOptions &tileOptions = {});
+
+    int width() const { return m_width; } // Output size, after downsampling
+    int height() const { return m_height; }
+    AEGP_WorldType worldType() const { return m_type; }
+    size_t pixelBytes() const;
+    size_t rowBytes() const { return pixelBytes() * static_cast<size_t>(m_width); } // For a buffer without padding
+    int tileSize() const { return m_tileSize; }
+
+    /**
+     * @brief The largest multiple of 64 whose square tile of type fits in cacheBytes, at least 64.
+     */
+    static int suggestTileSize(AEGP_WorldType type, size_t cacheBytes);
+
+    /**
+     * @brief Renders the frame into dst, rowBytes apart, calling onTile for each tile once it is in dst.
+     * onTile runs on worker threads, several at a time.
+     */
+    void render(void *dst, size_t rowBytes, const std::function<void(const RenderTile &)> &onTile = nullptr);
+
+    /**
+     * @brief Renders the frame tile by tile, without assembling it.
+     */
+    void render(const std::function<void(const RenderTile &)> &onTile);
+
+  private:
+    ItemPtr m_item;
+    RenderOptionsPtr m_options;
+    TiledRenderOptions m_tileOptions;
+    int m_width = 0;
+    int m_height = 0;
+    A_short m_downsampleX = 1;
+    A_short m_downsampleY = 1;
+    AEGP_WorldType m_type = AEGP_WorldType_NONE;
+    int m_tileSize = 0;
+};
+
+} // namespace ae
+
+#endif // TILED_RENDERER_HPP
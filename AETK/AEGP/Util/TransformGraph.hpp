@@ -0,0 +1,145 @@
+/*****************************************************************/ /**
+                                                                     * \file   TransformGraph.hpp
+                                                                     * \brief  World matrices of every layer in a comp
+                                                                     *over a range of frames.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef TRANSFORM_GRAPH_HPP
+#define TRANSFORM_GRAPH_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+#include "AETK/AEGP/Core/Matrix.hpp"
+
+struct TransformGraphOptions
+{
+    size_t framesPerTask = 256;  // Frames sampled per main-thread task, so AE stays responsive on long ranges
+    unsigned int maxThreads = 0; // 0 uses std::thread::hardware_concurrency()
+    bool exact = false;          // Read every world matrix with AEGP_GetLayerToWorldXform, e.g. to validate results
+};
+
+/**
+ * @class TransformGraph
+ * @brief Evaluates anchor, scale, orientation, rotation, position and parenting
+ * for all layers of a comp across many frames.
+ *
+ * LayerSuite::GetLayerToWorldXform is one marshalled call per layer per time.
+ * TransformGraph reads the hierarchy once and finds which transform streams
+ * can change (keyframes or an enabled expression). Static streams are read
+ * once; only the animated ones are sampled per frame, inside a few main-thread
+ * tasks. Local matrices are then built and composed down the parent hierarchy
+ * on worker threads, one layer per job, layers at the same depth in parallel.
+ * A rig of static parents under an animated camera costs a read per frame
+ * for each of the camera's animated streams, not one per layer per frame.
+ *
+ * Local matrices follow AE's order:
+ *     T(-anchor) * S(scale / 100) * R(orientation) * Rx * Ry * Rz * T(position)
+ * Cameras and lights have no anchor or scale; their anchor point stream is the
+ * point of interest, and with auto-orient towards it a look-at rotation is
+ * applied after their own rotations. 2D layers only use Z rotation. Stream
+ * values are read post-expression in comp time, so expressions, separated
+ * dimensions, layer offsets and stretch are AE's own. Time remapping only
+ * retimes a layer's source, never its transform, so it needs nothing here.
+ *
+ * Auto-orient along path follows the position path's tangent, sampled just
+ * before and after each frame: 2D layers add its angle to their rotation and
+ * cameras and lights look along it. 3D layers oriented along their path or
+ * towards the camera are read with AEGP_GetLayerToWorldXform instead, as are
+ * all layers with TransformGraphOptions::exact. Their local matrices are
+ * world * inverse(parentWorld); see singular().
+ *
+ * @example
+ * TransformGraph graph(comp.getComp());
+ * graph.evaluate(0.0, comp.duration());
+ * int camera = graph.find(cameraID);
+ * for (size_t f = 0; f < graph.frames(); ++f)
+ *     exportCamera(graph.times()[f], graph.world(camera, f));
+ */
+class TransformGraph
+{
+  public:
+    TransformGraph(CompPtr comp, TransformGraphOptions options = {}) : m_comp(comp), m_options(options) {}
+
+    /**
+     * @brief Evaluates every frame of the comp from start to end (seconds, inclusive),
+     * on the comp's frame grid.
+     */
+    void evaluate(double start, double end);
+
+    /**
+     * @brief Evaluates at arbitrary comp times in seconds.
+     */
+    void evaluate(const tk::vector<double> &times);
+
+    size_t layers() const { return m_layerIDs.size(); }
+    size_t frames() const { return m_times.size(); }
+    const tk::vector<double> &times() const { return m_times; }
+
+    /**
+     * @brief Layer IDs in comp order; row i of every accessor below.
+     */
+    const tk::vector<AEGP_LayerIDVal> &layerIDs() const { return m_layerIDs; }
+
+    /**
+     * @brief Row of a layer ID, or -1.
+     */
+    int find(AEGP_LayerIDVal id) const;
+
+    int parent(size_t layer) const { return m_parents.at(layer); } // -1 if unparented
+    ObjectType type(size_t layer) const { return m_types.at(layer); }
+    bool is3D(size_t layer) const { return m_is3D.at(layer) != 0; }
+
+    /**
+     * @brief True if the layer's world matrices come from AEGP_GetLayerToWorldXform.
+     */
+    bool exact(size_t layer) const { return m_exact.at(layer) != 0; }
+
+    /**
+     * @brief True if an exact layer's parent cannot be inverted at frame (e.g. at 0% scale), so local() is identity
+     * there and does not describe the layer.
+     */
+    bool singular(size_t layer, size_t frame) const { return m_singular.at(layer * m_times.size() + frame) != 0; }
+
+    /**
+     * @brief Layer to parent space at frame.
+     */
+    const ae::Mat4 &local(size_t layer, size_t frame) const { return m_local.at(layer * m_times.size() + frame); }
+
+    /**
+     * @brief Layer to comp (world) space at frame.
+     */
+    const ae::Mat4 &world(size_t layer, size_t frame) const { return m_world.at(layer * m_times.size() + frame); }
+
+    CompPtr comp() const { return m_comp; }
+
+  private:
+    // Sampled stream values per layer per frame.
+    struct Sample
+    {
+        ae::Vec3 anchor, position, scale{100, 100, 100}, orientation;
+        double rotateX = 0.0, rotateY = 0.0, rotateZ = 0.0;
+        ae::Vec3 tangent; // Of the position path, for auto-orient along path
+    };
+
+    void sample(const tk::vector<A_Time> &times);
+    void compose();
+
+    CompPtr m_comp;
+    TransformGraphOptions m_options;
+
+    tk::vector<double> m_times;
+    tk::vector<AEGP_LayerIDVal> m_layerIDs;
+    tk::vector<int> m_parents;
+    tk::vector<ObjectType> m_types;
+    tk::vector<char> m_is3D;
+    tk::vector<char> m_lookAt;     // Cameras and lights oriented towards their point of interest
+    tk::vector<char> m_autoOrient; // Oriented along their position path, in-process
+    tk::vector<char> m_exact;
+    tk::vector<Sample> m_samples; // layers() x frames(), layer-major
+    tk::vector<char> m_singular;
+    tk::vector<ae::Mat4> m_local;
+    tk::vector<ae::Mat4> m_world;
+};
+
+#endif // TRANSFORM_GRAPH_HPP
@@ -0,0 +1,63 @@
+/*****************************************************************/ /**
+                                                                     * \file   WorldUtil.hpp
+                                                                     * \brief  Raw pixel access to AEGP worlds.
+                                                                     *
+                                                                     * \author tjerf
+                                                                     * \date   April 2024
+                                                                     *********************************************************************/
+#ifndef WORLD_UTIL_HPP
+#define WORLD_UTIL_HPP
+
+#include "AETK/AEGP/Core/Core.hpp"
+
+namespace ae
+{
+
+/**
+ * @brief Bytes per pixel of a world type, or 0 for AEGP_WorldType_NONE.
+ */
+inline size_t pixelBytes(AEGP_WorldType type)
+{
+    switch (type)
+    {
+    case AEGP_WorldType_8:
+        return sizeof(PF_Pixel8);
+    case AEGP_WorldType_16:
+        return sizeof(PF_Pixel16);
+    case AEGP_WorldType_32:
+        return sizeof(PF_PixelFloat);
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief The first pixel of world, which is of the given type, or nullptr for AEGP_WorldType_NONE. Main thread only.
+ */
+inline char *baseAddr(AEGP_SuiteHandler &suites, AEGP_WorldH world, AEGP_WorldType type)
+{
+    switch (type)
+    {
+    case AEGP_WorldType_8: {
+        PF_Pixel8 *base = nullptr;
+        AE_CHECK(suites.WorldSuite3()->AEGP_GetBaseAddr8(world, &base));
+        return reinterpret_cast<char *>(base);
+    }
+    case AEGP_WorldType_16: {
+        PF_Pixel16 *base = nullptr;
+        AE_CHECK(suites.WorldSuite3()->AEGP_GetBaseAddr16(world, &base));
+        return reinterpret_cast<char *>(base);
+    }
+    case AEGP_WorldType_32: {
+        PF_PixelFloat *base = nullptr;
+        AE_CHECK(suites.WorldSuite3()->AEGP_GetBaseAddr32(world, &base));
+        return reinterpret_cast<char *>(base);
+    }
+    default:
+        return nullptr;
+    }
+}
+
+} // namespace ae
+
+#endif // WORLD_UTIL_HPP
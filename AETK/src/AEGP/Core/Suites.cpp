@@ -2617,7 +2617,7 @@ TextOutlinesPtr TextLayerSuite::getNewTextOutlines(LayerPtr layer, const Time &l
 int TextLayerSuite::getNumTextOutlines(TextOutlinesPtr outlines)
 {
     auto future = ae::ScheduleOrExecute([outlines]() {
-        CheckNotNull(&outlines, "Error Getting Number of Text Outlines. Outlines is Null");
+        CheckNotNull(outlines.get(), "Error Getting Number of Text Outlines. Outlines is Null");
         int numOutlines;
         AE_CHECK(SuiteManager::GetInstance().GetSuiteHandler().TextLayerSuite1()->AEGP_GetNumTextOutlines(
             *outlines, &numOutlines));
@@ -2628,7 +2628,14 @@ int TextLayerSuite::getNumTextOutlines(TextOutlinesPtr outlines)
 
 PF_PathOutlinePtr TextLayerSuite::getIndexedTextOutline(TextOutlinesPtr outlines, int path_index)
 {
-    return PF_PathOutlinePtr();
+    auto future = ae::ScheduleOrExecute([outlines, path_index]() {
+        CheckNotNull(outlines.get(), "Error Getting Indexed Text Outline. Outlines is Null");
+        PF_PathOutlinePtr path = nullptr;
+        AE_CHECK(SuiteManager::GetInstance().GetSuiteHandler().TextLayerSuite1()->AEGP_GetIndexedTextOutline(
+            *outlines, path_index, &path));
+        return path;
+    });
+    return future.get();
 }
 
 int EffectSuite::getLayerNumEffects(LayerPtr layer)
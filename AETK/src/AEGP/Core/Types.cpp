@@ -141,6 +141,106 @@ void MaskOutline::deleteFeather(int index)
     MaskOutlineSuite().deleteMaskOutlineFeather(m_mask_outlineP, index);
 }
 
+MaskOutlineData MaskOutline::readUnscheduled(AEGP_MaskOutlineValH outlineH)
+{
+    auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+    MaskOutlineData data;
+    A_Boolean openB = FALSE;
+    A_long numSegments = 0;
+    A_long numFeathers = 0;
+    AE_CHECK(suites.MaskOutlineSuite3()->AEGP_IsMaskOutlineOpen(outlineH, &openB));
+    AE_CHECK(suites.MaskOutlineSuite3()->AEGP_GetMaskOutlineNumSegments(outlineH, &numSegments));
+    AE_CHECK(suites.MaskOutlineSuite3()->AEGP_GetMaskOutlineNumFeathers(outlineH, &numFeathers));
+
+    // An open outline has one more vertex than segments; a closed one repeats vertex 0 at the end.
+    A_long numVertices = numSegments == 0 ? 0 : (openB ? numSegments + 1 : numSegments);
+    data.open = openB != FALSE;
+    data.resize(numVertices, numFeathers);
+    for (A_long i = 0; i < numVertices; ++i)
+    {
+        AEGP_MaskVertex vertex;
+        AE_CHECK(suites.MaskOutlineSuite3()->AEGP_GetMaskOutlineVertexInfo(outlineH, i, &vertex));
+        data.x[i] = vertex.x;
+        data.y[i] = vertex.y;
+        data.inX[i] = vertex.tan_in_x;
+        data.inY[i] = vertex.tan_in_y;
+        data.outX[i] = vertex.tan_out_x;
+        data.outY[i] = vertex.tan_out_y;
+    }
+    for (A_long i = 0; i < numFeathers; ++i)
+    {
+        AEGP_MaskFeather feather;
+        AE_CHECK(suites.MaskOutlineSuite3()->AEGP_GetMaskOutlineFeatherInfo(outlineH, i, &feather));
+        data.featherSegment[i] = feather.segment;
+        data.featherSegmentT[i] = feather.segment_sF;
+        data.featherRadius[i] = feather.radiusF;
+        data.featherCornerAngle[i] = feather.ui_corner_angleF;
+        data.featherTension[i] = feather.tensionF;
+        data.featherInterp[i] = MaskFeatherInterp(feather.interp);
+        data.featherType[i] = MaskFeatherType(feather.type);
+    }
+    return data;
+}
+
+void MaskOutline::writeUnscheduled(AEGP_MaskOutlineValH outlineH, const MaskOutlineData &data)
+{
+    auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+    A_Boolean openB = FALSE;
+    A_long numSegments = 0;
+    A_long numFeathers = 0;
+    AE_CHECK(suites.MaskOutlineSuite3()->AEGP_IsMaskOutlineOpen(outlineH, &openB));
+    AE_CHECK(suites.MaskOutlineSuite3()->AEGP_GetMaskOutlineNumSegments(outlineH, &numSegments));
+    AE_CHECK(suites.MaskOutlineSuite3()->AEGP_GetMaskOutlineNumFeathers(outlineH, &numFeathers));
+
+    // Feathers refer to segments, so drop them before the vertex count changes.
+    for (A_long i = numFeathers - 1; i >= 0; --i)
+    {
+        AE_CHECK(suites.MaskOutlineSuite3()->AEGP_DeleteMaskOutlineFeather(outlineH, i));
+    }
+
+    A_long have = numSegments == 0 ? 0 : (openB ? numSegments + 1 : numSegments);
+    const A_long want = static_cast<A_long>(data.numVertices());
+    for (; have < want; ++have)
+    {
+        AE_CHECK(suites.MaskOutlineSuite3()->AEGP_CreateVertex(outlineH, have));
+    }
+    for (; have > want; --have)
+    {
+        AE_CHECK(suites.MaskOutlineSuite3()->AEGP_DeleteVertex(outlineH, have - 1));
+    }
+    AE_CHECK(suites.MaskOutlineSuite3()->AEGP_SetMaskOutlineOpen(outlineH, data.open));
+
+    for (A_long i = 0; i < want; ++i)
+    {
+        AEGP_MaskVertex vertex = data.vertex(i).toAEGP();
+        AE_CHECK(suites.MaskOutlineSuite3()->AEGP_SetMaskOutlineVertexInfo(outlineH, i, &vertex));
+    }
+    for (size_t i = 0; i < data.numFeathers(); ++i)
+    {
+        AEGP_MaskFeather feather = data.feather(i).toAEGP();
+        AEGP_FeatherIndex index;
+        AE_CHECK(suites.MaskOutlineSuite3()->AEGP_CreateMaskOutlineFeather(outlineH, &feather, &index));
+    }
+}
+
+MaskOutlineData MaskOutline::readAll() const
+{
+    auto future = ae::ScheduleOrExecute([outline = m_mask_outlineP]() {
+        CheckNotNull(outline.get(), "Error Reading Mask Outline. Mask Outline is Null");
+        return readUnscheduled(*outline);
+    });
+    return future.get();
+}
+
+void MaskOutline::writeAll(const MaskOutlineData &data)
+{
+    auto future = ae::ScheduleOrExecute([outline = m_mask_outlineP, &data]() {
+        CheckNotNull(outline.get(), "Error Writing Mask Outline. Mask Outline is Null");
+        writeUnscheduled(*outline, data);
+    });
+    future.get();
+}
+
 std::string TextDocument::getText()
 {
     return TextDocumentSuite().getNewText(m_text_documentP);
@@ -3,7 +3,9 @@
 #include "AETK/AEGP/Template/ItemCollection.hpp"
 #include "AETK/AEGP/Template/LayerCollection.hpp"
 #include "AETK/AEGP/Util/AssetManager.hpp"
+#include "AETK/AEGP/Util/Context.hpp"
 #include "AETK/AEGP/Util/Factories.hpp"
+#include "AETK/AEGP/Util/ProjectIndex.hpp"
 
 tk::shared_ptr<Item> Item::activeItem()
 {
@@ -22,6 +24,24 @@ std::string Item::typeName()
     return typeName;
 }
 
+A_long Item::id()
+{
+    {
+        std::lock_guard<std::mutex> lock(*m_cacheMutex);
+        if (m_id)
+        {
+            return *m_id;
+        }
+    }
+    A_long id = ItemSuite().GetItemID(m_item);
+    std::lock_guard<std::mutex> lock(*m_cacheMutex);
+    if (!m_id)
+    {
+        m_id = id;
+    }
+    return *m_id;
+}
+
 bool Item::isSelected()
 {
     auto isSelected = ItemSuite().IsItemSelected(m_item);
@@ -106,6 +126,7 @@ std::string Item::name()
 void Item::setName(const std::string &name)
 {
     ItemSuite().SetItemName(m_item, name);
+    ProjectIndex::invalidate();
 }
 
 void Item::setProxyUse(bool useProxy)
@@ -122,6 +143,7 @@ tk::shared_ptr<Item> Item::parentFolder()
 void Item::setParentFolder(tk::shared_ptr<Item> folder)
 {
     ItemSuite().SetItemParentFolder(m_item, folder->getItem());
+    ProjectIndex::invalidate();
 }
 
 double Item::duration()
@@ -180,19 +202,25 @@ double Item::pixelAspect()
 void Item::deleteItem()
 {
     ItemSuite().DeleteItem(m_item);
+    ProjectIndex::invalidate();
+    IdentityMap::GetInstance().forget(this);
 }
 
 FolderItem FolderItem::create(const std::string &name, tk::shared_ptr<Item> parentFolder)
 {
     auto folder = ItemSuite().CreateNewFolder(name, parentFolder->getItem());
+    ProjectIndex::invalidate();
     return FolderItem(folder);
 }
 
 tk::shared_ptr<ItemCollection> FolderItem::children()
 {
-    if (!m_children) {
-		m_children = std::make_shared<ItemCollection>(std::make_shared<FolderItem>(m_item));
-	}
+    auto index = ProjectIndex::current(ProjSuite().GetProjectByIndex(0));
+    if (!m_children || index != m_index)
+    {
+        m_children = std::make_shared<ItemCollection>(std::make_shared<FolderItem>(m_item), index);
+        m_index = index;
+    }
     return m_children;
 }
 
@@ -208,6 +236,7 @@ CompItem CompItem::create(const std::string &name, int width, int height, double
 
     auto comp = CompSuite().CreateComp(item->getItem(), name, width, height, {static_cast<int>(pixelAspect), 1},
                                        SecondsToTime(duration), {static_cast<int>(frameRate), 1});
+    ProjectIndex::invalidate();
     return CompItem(comp);
 }
 
@@ -221,6 +250,234 @@ tk::shared_ptr<LayerCollection> CompItem::layers()
     return m_layerCollection;
 }
 
+LayerRange CompItem::layerRange(size_t chunkSize)
+{
+    return LayerRange(m_comp, chunkSize);
+}
+
+tk::shared_ptr<MarkerProperty> CompItem::markers()
+{
+    auto stream = CompSuite().GetNewCompMarkerStream(m_comp);
+    return std::static_pointer_cast<MarkerProperty>(PropertyFactory::CreateProperty(stream));
+}
+
+namespace
+{
+
+// Sets a layer stream's value on a layer without keyframes. Main thread only.
+void setLayerStream(AEGP_SuiteHandler &suites, AEGP_PluginID pluginID, AEGP_LayerH layerH, AEGP_LayerStream which,
+                    const AEGP_StreamVal2 &val)
+{
+    AEGP_StreamRefH streamH = nullptr;
+    AE_CHECK(suites.StreamSuite6()->AEGP_GetNewLayerStream(pluginID, layerH, which, &streamH));
+    AEGP_StreamValue2 value{};
+    value.streamH = streamH;
+    value.val = val;
+    A_Err err = suites.StreamSuite6()->AEGP_SetStreamValue(pluginID, streamH, &value);
+    suites.StreamSuite2()->AEGP_DisposeStream(streamH);
+    AE_CHECK(err);
+}
+
+AEGP_StreamVal2 threeD(const ThreeDVal &v)
+{
+    AEGP_StreamVal2 val{};
+    val.three_d = {v.x, v.y, v.z};
+    return val;
+}
+
+AEGP_StreamVal2 oneD(double v)
+{
+    AEGP_StreamVal2 val{};
+    val.one_d = v;
+    return val;
+}
+
+} // namespace
+
+tk::vector<tk::shared_ptr<Layer>> CompItem::addLayers(const LayerSpec *specs, size_t count)
+{
+    if (count == 0)
+    {
+        return {};
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (specs[i].parent >= static_cast<int>(count) || specs[i].parent == static_cast<int>(i))
+        {
+            throw AEException("Error Adding Layers. Parent must be another spec in the same call");
+        }
+    }
+    // A cycle would only fail at AEGP_SetLayerParent, after every layer was created.
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t steps = 0;
+        for (int p = specs[i].parent; p >= 0; p = specs[p].parent)
+        {
+            if (++steps > count)
+            {
+                throw AEException("Error Adding Layers. Parents form a cycle");
+            }
+        }
+    }
+
+    struct Created
+    {
+        AEGP_LayerH layer;
+        AEGP_LayerIDVal id;
+        ObjectType type;
+    };
+
+    Scoped_Undo_Guard undo("Add Layers");
+    tk::vector<LayerSpec> batch(specs, specs + count);
+    auto future = ae::ScheduleOrExecute([comp = m_comp, batch = std::move(batch)]() {
+        CheckNotNull(comp.get(), "Error Adding Layers. Comp is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+        AEGP_ItemH compItemH;
+        AE_CHECK(suites.CompSuite11()->AEGP_GetItemFromComp(*comp, &compItemH));
+        A_long compWidth, compHeight;
+        AE_CHECK(suites.ItemSuite9()->AEGP_GetItemDimensions(compItemH, &compWidth, &compHeight));
+        A_Time frameDuration;
+        AE_CHECK(suites.CompSuite11()->AEGP_GetCompFrameDuration(*comp, &frameDuration));
+        auto toTime = [&](double seconds) {
+            return A_Time{static_cast<A_long>(std::llround(seconds * frameDuration.scale)), frameDuration.scale};
+        };
+
+        // Validate first, so a bad source leaves the comp untouched.
+        for (const auto &spec : batch)
+        {
+            if (spec.kind != LayerSpec::Kind::Source)
+            {
+                continue;
+            }
+            CheckNotNull(spec.source.get(), "Error Adding Layers. Source Item is Null");
+            A_Boolean valid = FALSE;
+            AE_CHECK(suites.LayerSuite9()->AEGP_IsAddLayerValid(*spec.source, *comp, &valid));
+            if (!valid)
+            {
+                throw AEException("Error Adding Layers. Item cannot be added to this comp");
+            }
+        }
+
+        // New layers go on top, so create bottom-up to keep spec order.
+        tk::vector<Created> created(batch.size());
+        const A_FloatPoint center{compWidth / 2.0, compHeight / 2.0};
+        for (size_t i = batch.size(); i-- > 0;)
+        {
+            const auto &spec = batch[i];
+            std::vector<A_UTF16Char> name16 = ConvertUTF8ToUTF16(spec.name);
+            AEGP_LayerH layerH = nullptr;
+            switch (spec.kind)
+            {
+            case LayerSpec::Kind::Source:
+                AE_CHECK(suites.LayerSuite9()->AEGP_AddLayer(*spec.source, *comp, &layerH));
+                if (!spec.name.empty())
+                {
+                    AE_CHECK(suites.LayerSuite9()->AEGP_SetLayerName(layerH, name16.data()));
+                }
+                break;
+            case LayerSpec::Kind::Solid: {
+                ColorVal color = spec.color;
+                AEGP_ColorVal aeColor = color.toAEGP();
+                AE_CHECK(suites.CompSuite11()->AEGP_CreateSolidInComp(
+                    name16.data(), spec.width > 0 ? spec.width : compWidth, spec.height > 0 ? spec.height : compHeight,
+                    &aeColor, *comp, nullptr, &layerH));
+                break;
+            }
+            case LayerSpec::Kind::Null:
+                AE_CHECK(suites.CompSuite11()->AEGP_CreateNullInComp(name16.data(), *comp, nullptr, &layerH));
+                break;
+            case LayerSpec::Kind::Camera:
+                AE_CHECK(suites.CompSuite11()->AEGP_CreateCameraInComp(name16.data(), center, *comp, &layerH));
+                break;
+            case LayerSpec::Kind::Light:
+                AE_CHECK(suites.CompSuite11()->AEGP_CreateLightInComp(name16.data(), center, *comp, &layerH));
+                break;
+            }
+            created[i].layer = layerH;
+        }
+
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            const auto &spec = batch[i];
+            AEGP_LayerH layerH = created[i].layer;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &created[i].id));
+            AEGP_ObjectType type;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerObjectType(layerH, &type));
+            created[i].type = ObjectType(type);
+
+            if (spec.threeD && type != AEGP_ObjectType_CAMERA && type != AEGP_ObjectType_LIGHT)
+            {
+                AE_CHECK(suites.LayerSuite9()->AEGP_SetLayerFlag(layerH, AEGP_LayerFlag_LAYER_IS_3D, TRUE));
+            }
+            if (spec.inPoint || spec.outPoint)
+            {
+                A_Time inPoint, duration;
+                AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerInPoint(layerH, AEGP_LTimeMode_CompTime, &inPoint));
+                AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerDuration(layerH, AEGP_LTimeMode_CompTime, &duration));
+                // The side that is not given keeps AE's exact time, rather than a round trip through seconds.
+                A_Time newIn = spec.inPoint ? toTime(*spec.inPoint) : inPoint;
+                ae::RationalTime out = spec.outPoint ? ae::RationalTime(toTime(*spec.outPoint))
+                                                     : ae::RationalTime(inPoint) + ae::RationalTime(duration);
+                A_Time newDuration = std::max(ae::RationalTime(), out - ae::RationalTime(newIn)).toAEGP();
+                AE_CHECK(suites.LayerSuite9()->AEGP_SetLayerInPointAndDuration(layerH, AEGP_LTimeMode_CompTime,
+                                                                               &newIn, &newDuration));
+            }
+            if (spec.label)
+            {
+                AE_CHECK(suites.LayerSuite9()->AEGP_SetLayerLabel(layerH, AEGP_LabelID(*spec.label)));
+            }
+            if (spec.anchorPoint)
+            {
+                setLayerStream(suites, pluginID, layerH, AEGP_LayerStream_ANCHORPOINT, threeD(*spec.anchorPoint));
+            }
+            if (spec.position)
+            {
+                setLayerStream(suites, pluginID, layerH, AEGP_LayerStream_POSITION, threeD(*spec.position));
+            }
+            if (spec.scale)
+            {
+                setLayerStream(suites, pluginID, layerH, AEGP_LayerStream_SCALE, threeD(*spec.scale));
+            }
+            if (spec.rotation)
+            {
+                setLayerStream(suites, pluginID, layerH, AEGP_LayerStream_ROTATION, oneD(*spec.rotation));
+            }
+            if (spec.opacity)
+            {
+                setLayerStream(suites, pluginID, layerH, AEGP_LayerStream_OPACITY, oneD(*spec.opacity));
+            }
+        }
+
+        // Parents last, once every layer exists.
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            if (batch[i].parent >= 0)
+            {
+                AE_CHECK(suites.LayerSuite9()->AEGP_SetLayerParent(created[i].layer, created[batch[i].parent].layer));
+            }
+        }
+
+        AEGP_ProjectH projectH;
+        AE_CHECK(suites.ProjSuite6()->AEGP_GetProjectByIndex(0, &projectH));
+        return std::make_pair(projectH, std::move(created));
+    });
+    auto [projectH, created] = future.get();
+
+    // Solids and nulls add items to the project.
+    ProjectIndex::invalidate();
+
+    tk::vector<tk::shared_ptr<Layer>> result;
+    result.reserve(created.size());
+    auto &map = IdentityMap::GetInstance();
+    for (const auto &layer : created)
+    {
+        result.push_back(map.layer(projectH, makeLayerPtr(layer.layer), *m_comp, layer.id, layer.type));
+    }
+    return result;
+}
+
 DownsampleFactor CompItem::downsampleFactor()
 {
     auto factor = CompSuite().GetCompDownsampleFactor(m_comp);
@@ -287,6 +544,7 @@ FootageItem FootageItem::create(std::string path, std::string name)
 {
 
     auto footage = AssetManager().import(path, name);
+    ProjectIndex::invalidate();
 
     return FootageItem(footage);
 }
@@ -297,6 +555,7 @@ FootageItem FootageItem::createPlaceholder(const std::string &path, int width, i
 
     auto footage = FootageSuite().newPlaceholderFootage(path, width, height, SecondsToTime(duration));
     auto footageItem = FootageSuite().addFootageToProject(footage, NULL);
+    ProjectIndex::invalidate();
 
     return FootageItem(footageItem);
 }
@@ -305,6 +564,7 @@ FootageItem FootageItem::createSolid(const std::string &name, int width, int hei
 {
     auto footage = FootageSuite().newSolidFootage(name, width, height, color);
     auto footageItem = FootageSuite().addFootageToProject(footage, NULL);
+    ProjectIndex::invalidate();
     return FootageItem(footageItem);
 }
 
@@ -335,4 +595,5 @@ void FootageItem::replaceFromPath(std::string path)
 {
     auto item = AssetManager().import(path, "");
     FootageSuite().replaceItemMainFootage(m_footage, item);
+    ProjectIndex::invalidate();
 }
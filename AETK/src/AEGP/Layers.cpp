@@ -10,6 +10,26 @@ tk::shared_ptr<BaseProperty> Layer::getProperty(LayerStream stream)
     return PropertyFactory::CreateProperty(property);
 }
 
+tk::shared_ptr<BaseProperty> Layer::property(const std::string &path)
+{
+    std::shared_ptr<PropertyPathCache> cache;
+    {
+        std::lock_guard<std::mutex> lock(*m_cacheMutex);
+        cache = m_pathCache;
+    }
+    if (!cache)
+    {
+        auto created = std::make_shared<PropertyPathCache>(getStream()); // getStream() may wait for the main thread
+        std::lock_guard<std::mutex> lock(*m_cacheMutex);
+        if (!m_pathCache)
+        {
+            m_pathCache = created;
+        }
+        cache = m_pathCache;
+    }
+    return cache->get(path);
+}
+
 tk::shared_ptr<ThreeDProperty> Layer::Position()
 {
     auto property = getProperty(LayerStream::POSITION);
@@ -232,6 +252,24 @@ void Layer::setName(const std::string &name)
     LayerSuite().SetLayerName(m_layer, name);
 }
 
+AEGP_LayerIDVal Layer::id()
+{
+    {
+        std::lock_guard<std::mutex> lock(*m_cacheMutex);
+        if (m_id)
+        {
+            return *m_id;
+        }
+    }
+    AEGP_LayerIDVal id = LayerSuite().GetLayerID(m_layer);
+    std::lock_guard<std::mutex> lock(*m_cacheMutex);
+    if (!m_id)
+    {
+        m_id = id;
+    }
+    return *m_id;
+}
+
 int Layer::getIndex()
 {
     return LayerSuite().GetLayerIndex(m_layer);
@@ -250,8 +288,18 @@ tk::shared_ptr<Item> Layer::sourceItem()
 
 tk::shared_ptr<CompItem> Layer::parentComp()
 {
+    {
+        std::lock_guard<std::mutex> lock(*m_cacheMutex);
+        if (auto cached = m_parentComp.lock())
+        {
+            return cached;
+        }
+    }
     auto comp = LayerSuite().GetLayerParentComp(m_layer);
-    return std::make_shared<CompItem>(comp);
+    auto item = std::dynamic_pointer_cast<CompItem>(ItemFactory::createItem(CompSuite().GetItemFromComp(comp)));
+    std::lock_guard<std::mutex> lock(*m_cacheMutex);
+    m_parentComp = item; // Both racers got the same wrapper from the IdentityMap
+    return item;
 }
 
 LayerQual Layer::getQuality()
@@ -313,13 +361,20 @@ double Layer::stretch()
 
 void Layer::setStretch(double stretch) {}
 
-// TODO Implement Tis
+ae::LayerTimeMap Layer::timeMap()
+{
+    return ae::LayerTimeMap::fromLayer(m_layer);
+}
+
 bool Layer::isFlagSet(LayerFlag flag)
 {
-    return false;
+    return (int(LayerSuite().GetLayerFlags(m_layer)) & int(flag)) != 0;
+}
+
+void Layer::setFlag(LayerFlag flag, bool value)
+{
+    LayerSuite().SetLayerFlag(m_layer, flag, value);
 }
-// TODO Implement Tis
-void Layer::setFlag(LayerFlag flag, bool value) {}
 
 bool Layer::is3DLayer()
 {
@@ -357,6 +412,7 @@ tk::shared_ptr<Layer> Layer::duplicate()
 void Layer::Delete()
 {
     LayerSuite().DeleteLayer(m_layer);
+    IdentityMap::GetInstance().forget(this);
 }
 
 LayerSamplingQual Layer::getSamplingQuality()
@@ -499,3 +555,68 @@ tk::shared_ptr<OneDProperty> LightLayer::LightFalloffDistance()
     auto property = getProperty(LayerStream::LIGHT_FALLOFF_DISTANCE);
     return std::static_pointer_cast<OneDProperty>(property);
 }
+
+TextOutlineData TextLayer::outlines(double time) const
+{
+    return std::move(outlines(tk::vector<double>{time}).front());
+}
+
+tk::vector<TextOutlineData> TextLayer::outlines(const tk::vector<double> &times) const
+{
+    if (times.empty())
+    {
+        return {};
+    }
+    auto future = ae::ScheduleOrExecute([layer = m_layer, &times]() {
+        CheckNotNull(layer.get(), "Error Getting Text Outlines. Layer is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+
+        AEGP_CompH compH = nullptr;
+        A_Time frameDuration;
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerParentComp(*layer, &compH));
+        AE_CHECK(suites.CompSuite11()->AEGP_GetCompFrameDuration(compH, &frameDuration));
+        const A_u_long scale = frameDuration.scale;
+
+        tk::vector<TextOutlineData> result(times.size());
+        for (size_t t = 0; t < times.size(); ++t)
+        {
+            A_Time time{static_cast<A_long>(std::llround(times[t] * scale)), scale};
+            AEGP_TextOutlinesH outlinesH = nullptr;
+            AE_CHECK(suites.TextLayerSuite1()->AEGP_GetNewTextOutlines(*layer, &time, &outlinesH));
+            auto outlines = makeTextOutlinesPtr(outlinesH); // Disposed when it goes out of scope
+
+            A_long numPaths = 0;
+            AE_CHECK(suites.TextLayerSuite1()->AEGP_GetNumTextOutlines(outlinesH, &numPaths));
+            auto &data = result[t];
+            data.closed.reserve(numPaths);
+            data.offsets.reserve(numPaths + 1);
+            for (A_long p = 0; p < numPaths; ++p)
+            {
+                PF_PathOutlinePtr path = nullptr;
+                PF_Boolean open = FALSE;
+                A_long numSegments = 0;
+                AE_CHECK(suites.TextLayerSuite1()->AEGP_GetIndexedTextOutline(outlinesH, p, &path));
+                AE_CHECK(suites.PathDataSuite1()->PF_PathIsOpen(nullptr, path, &open));
+                AE_CHECK(suites.PathDataSuite1()->PF_PathNumSegments(nullptr, path, &numSegments));
+
+                // Closed paths repeat vertex 0 after the last segment; it is not stored twice.
+                A_long numVertices = numSegments == 0 ? 0 : (open ? numSegments + 1 : numSegments);
+                for (A_long v = 0; v < numVertices; ++v)
+                {
+                    PF_PathVertex vertex;
+                    AE_CHECK(suites.PathDataSuite1()->PF_PathVertexInfo(nullptr, path, v, &vertex));
+                    data.x.push_back(vertex.x);
+                    data.y.push_back(vertex.y);
+                    data.inX.push_back(vertex.tan_in_x);
+                    data.inY.push_back(vertex.tan_in_y);
+                    data.outX.push_back(vertex.tan_out_x);
+                    data.outY.push_back(vertex.tan_out_y);
+                }
+                data.offsets.push_back(data.x.size());
+                data.closed.push_back(open ? 0 : 1);
+            }
+        }
+        return result;
+    });
+    return future.get();
+}
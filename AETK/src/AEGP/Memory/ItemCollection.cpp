@@ -1,6 +1,7 @@
 #include "AETK/AEGP/Template/ItemCollection.hpp"
 #include "AETK/AEGP/Items.hpp"
 #include "AETK/AEGP/Util/Factories.hpp"
+#include "AETK/AEGP/Util/ProjectIndex.hpp"
 
 void ItemCollection::append(tk::shared_ptr<Item> item)
 {
@@ -67,15 +68,21 @@ tk::vector<tk::shared_ptr<Item>> ItemCollection::slice(int start)
 
 void ItemCollection::createCollection()
 {
-    auto proj = ProjSuite().GetProjectByIndex(0);
-    auto currentItem = this->baseItem->getItem();
-    while (&currentItem != NULL)
+    createCollection(ProjectIndex::current(ProjSuite().GetProjectByIndex(0)));
+}
+
+void ItemCollection::createCollection(const tk::shared_ptr<const ProjectIndex> &index)
+{
+    int folder = index->find(baseItem->getItem());
+    if (folder == -1)
     {
-        if (ItemSuite().GetItemParentFolder(currentItem) == baseItem->getItem())
-        {
-            m_collection.push_back(ItemFactory::createItem(currentItem));
-        }
-        currentItem = ItemSuite().GetNextProjItem(proj, currentItem);
+        return;
+    }
+    auto children = index->children(folder);
+    m_collection.reserve(m_collection.size() + children.size());
+    for (int child : children)
+    {
+        m_collection.push_back(index->createItem(child));
     }
 }
 
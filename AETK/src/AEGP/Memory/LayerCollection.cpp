@@ -1,6 +1,75 @@
 #include "AETK/AEGP/Template/LayerCollection.hpp"
 #include "AETK/AEGP/Items.hpp"
 #include "AETK/AEGP/Layers.hpp"
+#include "AETK/AEGP/Util/Context.hpp"
+#include "AETK/AEGP/Util/Factories.hpp"
+
+namespace
+{
+
+// Moves that turn current into target (the same layers in a new order), as
+// (layer, new index) pairs for AEGP_ReorderLayer. Layers on a longest
+// increasing subsequence of current (ranked by target position) stay put and
+// every other layer is moved once, right below its target predecessor.
+tk::vector<std::pair<AEGP_LayerH, A_long>> planReorder(const tk::vector<AEGP_LayerH> &current,
+                                                       const tk::vector<AEGP_LayerH> &target)
+{
+    const int n = static_cast<int>(current.size());
+    std::unordered_map<AEGP_LayerH, int> rank;
+    for (int i = 0; i < n; ++i)
+    {
+        rank.emplace(target[i], i);
+    }
+    tk::vector<int> seq(n);
+    for (int k = 0; k < n; ++k)
+    {
+        seq[k] = rank.at(current[k]);
+    }
+
+    tk::vector<int> tails, prev(n, -1);
+    for (int k = 0; k < n; ++k)
+    {
+        auto it = std::lower_bound(tails.begin(), tails.end(), seq[k], [&](int t, int v) { return seq[t] < v; });
+        if (it != tails.begin())
+        {
+            prev[k] = *(it - 1);
+        }
+        if (it == tails.end())
+        {
+            tails.push_back(k);
+        }
+        else
+        {
+            *it = k;
+        }
+    }
+    tk::vector<char> keep(n, 0);
+    for (int k = tails.empty() ? -1 : tails.back(); k != -1; k = prev[k])
+    {
+        keep[seq[k]] = 1;
+    }
+
+    tk::vector<AEGP_LayerH> order(current);
+    tk::vector<std::pair<AEGP_LayerH, A_long>> moves;
+    for (int r = 0; r < n; ++r)
+    {
+        if (keep[r])
+        {
+            continue;
+        }
+        order.erase(std::find(order.begin(), order.end(), target[r]));
+        A_long at = 0;
+        if (r > 0)
+        {
+            at = static_cast<A_long>(std::find(order.begin(), order.end(), target[r - 1]) - order.begin()) + 1;
+        }
+        order.insert(order.begin() + at, target[r]);
+        moves.emplace_back(target[r], at);
+    }
+    return moves;
+}
+
+} // namespace
 
 //    tk::shared_ptr<CompItem> baseComp;
 void LayerCollection::append(tk::shared_ptr<Item> item)
@@ -34,13 +103,13 @@ void LayerCollection::insert(size_t index, tk::shared_ptr<Layer> layer)
 
 void LayerCollection::remove(tk::shared_ptr<Layer> layer)
 {
-    LayerSuite().DeleteLayer(layer->getLayer());
+    layer->Delete(); // Also drops it from the IdentityMap
     m_collection.erase(std::remove(m_collection.begin(), m_collection.end(), layer), m_collection.end());
 }
 
 void LayerCollection::pop(size_t index)
 {
-    LayerSuite().DeleteLayer(m_collection[index]->getLayer());
+    m_collection[index]->Delete();
     m_collection.erase(m_collection.begin() + index);
 }
 
@@ -48,7 +117,7 @@ void LayerCollection::clear()
 {
     for (auto layer : m_collection)
     {
-        LayerSuite().DeleteLayer(layer->getLayer());
+        layer->Delete();
     }
     m_collection.clear();
 }
@@ -75,35 +144,94 @@ tk::vector<tk::shared_ptr<Layer>> LayerCollection::slice(int start)
 
 void LayerCollection::reverse()
 {
-    for (int i = 0; i < m_collection.size(); i++)
-    {
-        LayerSuite().ReorderLayer(m_collection[i]->getLayer(), static_cast<int>(m_collection.size()) - i);
-    }
-    std::reverse(m_collection.begin(), m_collection.end());
+    auto target = m_collection;
+    std::reverse(target.begin(), target.end());
+    reorder(target, "Reverse Layers");
 }
 
 void LayerCollection::sort(std::function<bool(tk::shared_ptr<Layer>, tk::shared_ptr<Layer>)> compare)
 {
-    // std::sort(m_collection.begin(), m_collection.end(), compare);
-    for (int i = 0; i < m_collection.size(); i++)
+    auto target = m_collection;
+    std::stable_sort(target.begin(), target.end(), compare);
+    reorder(target, "Sort Layers");
+}
+
+void LayerCollection::reorder(const tk::vector<tk::shared_ptr<Layer>> &target, const std::string &undoName)
+{
+    if (target.size() < 2)
+    {
+        m_collection = target;
+        m_lastReorderCount = 0;
+        return;
+    }
+
+    tk::vector<AEGP_LayerH> layers;
+    layers.reserve(target.size());
+    for (const auto &layer : target)
     {
-        for (int j = i + 1; j < m_collection.size(); j++)
+        layers.push_back(*layer->getLayer());
+    }
+
+    Scoped_Undo_Guard undo(undoName);
+    auto future = ae::ScheduleOrExecute([comp = baseComp, layers]() {
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+
+        AEGP_CompH compH = comp ? AEGP_CompH(*comp) : nullptr;
+        if (!compH)
+        {
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerParentComp(layers.front(), &compH));
+        }
+
+        // Plan against the whole comp, so a collection holding only some of its
+        // layers is sorted within the slots those layers already occupy.
+        A_long numLayers = 0;
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers));
+        tk::vector<AEGP_LayerH> current(numLayers);
+        for (A_long i = 0; i < numLayers; ++i)
+        {
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, i, &current[i]));
+        }
+
+        // Layers that are no longer in the comp are skipped.
+        std::unordered_set<AEGP_LayerH> members(current.begin(), current.end());
+        tk::vector<AEGP_LayerH> ordered;
+        for (auto layerH : layers)
         {
-            if (compare(m_collection[i], m_collection[j]))
+            if (members.erase(layerH))
             {
-                LayerSuite().ReorderLayer(m_collection[i]->getLayer(), j);
-                std::swap(m_collection[i], m_collection[j]);
+                ordered.push_back(layerH);
             }
         }
-    }
+        std::unordered_set<AEGP_LayerH> sorted(ordered.begin(), ordered.end());
+        tk::vector<AEGP_LayerH> desired(current);
+        auto next = ordered.begin();
+        for (auto &slot : desired)
+        {
+            if (sorted.count(slot))
+            {
+                slot = *next++;
+            }
+        }
+
+        auto moves = planReorder(current, desired);
+        for (const auto &[layerH, index] : moves)
+        {
+            AE_CHECK(suites.LayerSuite9()->AEGP_ReorderLayer(layerH, index));
+        }
+        return moves.size();
+    });
+    m_lastReorderCount = future.get();
+    m_collection = target;
 }
 
 void LayerCollection::createCollection()
 {
-    int numLayers = LayerSuite().GetCompNumLayers(baseComp);
-    for (int i = 0; i < numLayers; i++)
+    // One chunk covering the whole comp: a single task for every handle and type.
+    LayerRange range(baseComp, std::numeric_limits<size_t>::max());
+    m_collection.reserve(range.size());
+    for (auto layer : range)
     {
-        m_collection.push_back(std::make_shared<Layer>(LayerSuite().GetCompLayerByIndex(baseComp, i)));
+        m_collection.push_back(layer);
     }
 }
 
@@ -119,3 +247,91 @@ tk::vector<tk::shared_ptr<Layer>> LayerCollection::find(const std::function<bool
 	}
 	return newCollection;
 }
+
+tk::shared_ptr<Layer> LayerCollection::findFirst(const std::function<bool(tk::shared_ptr<Layer>)> &predicate)
+{
+    for (auto layer : m_collection)
+    {
+        if (predicate(layer))
+        {
+            return layer;
+        }
+    }
+    return nullptr;
+}
+
+size_t LayerRange::size()
+{
+    if (!m_counted)
+    {
+        fetch(0);
+    }
+    return m_layers.size();
+}
+
+tk::shared_ptr<Layer> LayerRange::at(size_t index)
+{
+    if (!m_counted || (index < m_layers.size() && !m_layers[index]))
+    {
+        fetch(index);
+    }
+    return m_layers.at(index);
+}
+
+tk::shared_ptr<Layer> LayerRange::find(const std::function<bool(tk::shared_ptr<Layer>)> &predicate)
+{
+    for (auto layer : *this)
+    {
+        if (predicate(layer))
+        {
+            return layer;
+        }
+    }
+    return nullptr;
+}
+
+void LayerRange::fetch(size_t index)
+{
+    size_t start = index - index % m_chunkSize;
+    size_t chunkSize = m_chunkSize;
+    auto future = ae::ScheduleOrExecute([comp = m_comp, start, chunkSize]() {
+        CheckNotNull(comp.get(), "Error Fetching Layers. Comp is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+
+        AEGP_ProjectH projectH;
+        AE_CHECK(suites.ProjSuite6()->AEGP_GetProjectByIndex(0, &projectH));
+        A_long numLayers = 0;
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetCompNumLayers(*comp, &numLayers));
+
+        size_t end = std::min(static_cast<size_t>(numLayers), start + std::min(chunkSize, size_t(numLayers)));
+        tk::vector<std::tuple<AEGP_LayerH, AEGP_LayerIDVal, AEGP_ObjectType>> chunk;
+        for (size_t i = start; i < end; ++i)
+        {
+            AEGP_LayerH layerH;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(*comp, static_cast<A_long>(i), &layerH));
+            AEGP_LayerIDVal id;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &id));
+            AEGP_ObjectType type;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerObjectType(layerH, &type));
+            chunk.emplace_back(layerH, id, type);
+        }
+        return std::make_tuple(projectH, static_cast<size_t>(numLayers), std::move(chunk));
+    });
+    auto [projectH, numLayers, chunk] = future.get();
+
+    if (!m_counted)
+    {
+        m_layers.resize(numLayers);
+        m_counted = true;
+    }
+    for (size_t i = 0; i < chunk.size() && start + i < m_layers.size(); ++i)
+    {
+        if (!m_layers[start + i])
+        {
+            auto [layerH, id, type] = chunk[i];
+            m_layers[start + i] =
+                IdentityMap::GetInstance().layer(projectH, makeLayerPtr(layerH), *m_comp, id, ObjectType(type));
+            ++m_fetched;
+        }
+    }
+}
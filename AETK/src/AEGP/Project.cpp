@@ -1,6 +1,7 @@
 #include "AETK/AEGP/Project.hpp"
 #include "AETK/AEGP/Items.hpp"
 #include "AETK/AEGP/Template/ItemCollection.hpp"
+#include "AETK/AEGP/Util/ProjectIndex.hpp"
 
 Project Project::open(const std::string &path)
 {
@@ -21,12 +22,13 @@ Project Project::newProject(const std::string &path)
 
 tk::shared_ptr<ItemCollection> Project::items()
 {
-    if (!m_itemCollection)
+    auto index = ProjectIndex::current(m_proj);
+    if (!m_itemCollection || index != m_index)
     {
-        auto folder = ProjSuite().GetProjectRootFolder(m_proj);
-        auto item = tk::make_shared<Item>(folder);
-        m_itemCollection = tk::make_shared<ItemCollection>(item);
-	}
+        auto item = tk::make_shared<Item>(index->item(index->root()));
+        m_itemCollection = tk::make_shared<ItemCollection>(item, index);
+        m_index = index;
+    }
     return m_itemCollection;
 }
 
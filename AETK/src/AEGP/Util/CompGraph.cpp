@@ -0,0 +1,308 @@
+#include "AETK/AEGP/Util/CompGraph.hpp"
+
+namespace
+{
+
+// Source, parent and track matte of every layer in a comp item. Main thread only.
+tk::vector<CompGraph::LayerEdges> readLayers(AEGP_SuiteHandler &suites, AEGP_ItemH itemH)
+{
+    AEGP_CompH compH = nullptr;
+    AE_CHECK(suites.CompSuite11()->AEGP_GetCompFromItem(itemH, &compH));
+    A_long numLayers = 0;
+    AE_CHECK(suites.LayerSuite9()->AEGP_GetCompNumLayers(compH, &numLayers));
+
+    tk::vector<CompGraph::LayerEdges> layers(numLayers);
+    for (A_long i = 0; i < numLayers; ++i)
+    {
+        auto &edges = layers[i];
+        AEGP_LayerH layerH;
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(compH, i, &layerH));
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &edges.layer));
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerSourceItemID(layerH, &edges.source));
+
+        AEGP_LayerH parentH = nullptr;
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerParent(layerH, &parentH));
+        if (parentH)
+        {
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerID(parentH, &edges.parent));
+        }
+
+        // Any layer of the comp may be the matte, not only the one above.
+        AEGP_LayerH matteH = nullptr;
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetTrackMatteLayer(layerH, &matteH));
+        if (matteH)
+        {
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerID(matteH, &edges.trackMatte));
+            AEGP_LayerTransferMode mode;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerTransferMode(layerH, &mode));
+            edges.matteMode = TrackMatte(mode.track_matte);
+        }
+    }
+    return layers;
+}
+
+// Reads the layers of each comp in one task.
+tk::vector<tk::vector<CompGraph::LayerEdges>> readComps(const tk::vector<AEGP_ItemH> &comps)
+{
+    if (comps.empty())
+    {
+        return {};
+    }
+    auto future = ae::ScheduleOrExecute([comps]() {
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        tk::vector<tk::vector<CompGraph::LayerEdges>> result;
+        result.reserve(comps.size());
+        for (AEGP_ItemH itemH : comps)
+        {
+            result.push_back(readLayers(suites, itemH));
+        }
+        return result;
+    });
+    return future.get();
+}
+
+} // namespace
+
+void CompGraph::build(const tk::shared_ptr<const ProjectIndex> &index)
+{
+    m_ids.clear();
+    m_types.clear();
+    m_handles.clear();
+    m_layers.clear();
+    m_byID.clear();
+    sync(index);
+}
+
+void CompGraph::update(A_long compID)
+{
+    int n = find(compID);
+    if (n < 0 || m_types[n] != ItemType::COMP)
+    {
+        return;
+    }
+    m_layers[n] = std::move(readComps({m_handles[n]}).front());
+    link();
+}
+
+void CompGraph::sync(const tk::shared_ptr<const ProjectIndex> &index)
+{
+    CheckNotNull(index.get(), "Error Building Comp Graph. Index is Null");
+
+    tk::vector<A_long> ids;
+    tk::vector<ItemType> types;
+    tk::vector<AEGP_ItemH> handles;
+    tk::vector<tk::vector<LayerEdges>> layers;
+    tk::vector<int> unread; // New comps, as positions in the arrays above
+    for (int i = 0; i < index->size(); ++i)
+    {
+        ItemType type = index->type(i);
+        if (type != ItemType::COMP && type != ItemType::FOOTAGE)
+        {
+            continue;
+        }
+        int old = find(index->id(i));
+        if (type == ItemType::COMP && (old < 0 || m_types[old] != ItemType::COMP))
+        {
+            unread.push_back(static_cast<int>(ids.size()));
+        }
+        ids.push_back(index->id(i));
+        types.push_back(type);
+        handles.push_back(index->handle(i));
+        layers.push_back(old >= 0 ? std::move(m_layers[old]) : tk::vector<LayerEdges>());
+    }
+
+    tk::vector<AEGP_ItemH> toRead;
+    toRead.reserve(unread.size());
+    for (int n : unread)
+    {
+        toRead.push_back(handles[n]);
+    }
+    auto read = readComps(toRead);
+    for (size_t k = 0; k < unread.size(); ++k)
+    {
+        layers[unread[k]] = std::move(read[k]);
+    }
+
+    m_index = index;
+    m_ids = std::move(ids);
+    m_types = std::move(types);
+    m_handles = std::move(handles);
+    m_layers = std::move(layers);
+    m_byID.clear();
+    for (int n = 0; n < size(); ++n)
+    {
+        m_byID.emplace(m_ids[n], n);
+    }
+    link();
+}
+
+int CompGraph::find(A_long id) const
+{
+    auto it = m_byID.find(id);
+    return it != m_byID.end() ? it->second : -1;
+}
+
+void CompGraph::link()
+{
+    const int n = size();
+    m_dependencies.assign(n, {});
+    m_dependents.assign(n, {});
+    m_order.clear();
+    m_levels.clear();
+    m_cyclic.clear();
+
+    for (int node = 0; node < n; ++node)
+    {
+        auto &deps = m_dependencies[node];
+        for (const auto &layer : m_layers[node])
+        {
+            int source = layer.source ? find(layer.source) : -1;
+            if (source >= 0)
+            {
+                deps.push_back(source);
+            }
+        }
+        std::sort(deps.begin(), deps.end());
+        deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+        for (int dep : deps)
+        {
+            m_dependents[dep].push_back(node);
+        }
+    }
+
+    // Kahn's algorithm, one level at a time.
+    tk::vector<int> remaining(n);
+    tk::vector<int> level;
+    for (int node = 0; node < n; ++node)
+    {
+        remaining[node] = static_cast<int>(m_dependencies[node].size());
+        if (remaining[node] == 0)
+        {
+            level.push_back(node);
+        }
+    }
+    m_order.reserve(n);
+    while (!level.empty())
+    {
+        tk::vector<int> next;
+        for (int node : level)
+        {
+            m_order.push_back(node);
+            for (int dependent : m_dependents[node])
+            {
+                if (--remaining[dependent] == 0)
+                {
+                    next.push_back(dependent);
+                }
+            }
+        }
+        m_levels.push_back(std::move(level));
+        level = std::move(next);
+    }
+    for (int node = 0; node < n; ++node)
+    {
+        if (remaining[node] > 0)
+        {
+            m_cyclic.push_back(node);
+            m_order.push_back(node);
+        }
+    }
+}
+
+bool CompGraph::reaches(int from, int to) const
+{
+    tk::vector<char> seen(size(), 0);
+    tk::vector<int> stack{from};
+    seen.at(from) = 1;
+    while (!stack.empty())
+    {
+        int node = stack.back();
+        stack.pop_back();
+        for (int dep : m_dependencies[node])
+        {
+            if (dep == to)
+            {
+                return true;
+            }
+            if (!seen[dep])
+            {
+                seen[dep] = 1;
+                stack.push_back(dep);
+            }
+        }
+    }
+    return false;
+}
+
+tk::vector<int> CompGraph::reachable(int from) const
+{
+    tk::vector<char> seen(size(), 0);
+    tk::vector<int> stack{from};
+    tk::vector<int> result;
+    seen.at(from) = 1;
+    while (!stack.empty())
+    {
+        int node = stack.back();
+        stack.pop_back();
+        for (int dep : m_dependencies[node])
+        {
+            if (!seen[dep])
+            {
+                seen[dep] = 1;
+                result.push_back(dep);
+                stack.push_back(dep);
+            }
+        }
+    }
+    return result;
+}
+
+tk::vector<int> CompGraph::unused(const tk::vector<int> &roots) const
+{
+    tk::vector<char> seen(size(), 0);
+    tk::vector<int> stack;
+    for (int root : roots)
+    {
+        if (!seen.at(root))
+        {
+            seen[root] = 1;
+            stack.push_back(root);
+        }
+    }
+    while (!stack.empty())
+    {
+        int node = stack.back();
+        stack.pop_back();
+        for (int dep : m_dependencies[node])
+        {
+            if (!seen[dep])
+            {
+                seen[dep] = 1;
+                stack.push_back(dep);
+            }
+        }
+    }
+
+    tk::vector<int> result;
+    for (int node = 0; node < size(); ++node)
+    {
+        if (!seen[node])
+        {
+            result.push_back(node);
+        }
+    }
+    return result;
+}
+
+tk::vector<int> CompGraph::unused() const
+{
+    tk::vector<int> result;
+    for (int node = 0; node < size(); ++node)
+    {
+        if (m_types[node] == ItemType::FOOTAGE && m_dependents[node].empty())
+        {
+            result.push_back(node);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,99 @@
+#include "AETK/AEGP/Util/CompQuery.hpp"
+
+namespace
+{
+
+StreamTable::Value toValue(const AEGP_StreamVal2 &value, AEGP_StreamType type)
+{
+    switch (StreamType(type))
+    {
+    case StreamType::OneD:
+        return value.one_d;
+    case StreamType::TwoD:
+    case StreamType::TwoD_SPATIAL:
+        return TwoDVal(value.two_d);
+    case StreamType::ThreeD:
+    case StreamType::ThreeD_SPATIAL:
+        return ThreeDVal(value.three_d);
+    case StreamType::COLOR:
+        return ColorVal(value.color);
+    default:
+        return std::monostate();
+    }
+}
+
+// AEGP_GetLayerStreamValue does not support these; they are left empty.
+bool hasNumericValue(LayerStream stream)
+{
+    return stream != LayerStream::MARKER && stream != LayerStream::SOURCE_TEXT;
+}
+
+// Reads the table at time, or at seconds snapped to the comp's own frame grid, in one task.
+StreamTable readValues(CompPtr comp, const tk::vector<LayerStream> &streams, std::optional<double> seconds,
+                       A_Time aeTime, bool preExpression)
+{
+    auto future = ae::ScheduleOrExecute([comp, streams, seconds, aeTime, preExpression]() mutable {
+        CheckNotNull(comp.get(), "Error Querying Comp Values. Comp is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+
+        if (seconds)
+        {
+            A_Time frameDuration;
+            AE_CHECK(suites.CompSuite11()->AEGP_GetCompFrameDuration(*comp, &frameDuration));
+            aeTime = ae::TimeContext(frameDuration).toTime(*seconds);
+        }
+
+        A_long numLayers = 0;
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetCompNumLayers(*comp, &numLayers));
+
+        StreamTable table;
+        table.streams = streams;
+        table.layers.reserve(numLayers);
+        table.layerIDs.reserve(numLayers);
+        table.cells.reserve(static_cast<size_t>(numLayers) * streams.size());
+
+        for (A_long i = 0; i < numLayers; ++i)
+        {
+            AEGP_LayerH layerH;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(*comp, i, &layerH));
+            AEGP_LayerIDVal id;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &id));
+            table.layers.push_back(makeLayerPtr(layerH));
+            table.layerIDs.push_back(id);
+
+            for (auto stream : streams)
+            {
+                A_Boolean legal = FALSE;
+                if (hasNumericValue(stream))
+                {
+                    AE_CHECK(suites.StreamSuite6()->AEGP_IsStreamLegal(layerH, AEGP_LayerStream(stream), &legal));
+                }
+                if (!legal)
+                {
+                    table.cells.emplace_back(std::monostate());
+                    continue;
+                }
+                AEGP_StreamVal2 value;
+                AEGP_StreamType type;
+                AE_CHECK(suites.StreamSuite6()->AEGP_GetLayerStreamValue(layerH, AEGP_LayerStream(stream),
+                                                                         AEGP_LTimeMode_CompTime, &aeTime,
+                                                                         preExpression, &value, &type));
+                table.cells.push_back(toValue(value, type));
+            }
+        }
+        return table;
+    });
+    return future.get();
+}
+
+} // namespace
+
+StreamTable CompQuery::values(double time, const tk::vector<LayerStream> &streams, bool preExpression) const
+{
+    return readValues(m_comp, streams, time, A_Time{0, 1}, preExpression);
+}
+
+StreamTable CompQuery::values(Time time, const tk::vector<LayerStream> &streams, bool preExpression) const
+{
+    return readValues(m_comp, streams, std::nullopt, time.toAEGP(), preExpression);
+}
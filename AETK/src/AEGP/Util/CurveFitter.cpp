@@ -0,0 +1,296 @@
+#include "AETK/AEGP/Util/CurveFitter.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+
+// With both handles at a third of the segment, AE's temporal bezier is exactly a cubic Hermite.
+constexpr double kInfluence = 100.0 / 3.0;
+
+class SegmentFitter
+{
+  public:
+    SegmentFitter(const ae::CurveSamples &samples, bool bezier)
+        : m_t(samples.times.data()), m_v(samples.values.data()), m_n(samples.size()), m_dims(samples.dimensions()),
+          m_bezier(bezier)
+    {
+        if (m_bezier)
+        {
+            computeVelocities();
+        }
+    }
+
+    const double *velocity(size_t i) const { return &m_vel[i * m_dims]; }
+
+    // Returns the sample in (a, b) furthest from the segment a-b and its distance.
+    std::pair<size_t, double> worst(size_t a, size_t b) const
+    {
+        size_t worstIndex = a;
+        double worstError = 0.0;
+        for (size_t k = a + 1; k < b; ++k)
+        {
+            double error = errorAt(a, b, k);
+            if (error > worstError)
+            {
+                worstError = error;
+                worstIndex = k;
+            }
+        }
+        return {worstIndex, worstError};
+    }
+
+  private:
+    void computeVelocities()
+    {
+        m_vel.assign(m_n * m_dims, 0.0);
+        if (m_n < 2)
+        {
+            return;
+        }
+        for (size_t i = 0; i < m_n; ++i)
+        {
+            size_t lo = i == 0 ? 0 : i - 1;
+            size_t hi = i == m_n - 1 ? i : i + 1;
+            double dt = m_t[hi] - m_t[lo];
+            for (int d = 0; d < m_dims; ++d)
+            {
+                m_vel[i * m_dims + d] = dt > 0.0 ? (m_v[hi * m_dims + d] - m_v[lo * m_dims + d]) / dt : 0.0;
+            }
+        }
+    }
+
+    double errorAt(size_t a, size_t b, size_t k) const
+    {
+        double dt = m_t[b] - m_t[a];
+        double u = dt > 0.0 ? (m_t[k] - m_t[a]) / dt : 0.0;
+        double sum = 0.0;
+
+        if (m_bezier)
+        {
+            double u2 = u * u, u3 = u2 * u;
+            double h00 = 2 * u3 - 3 * u2 + 1;
+            double h10 = u3 - 2 * u2 + u;
+            double h01 = -2 * u3 + 3 * u2;
+            double h11 = u3 - u2;
+            for (int d = 0; d < m_dims; ++d)
+            {
+                double fitted = h00 * m_v[a * m_dims + d] + h10 * dt * m_vel[a * m_dims + d] +
+                                h01 * m_v[b * m_dims + d] + h11 * dt * m_vel[b * m_dims + d];
+                double diff = fitted - m_v[k * m_dims + d];
+                sum += diff * diff;
+            }
+        }
+        else
+        {
+            for (int d = 0; d < m_dims; ++d)
+            {
+                double fitted = m_v[a * m_dims + d] + u * (m_v[b * m_dims + d] - m_v[a * m_dims + d]);
+                double diff = fitted - m_v[k * m_dims + d];
+                sum += diff * diff;
+            }
+        }
+        return std::sqrt(sum);
+    }
+
+    const double *m_t;
+    const double *m_v;
+    size_t m_n;
+    int m_dims;
+    bool m_bezier;
+    tk::vector<double> m_vel;
+};
+
+KeyFrame::TangentValue makeValue(StreamType type, const double *v, double scale = 1.0)
+{
+    switch (type)
+    {
+    case StreamType::OneD:
+        return v[0] * scale;
+    case StreamType::TwoD:
+    case StreamType::TwoD_SPATIAL:
+        return TwoDVal(v[0] * scale, v[1] * scale);
+    case StreamType::ThreeD:
+    case StreamType::ThreeD_SPATIAL:
+        return ThreeDVal(v[0] * scale, v[1] * scale, v[2] * scale);
+    case StreamType::COLOR:
+        return ColorVal(v[0] * scale, v[1] * scale, v[2] * scale, v[3] * scale);
+    default:
+        return std::monostate();
+    }
+}
+
+} // namespace
+
+namespace ae
+{
+
+int CurveSamples::dimensions() const
+{
+    switch (type)
+    {
+    case StreamType::OneD:
+        return 1;
+    case StreamType::TwoD:
+    case StreamType::TwoD_SPATIAL:
+        return 2;
+    case StreamType::ThreeD:
+    case StreamType::ThreeD_SPATIAL:
+        return 3;
+    case StreamType::COLOR:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+CurveFitResult CurveFitter::fit(const CurveSamples &samples) const
+{
+    auto start = std::chrono::steady_clock::now();
+
+    const int dims = samples.dimensions();
+    if (dims == 0)
+    {
+        throw std::invalid_argument("CurveFitter only supports OneD, TwoD, ThreeD and Color streams");
+    }
+    if (samples.values.size() != samples.times.size() * dims)
+    {
+        throw std::invalid_argument("CurveSamples values must hold dimensions() entries per sample");
+    }
+
+    CurveFitResult result;
+    result.numSamples = samples.size();
+    const size_t n = samples.size();
+    if (n == 0)
+    {
+        return result;
+    }
+
+    const bool bezier = m_options.mode == CurveFitMode::Bezier && (dims == 1 || samples.spatial());
+    SegmentFitter fitter(samples, bezier);
+
+    // Subdivide until every sample is within tolerance. An explicit stack keeps
+    // 100k-sample curves from blowing the call stack on pathological input.
+    tk::vector<char> keep(n, 0);
+    keep.front() = keep.back() = 1;
+    tk::vector<std::pair<size_t, size_t>> stack;
+    stack.emplace_back(0, n - 1);
+    while (!stack.empty())
+    {
+        auto [a, b] = stack.back();
+        stack.pop_back();
+        if (b - a < 2)
+        {
+            continue;
+        }
+        auto [k, error] = fitter.worst(a, b);
+        if (error > m_options.tolerance)
+        {
+            keep[k] = 1;
+            stack.emplace_back(a, k);
+            stack.emplace_back(k, b);
+        }
+        else
+        {
+            result.maxError = std::max(result.maxError, error);
+        }
+    }
+
+    tk::vector<size_t> indices;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (keep[i])
+        {
+            indices.push_back(i);
+        }
+    }
+
+    result.keys.reserve(indices.size());
+    for (size_t j = 0; j < indices.size(); ++j)
+    {
+        size_t i = indices[j];
+        KeyFrame key(samples.times[i], makeValue(samples.type, &samples.values[i * dims]));
+
+        if (!bezier)
+        {
+            key.setInterpolation(KeyInterp::LINEAR, KeyInterp::LINEAR);
+            result.keys.push_back(std::move(key));
+            continue;
+        }
+
+        const double *vel = fitter.velocity(i);
+        double speed = vel[0];
+        if (samples.spatial())
+        {
+            double sum = 0.0;
+            for (int d = 0; d < dims; ++d)
+            {
+                sum += vel[d] * vel[d];
+            }
+            speed = std::sqrt(sum);
+        }
+
+        key.setInterpolation(KeyInterp::BEZIER, KeyInterp::BEZIER);
+        key.setEaseIn(speed, kInfluence).setEaseOut(speed, kInfluence);
+        key.setFlag(KeyframeFlag::TEMPORAL_CONTINUOUS);
+
+        if (samples.spatial())
+        {
+            double dtIn = j > 0 ? samples.times[i] - samples.times[indices[j - 1]] : 0.0;
+            double dtOut = j + 1 < indices.size() ? samples.times[indices[j + 1]] - samples.times[i] : 0.0;
+            key.setFlag(KeyframeFlag::SPATIAL_CONTINUOUS);
+            key.tangents = std::make_pair(makeValue(samples.type, vel, -dtIn / 3.0),
+                                          makeValue(samples.type, vel, dtOut / 3.0));
+        }
+        result.keys.push_back(std::move(key));
+    }
+
+    result.fitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+tk::vector<CurveFitResult> CurveFitter::fit(const tk::vector<CurveSamples> &curves) const
+{
+    tk::vector<CurveFitResult> results(curves.size());
+    if (curves.empty())
+    {
+        return results;
+    }
+
+    unsigned int threads = m_options.maxThreads ? m_options.maxThreads : std::thread::hardware_concurrency();
+    threads = std::max(1u, std::min<unsigned int>(threads, static_cast<unsigned int>(curves.size())));
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < curves.size(); i = next++)
+        {
+            results[i] = fit(curves[i]);
+        }
+    };
+
+    tk::vector<std::future<void>> workers;
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        workers.push_back(std::async(std::launch::async, worker));
+    }
+    for (auto &w : workers)
+    {
+        w.get();
+    }
+    return results;
+}
+
+tk::vector<KeyframeTrack> CurveFitter::fitTracks(const tk::vector<CurveSamples> &curves) const
+{
+    auto results = fit(curves);
+    tk::vector<KeyframeTrack> tracks;
+    tracks.reserve(curves.size());
+    for (size_t i = 0; i < curves.size(); ++i)
+    {
+        tracks.push_back({curves[i].stream, std::move(results[i].keys)});
+    }
+    return tracks;
+}
+
+} // namespace ae
@@ -0,0 +1,130 @@
+#include "AETK/AEGP/Util/EffectRegistry.hpp"
+#include "AETK/AEGP/Layers.hpp"
+#include "AETK/AEGP/Util/Context.hpp"
+#include "AETK/AEGP/Util/Effects.hpp"
+#include "AETK/AEGP/Util/Properties.hpp"
+
+void EffectRegistry::refresh()
+{
+    A_long known;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        known = m_count;
+    }
+
+    auto future = ae::ScheduleOrExecute([known]() {
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        A_long count = 0;
+        AE_CHECK(suites.EffectSuite4()->AEGP_GetNumInstalledEffects(&count));
+
+        std::optional<tk::vector<InstalledEffect>> effects;
+        if (count == known)
+        {
+            return std::make_pair(count, effects);
+        }
+
+        effects.emplace();
+        effects->reserve(count);
+        AEGP_InstalledEffectKey key = AEGP_InstalledEffectKey_NONE;
+        for (A_long i = 0; i < count; ++i)
+        {
+            AE_CHECK(suites.EffectSuite4()->AEGP_GetNextInstalledEffect(key, &key));
+            A_char name[AEGP_MAX_EFFECT_NAME_SIZE];
+            A_char matchName[AEGP_MAX_EFFECT_MATCH_NAME_SIZE];
+            A_char category[AEGP_MAX_EFFECT_CATEGORY_NAME_SIZE];
+            AE_CHECK(suites.EffectSuite4()->AEGP_GetEffectName(key, name));
+            AE_CHECK(suites.EffectSuite4()->AEGP_GetEffectMatchName(key, matchName));
+            AE_CHECK(suites.EffectSuite4()->AEGP_GetEffectCategory(key, category));
+            effects->push_back({key, name, matchName, category});
+        }
+        return std::make_pair(count, effects);
+    });
+    auto [count, effects] = future.get();
+    if (!effects)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_count = count;
+    m_effects = std::move(*effects);
+    m_byMatchName.clear();
+    for (size_t i = 0; i < m_effects.size(); ++i)
+    {
+        m_byMatchName.emplace(m_effects[i].matchName, i);
+    }
+}
+
+std::optional<InstalledEffect> EffectRegistry::find(const std::string &matchName)
+{
+    refresh();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_byMatchName.find(matchName);
+    if (it == m_byMatchName.end())
+    {
+        return std::nullopt;
+    }
+    return m_effects[it->second];
+}
+
+tk::vector<InstalledEffect> EffectRegistry::effects()
+{
+    refresh();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_effects;
+}
+
+tk::shared_ptr<Effect> EffectRegistry::apply(const tk::shared_ptr<Layer> &layer, const std::string &matchName)
+{
+    auto effects = applyMany({layer}, matchName);
+    return effects.empty() ? nullptr : effects.front();
+}
+
+tk::vector<tk::shared_ptr<Effect>> EffectRegistry::applyMany(const tk::vector<tk::shared_ptr<Layer>> &layers,
+                                                             const std::string &matchName)
+{
+    auto effect = find(matchName);
+    if (!effect || layers.empty())
+    {
+        return {};
+    }
+
+    tk::vector<LayerPtr> handles;
+    handles.reserve(layers.size());
+    for (const auto &layer : layers)
+    {
+        CheckNotNull(layer.get(), "Error Applying Effect. Layer is Null");
+        handles.push_back(layer->getLayer());
+    }
+
+    Scoped_Undo_Guard undo("Apply " + effect->name);
+    auto future = ae::ScheduleOrExecute([handles, key = effect->key]() {
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+        tk::vector<EffectRefPtr> refs;
+        refs.reserve(handles.size());
+        for (const auto &layer : handles)
+        {
+            AEGP_EffectRefH effectH;
+            AE_CHECK(suites.EffectSuite4()->AEGP_ApplyEffect(pluginID, *layer, key, &effectH));
+            refs.push_back(makeEffectRefPtr(effectH));
+        }
+        return refs;
+    });
+    auto refs = future.get();
+    PropertyPathCache::invalidateAll();
+
+    tk::vector<tk::shared_ptr<Effect>> result;
+    result.reserve(refs.size());
+    for (auto &ref : refs)
+    {
+        result.push_back(tk::make_shared<Effect>(ref));
+    }
+    return result;
+}
+
+void EffectRegistry::invalidate()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_count = -1;
+}
@@ -1,78 +1,134 @@
 #include <AETK/AEGP/Layers.hpp>
+#include <AETK/AEGP/Util/EffectRegistry.hpp>
 #include <AETK/AEGP/Util/Effects.hpp>
+#include <AETK/AEGP/Util/Factories.hpp>
 #include <AETK/AEGP/Util/Properties.hpp>
 
 tk::shared_ptr<Effect> Effect::apply(tk::shared_ptr<Layer> layer, const std::string &matchName)
 {
-    try
+    return EffectRegistry::GetInstance().apply(layer, matchName);
+}
+
+const EffectParam *EffectParamIndex::find(const std::string &nameOrMatchName) const
+{
+    auto it = byName.find(nameOrMatchName);
+    if (it == byName.end())
     {
+        it = byMatchName.find(nameOrMatchName);
+        if (it == byMatchName.end())
+        {
+            return nullptr;
+        }
+    }
+    return &params[it->second];
+}
 
-        AEGP_InstalledEffectKey currentKey = 0; // Assuming 0 is a valid initial key or indicates 'start'.
-        A_long numEffects = EffectSuite().getNumInstalledEffects();
+const EffectParamIndex &Effect::index()
+{
+    if (auto index = std::atomic_load(&m_index))
+    {
+        return *index;
+    }
 
-        for (A_long i = 0; i < numEffects; ++i)
+    auto future = ae::ScheduleOrExecute([effect = m_effect]() {
+        CheckNotNull(effect.get(), "Error Indexing Effect Params. Effect is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+        auto index = tk::make_shared<EffectParamIndex>();
+        AE_CHECK(suites.EffectSuite4()->AEGP_GetInstalledKeyFromLayerEffect(*effect, &index->key));
+
+        A_long numParams = 0;
+        AE_CHECK(suites.StreamSuite6()->AEGP_GetEffectNumParamStreams(*effect, &numParams));
+        index->params.reserve(numParams);
+        for (A_long i = 0; i < numParams; ++i)
         {
-            std::string currentMatchName = EffectSuite().getEffectMatchName(currentKey);
-            if (currentMatchName == matchName)
-            {
-                // Match found, apply effect.
-                EffectRefPtr effectRef = EffectSuite().applyEffect(layer->getLayer(), currentKey);
+            EffectParam param;
+            param.index = i;
 
-                return tk::make_shared<Effect>(effectRef);
+            AEGP_StreamRefH streamH;
+            AE_CHECK(suites.StreamSuite6()->AEGP_GetNewEffectStreamByIndex(pluginID, *effect, i, &streamH));
+            param.stream = makeStreamRefPtr(streamH);
+
+            AEGP_StreamGroupingType grouping;
+            AE_CHECK(suites.DynamicStreamSuite4()->AEGP_GetStreamGroupingType(streamH, &grouping));
+            param.grouping = StreamGroupingType(grouping);
+            if (param.grouping == StreamGroupingType::LEAF)
+            {
+                AEGP_StreamType type;
+                AE_CHECK(suites.StreamSuite6()->AEGP_GetStreamType(streamH, &type));
+                param.type = StreamType(type);
             }
-            currentKey = EffectSuite().getNextInstalledEffect(currentKey);
-        }
 
-        return nullptr;
-    }
-    catch (const AEException &e)
+            A_char matchName[AEGP_MAX_STREAM_MATCH_NAME_SIZE];
+            AE_CHECK(suites.DynamicStreamSuite4()->AEGP_GetMatchName(streamH, matchName));
+            param.matchName = matchName;
+
+            AEGP_MemHandle nameH;
+            AE_CHECK(suites.StreamSuite6()->AEGP_GetStreamName(pluginID, streamH, TRUE, &nameH));
+            param.name = memHandleToString(nameH);
+
+            index->byName.emplace(param.name, static_cast<int>(i));
+            index->byMatchName.emplace(param.matchName, static_cast<int>(i));
+            index->params.push_back(std::move(param));
+        }
+        return tk::shared_ptr<const EffectParamIndex>(index);
+    });
+    auto index = future.get();
+    // Another caller may have published first and handed out references into its index; keep that one. The stored
+    // index is never replaced, so the reference returned below stays valid for the Effect's lifetime.
+    tk::shared_ptr<const EffectParamIndex> expected;
+    if (!std::atomic_compare_exchange_strong(&m_index, &expected, index))
     {
-        throw e;
+        return *expected;
     }
+    return *index;
 }
 
 std::string Effect::name()
 {
-    try
-    {
-        return EffectSuite().getEffectName(m_key);
-    }
-    catch (const AEException &e)
-    {
-        throw e;
-    }
+    return EffectSuite().getEffectName(index().key);
 }
 
 std::string Effect::matchName()
 {
-    return EffectSuite().getEffectMatchName(m_key);
+    return EffectSuite().getEffectMatchName(index().key);
 }
 
 std::string Effect::category()
 {
-    return EffectSuite().getEffectCategory(m_key);
+    return EffectSuite().getEffectCategory(index().key);
 }
 
-tk::shared_ptr<BaseProperty> Effect::param(int index)
+tk::shared_ptr<BaseProperty> Effect::param(int i)
 {
-    auto stream = StreamSuite().GetNewEffectStreamByIndex(m_effect, index);
-
-    return tk::make_shared<BaseProperty>(stream);
+    const auto &params = index().params;
+    if (i < 0 || i >= static_cast<int>(params.size()))
+    {
+        return nullptr;
+    }
+    const auto &param = params[i];
+    return PropertyFactory::CreateProperty(param.stream, param.grouping, param.type);
 }
 
 tk::shared_ptr<BaseProperty> Effect::param(const std::string &name)
 {
-    for (int i = 0; i < StreamSuite().GetEffectNumParamStreams(m_effect); ++i)
+    const EffectParam *param = index().find(name);
+    if (!param)
     {
-        std::string currentName =
-            StreamSuite().GetStreamName(StreamSuite().GetNewEffectStreamByIndex(m_effect, i), true);
-        if (currentName == name)
-        {
-            auto stream = StreamSuite().GetNewEffectStreamByIndex(m_effect, i);
-            return tk::make_shared<BaseProperty>(stream);
-        }
+        return nullptr;
     }
-    return nullptr;
+    return PropertyFactory::CreateProperty(param->stream, param->grouping, param->type);
+}
+
+const tk::vector<EffectParam> &Effect::params()
+{
+    return index().params;
+}
+
+int Effect::numParams()
+{
+    return static_cast<int>(index().params.size());
 }
 
 void Effect::callGeneric(double time, PF_Cmd cmd, void *extra) {}
@@ -80,5 +136,6 @@ void Effect::callGeneric(double time, PF_Cmd cmd, void *extra) {}
 tk::shared_ptr<Effect> Effect::duplicate()
 {
     EffectRefPtr effectRef = EffectSuite().duplicateEffect(m_effect);
+    PropertyPathCache::invalidateAll();
     return tk::make_shared<Effect>(effectRef);
 }
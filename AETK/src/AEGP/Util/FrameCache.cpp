@@ -0,0 +1,406 @@
+#include "AETK/AEGP/Util/FrameCache.hpp"
+#include "AETK/AEGP/Util/WorldUtil.hpp"
+
+#include <cstring>
+
+namespace
+{
+
+// Copies the pixels of source into target, which must have the same type and size. Main thread only.
+void copyPixels(AEGP_SuiteHandler &suites, AEGP_WorldH source, AEGP_WorldH target)
+{
+    AEGP_WorldType type = AEGP_WorldType_NONE;
+    A_long width = 0, height = 0;
+    A_u_long sourceRowBytes = 0, targetRowBytes = 0;
+    AE_CHECK(suites.WorldSuite3()->AEGP_GetType(source, &type));
+    AE_CHECK(suites.WorldSuite3()->AEGP_GetSize(source, &width, &height));
+    AE_CHECK(suites.WorldSuite3()->AEGP_GetRowBytes(source, &sourceRowBytes));
+    AE_CHECK(suites.WorldSuite3()->AEGP_GetRowBytes(target, &targetRowBytes));
+    const char *src = ae::baseAddr(suites, source, type);
+    char *dst = ae::baseAddr(suites, target, type);
+    CheckNotNull(src, "Error Copying Frame. Source World has no Pixels");
+    CheckNotNull(dst, "Error Copying Frame. Target World has no Pixels");
+    const size_t rowSize = static_cast<size_t>(width) * ae::pixelBytes(type);
+    for (A_long y = 0; y < height; ++y)
+    {
+        std::memcpy(dst + y * static_cast<size_t>(targetRowBytes), src + y * static_cast<size_t>(sourceRowBytes),
+                    rowSize);
+    }
+}
+
+// Row bytes times height. Main thread only.
+size_t worldBytes(AEGP_SuiteHandler &suites, AEGP_WorldH world)
+{
+    A_long width = 0, height = 0;
+    A_u_long rowBytes = 0;
+    AE_CHECK(suites.WorldSuite3()->AEGP_GetSize(world, &width, &height));
+    AE_CHECK(suites.WorldSuite3()->AEGP_GetRowBytes(world, &rowBytes));
+    return static_cast<size_t>(rowBytes) * static_cast<size_t>(std::max<A_long>(height, 0));
+}
+
+bool sameStamp(const AEGP_TimeStamp &a, const AEGP_TimeStamp &b)
+{
+    return std::memcmp(a.a, b.a, sizeof(a.a)) == 0;
+}
+
+// A zero time step still has to cover the frame for AEGP_HasItemChangedSinceTimestamp.
+A_Time nonZero(const A_Time &step)
+{
+    return step.value > 0 ? step : A_Time{1, step.scale ? step.scale : 1};
+}
+
+} // namespace
+
+namespace ae
+{
+
+bool FrameKey::operator==(const FrameKey &o) const
+{
+    return itemID == o.itemID && timeNum == o.timeNum && timeDen == o.timeDen && stepNum == o.stepNum &&
+           stepDen == o.stepDen && downsampleX == o.downsampleX && downsampleY == o.downsampleY &&
+           roi.left == o.roi.left && roi.top == o.roi.top && roi.right == o.roi.right &&
+           roi.bottom == o.roi.bottom && worldType == o.worldType && matteMode == o.matteMode &&
+           channelOrder == o.channelOrder;
+}
+
+size_t FrameKeyHash::operator()(const FrameKey &key) const
+{
+    uint64_t h = 1469598103934665603ull; // FNV-1a over the fields
+    auto mix = [&h](int64_t v) {
+        h ^= static_cast<uint64_t>(v);
+        h *= 1099511628211ull;
+    };
+    mix(key.itemID);
+    mix(key.timeNum);
+    mix(key.timeDen);
+    mix(key.stepNum);
+    mix(key.stepDen);
+    mix((static_cast<int64_t>(key.downsampleX) << 16) | static_cast<uint16_t>(key.downsampleY));
+    mix(key.roi.left);
+    mix(key.roi.top);
+    mix(key.roi.right);
+    mix(key.roi.bottom);
+    mix((static_cast<int64_t>(key.worldType) << 32) | (static_cast<int64_t>(key.matteMode) << 16) |
+        static_cast<int64_t>(key.channelOrder));
+    return static_cast<size_t>(h);
+}
+
+struct FrameCache::Probe
+{
+    FrameKey key;
+    A_Time time{0, 1};
+    A_Time step{0, 1};
+    AEGP_TimeStamp now;
+};
+
+FrameCache::FrameCache(const FrameCacheOptions &options) : m_options(options) {}
+
+FrameCache::Probe FrameCache::probe(ItemPtr item, RenderOptionsPtr options)
+{
+    auto future = ae::ScheduleOrExecute([item, options]() {
+        CheckNotNull(item.get(), "Error Reading Frame Key. Item is Null");
+        CheckNotNull(options.get(), "Error Reading Frame Key. Options are Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        auto *ro = suites.RenderOptionsSuite3();
+
+        Probe probe;
+        AE_CHECK(suites.ItemSuite9()->AEGP_GetItemID(*item, &probe.key.itemID));
+        AE_CHECK(ro->AEGP_GetTime(*options, &probe.time));
+        AE_CHECK(ro->AEGP_GetTimeStep(*options, &probe.step));
+        AE_CHECK(ro->AEGP_GetDownsampleFactor(*options, &probe.key.downsampleX, &probe.key.downsampleY));
+        AE_CHECK(ro->AEGP_GetRegionOfInterest(*options, &probe.key.roi));
+        AE_CHECK(ro->AEGP_GetWorldType(*options, &probe.key.worldType));
+        AE_CHECK(ro->AEGP_GetMatteMode(*options, &probe.key.matteMode));
+        AE_CHECK(ro->AEGP_GetChannelOrder(*options, &probe.key.channelOrder));
+        AE_CHECK(suites.RenderSuite5()->AEGP_GetCurrentTimestamp(&probe.now));
+
+        const RationalTime time(probe.time), step(probe.step);
+        probe.key.timeNum = time.num();
+        probe.key.timeDen = time.den();
+        probe.key.stepNum = step.num();
+        probe.key.stepDen = step.den();
+        return probe;
+    });
+    return future.get();
+}
+
+// The entry for probe.key if AE says it is still current, otherwise nullptr. Counts hits and invalidations.
+WorldPtr FrameCache::lookup(ItemPtr item, const Probe &probe)
+{
+    Entry entry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(probe.key);
+        if (it == m_entries.end())
+        {
+            return nullptr;
+        }
+        if (sameStamp(it->second.stamp, probe.now)) // Nothing in the project changed since
+        {
+            m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+            ++m_stats.hits;
+            return it->second.world;
+        }
+        entry = it->second;
+    }
+
+    auto future = ae::ScheduleOrExecute([item, entry]() {
+        A_Boolean changed = FALSE;
+        AE_CHECK(SuiteManager::GetInstance().GetSuiteHandler().RenderSuite5()->AEGP_HasItemChangedSinceTimestamp(
+            *item, &entry.start, &entry.duration, &entry.stamp, &changed));
+        return changed != FALSE;
+    });
+    const bool changed = future.get();
+
+    WorldPtr stale; // Released after the lock
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(probe.key);
+    if (it == m_entries.end() || it->second.world != entry.world) // Replaced or dropped meanwhile
+    {
+        return nullptr;
+    }
+    if (changed)
+    {
+        stale = std::move(it->second.world);
+        m_bytes -= it->second.bytes;
+        m_lru.erase(it->second.lru);
+        m_entries.erase(it);
+        ++m_stats.invalidated;
+        return nullptr;
+    }
+    it->second.stamp = probe.now; // Unchanged, so the frame is current as of now
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+    ++m_stats.hits;
+    return it->second.world;
+}
+
+void FrameCache::store(const FrameKey &key, Entry entry)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end())
+    {
+        m_bytes -= it->second.bytes;
+        m_lru.erase(it->second.lru);
+        m_entries.erase(it);
+    }
+    if (entry.bytes > m_options.byteBudget)
+    {
+        return; // Would evict everything and still not fit
+    }
+    m_lru.push_front(key);
+    entry.lru = m_lru.begin();
+    m_bytes += entry.bytes;
+    m_entries.emplace(key, std::move(entry));
+    evict();
+}
+
+void FrameCache::evict()
+{
+    while (m_bytes > m_options.byteBudget && !m_lru.empty())
+    {
+        auto it = m_entries.find(m_lru.back());
+        m_bytes -= it->second.bytes;
+        m_entries.erase(it);
+        m_lru.pop_back();
+        ++m_stats.evicted;
+    }
+}
+
+WorldPtr FrameCache::find(ItemPtr item, RenderOptionsPtr options)
+{
+    auto world = lookup(item, probe(item, options));
+    if (!world)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.misses;
+    }
+    return world;
+}
+
+WorldPtr FrameCache::render(ItemPtr item, RenderOptionsPtr options)
+{
+    const Probe p = probe(item, options);
+    if (auto world = lookup(item, p))
+    {
+        return world;
+    }
+
+    auto future = ae::ScheduleOrExecute([options]() {
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+        AEGP_FrameReceiptH receiptH = nullptr;
+        AE_CHECK(suites.RenderSuite5()->AEGP_RenderAndCheckoutFrame(*options, NULL, NULL, &receiptH));
+        AEGP_WorldH copy = nullptr;
+        size_t bytes = 0;
+        try
+        {
+            AEGP_WorldH source = nullptr;
+            AEGP_WorldType type = AEGP_WorldType_NONE;
+            A_long width = 0, height = 0;
+            AE_CHECK(suites.RenderSuite5()->AEGP_GetReceiptWorld(receiptH, &source));
+            CheckNotNull(source, "Error Rendering Frame. Receipt has no World");
+            AE_CHECK(suites.WorldSuite3()->AEGP_GetType(source, &type));
+            AE_CHECK(suites.WorldSuite3()->AEGP_GetSize(source, &width, &height));
+            AE_CHECK(suites.WorldSuite3()->AEGP_New(pluginID, type, width, height, &copy));
+            copyPixels(suites, source, copy);
+            bytes = worldBytes(suites, copy);
+        }
+        catch (...)
+        {
+            if (copy)
+            {
+                suites.WorldSuite3()->AEGP_Dispose(copy);
+            }
+            suites.RenderSuite5()->AEGP_CheckinFrame(receiptH);
+            throw;
+        }
+        // The copy is the cache's, so AE's frame memory is released now rather than on eviction.
+        suites.RenderSuite5()->AEGP_CheckinFrame(receiptH);
+        return std::make_pair(makeWorldPtr(copy), bytes);
+    });
+    auto [world, bytes] = future.get();
+
+    Entry entry;
+    entry.world = world;
+    entry.bytes = bytes;
+    entry.stamp = p.now; // Taken before rendering, so changes made during the render invalidate it
+    entry.start = p.time;
+    entry.duration = nonZero(p.step);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.misses;
+    }
+    store(p.key, std::move(entry));
+    return world;
+}
+
+void FrameCache::insert(ItemPtr item, RenderOptionsPtr options, WorldPtr world, TimeStampPtr startedAt,
+                        A_u_long ticksToRender)
+{
+    CheckNotNull(world.get(), "Error Inserting Frame. World is Null");
+    const Probe p = probe(item, options);
+    const AEGP_TimeStamp stamp = startedAt ? startedAt->get() : p.now;
+    const A_Time duration = nonZero(p.step);
+    const bool checkin = m_options.checkinToAE;
+
+    auto future = ae::ScheduleOrExecute([item, options, world, stamp, duration, checkin, time = p.time,
+                                         ticksToRender]() -> std::optional<size_t> {
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+        A_Boolean changed = FALSE;
+        AE_CHECK(suites.RenderSuite5()->AEGP_HasItemChangedSinceTimestamp(*item, &time, &duration, &stamp, &changed));
+        if (changed)
+        {
+            return std::nullopt; // Already stale
+        }
+
+        A_Boolean worthwhile = FALSE;
+        if (checkin)
+        {
+            AE_CHECK(suites.RenderSuite5()->AEGP_IsItemWorthwhileToRender(*options, &stamp, &worthwhile));
+        }
+        if (worthwhile)
+        {
+            AEGP_WorldType type = AEGP_WorldType_NONE;
+            A_long width = 0, height = 0;
+            AE_CHECK(suites.WorldSuite3()->AEGP_GetType(*world, &type));
+            AE_CHECK(suites.WorldSuite3()->AEGP_GetSize(*world, &width, &height));
+
+            AEGP_PlatformWorldH platform = nullptr;
+            AEGP_WorldH reference = nullptr;
+            AE_CHECK(suites.WorldSuite3()->AEGP_NewPlatformWorld(pluginID, type, width, height, &platform));
+            try
+            {
+                AE_CHECK(suites.WorldSuite3()->AEGP_NewReferenceFromPlatformWorld(pluginID, platform, &reference));
+                copyPixels(suites, *world, reference);
+            }
+            catch (...)
+            {
+                if (reference)
+                {
+                    suites.WorldSuite3()->AEGP_Dispose(reference);
+                }
+                suites.WorldSuite3()->AEGP_DisposePlatformWorld(platform);
+                throw;
+            }
+            suites.WorldSuite3()->AEGP_Dispose(reference);
+            // AE adopts the platform world.
+            AE_CHECK(suites.RenderSuite5()->AEGP_CheckinRenderedFrame(*options, &stamp, ticksToRender, platform));
+        }
+        return worldBytes(suites, *world);
+    });
+    auto bytes = future.get();
+    if (!bytes)
+    {
+        return;
+    }
+
+    Entry entry;
+    entry.world = world;
+    entry.bytes = *bytes;
+    entry.stamp = stamp;
+    entry.start = p.time;
+    entry.duration = duration;
+    store(p.key, std::move(entry));
+}
+
+void FrameCache::invalidate(ItemPtr item)
+{
+    auto future = ae::ScheduleOrExecute([item]() {
+        CheckNotNull(item.get(), "Error Invalidating Frames. Item is Null");
+        A_long id = 0;
+        AE_CHECK(SuiteManager::GetInstance().GetSuiteHandler().ItemSuite9()->AEGP_GetItemID(*item, &id));
+        return id;
+    });
+    const A_long id = future.get();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_lru.begin(); it != m_lru.end();)
+    {
+        if (it->itemID != id)
+        {
+            ++it;
+            continue;
+        }
+        auto entry = m_entries.find(*it);
+        m_bytes -= entry->second.bytes;
+        m_entries.erase(entry);
+        it = m_lru.erase(it);
+        ++m_stats.invalidated;
+    }
+}
+
+void FrameCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_lru.clear();
+    m_bytes = 0;
+}
+
+void FrameCache::setByteBudget(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_options.byteBudget = bytes;
+    evict();
+}
+
+size_t FrameCache::byteBudget() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_options.byteBudget;
+}
+
+FrameCacheStats FrameCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FrameCacheStats stats = m_stats;
+    stats.entries = m_entries.size();
+    stats.bytes = m_bytes;
+    return stats;
+}
+
+} // namespace ae
@@ -0,0 +1,172 @@
+#include "AETK/AEGP/Util/IdentityMap.hpp"
+#include "AETK/AEGP/Util/Factories.hpp"
+
+tk::shared_ptr<Layer> IdentityMap::layer(LayerPtr layer)
+{
+    if (!layer)
+    {
+        return nullptr;
+    }
+    // Resolve the key before taking m_mutex; the task may have to wait for the main thread.
+    auto future = ae::ScheduleOrExecute([layer]() {
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_ProjectH projectH;
+        AE_CHECK(suites.ProjSuite6()->AEGP_GetProjectByIndex(0, &projectH));
+        AEGP_CompH compH;
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerParentComp(*layer, &compH));
+        AEGP_LayerIDVal id;
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerID(*layer, &id));
+        AEGP_ObjectType type;
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerObjectType(*layer, &type));
+        return std::make_tuple(projectH, compH, id, ObjectType(type));
+    });
+    auto [projectH, compH, id, type] = future.get();
+    return this->layer(projectH, layer, compH, id, type);
+}
+
+tk::shared_ptr<Layer> IdentityMap::layer(AEGP_ProjectH project, LayerPtr layer, AEGP_CompH comp,
+                                         AEGP_LayerIDVal id, ObjectType type)
+{
+    LayerKey key{comp, id};
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        checkProject(project);
+        auto it = m_layers.find(key);
+        if (it != m_layers.end())
+        {
+            if (auto existing = it->second.lock())
+            {
+                return existing;
+            }
+        }
+    }
+
+    auto created = LayerFactory::createLayer(layer, type);
+    created->m_id = id;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &entry = m_layers[key];
+    if (auto existing = entry.lock()) // Another thread got there first
+    {
+        return existing;
+    }
+    entry = created;
+    prune();
+    return created;
+}
+
+tk::shared_ptr<Item> IdentityMap::item(ItemPtr item)
+{
+    if (!item)
+    {
+        return nullptr;
+    }
+    auto future = ae::ScheduleOrExecute([item]() {
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_ProjectH projectH;
+        AE_CHECK(suites.ProjSuite6()->AEGP_GetProjectByIndex(0, &projectH));
+        A_long id;
+        AE_CHECK(suites.ItemSuite9()->AEGP_GetItemID(*item, &id));
+        AEGP_ItemType type;
+        AE_CHECK(suites.ItemSuite9()->AEGP_GetItemType(*item, &type));
+        return std::make_tuple(projectH, id, ItemType(type));
+    });
+    auto [projectH, id, type] = future.get();
+    return this->item(projectH, item, id, type);
+}
+
+tk::shared_ptr<Item> IdentityMap::item(AEGP_ProjectH project, ItemPtr item, A_long id, ItemType type)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        checkProject(project);
+        auto it = m_items.find(id);
+        if (it != m_items.end())
+        {
+            if (auto existing = it->second.lock())
+            {
+                return existing;
+            }
+        }
+    }
+
+    // Comp and footage constructors call into AE, so build outside the lock.
+    auto created = ItemFactory::createItem(item, type);
+    created->m_id = id;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &entry = m_items[id];
+    if (auto existing = entry.lock()) // Another thread got there first
+    {
+        return existing;
+    }
+    entry = created;
+    prune();
+    return created;
+}
+
+void IdentityMap::forget(const Layer *layer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
+    {
+        if (it->second.lock().get() == layer)
+        {
+            m_layers.erase(it);
+            return;
+        }
+    }
+}
+
+void IdentityMap::forget(const Item *item)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_items.begin(); it != m_items.end(); ++it)
+    {
+        if (it->second.lock().get() == item)
+        {
+            m_items.erase(it);
+            return;
+        }
+    }
+}
+
+void IdentityMap::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_layers.clear();
+    m_items.clear();
+}
+
+size_t IdentityMap::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_layers.size() + m_items.size();
+}
+
+void IdentityMap::checkProject(AEGP_ProjectH project)
+{
+    if (project != m_project)
+    {
+        m_layers.clear();
+        m_items.clear();
+        m_project = project;
+    }
+}
+
+void IdentityMap::prune()
+{
+    if (m_layers.size() + m_items.size() < m_pruneAt)
+    {
+        return;
+    }
+    for (auto it = m_layers.begin(); it != m_layers.end();)
+    {
+        it = it->second.expired() ? m_layers.erase(it) : std::next(it);
+    }
+    for (auto it = m_items.begin(); it != m_items.end();)
+    {
+        it = it->second.expired() ? m_items.erase(it) : std::next(it);
+    }
+    m_pruneAt = std::max<size_t>(64, 2 * (m_layers.size() + m_items.size()));
+}
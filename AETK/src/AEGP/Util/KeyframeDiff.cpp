@@ -0,0 +1,467 @@
+#include "AETK/AEGP/Util/KeyframeDiff.hpp"
+#include "AETK/AEGP/Util/Context.hpp"
+#include <numeric>
+
+namespace
+{
+
+const KeyframeFlag kAllKeyframeFlags[] = {KeyframeFlag::TEMPORAL_CONTINUOUS, KeyframeFlag::TEMPORAL_AUTOBEZIER,
+                                          KeyframeFlag::SPATIAL_CONTINUOUS, KeyframeFlag::SPATIAL_AUTOBEZIER,
+                                          KeyframeFlag::ROVING};
+
+bool nearlyEqual(double a, double b, double tolerance)
+{
+    return std::abs(a - b) <= tolerance;
+}
+
+bool valuesEqual(const KeyFrame::TangentValue &a, const KeyFrame::TangentValue &b, double tolerance)
+{
+    if (a.index() != b.index())
+    {
+        return false;
+    }
+    return std::visit(overloaded{[&](double val) { return nearlyEqual(val, std::get<double>(b), tolerance); },
+                                 [&](const TwoDVal &val) {
+                                     auto &other = std::get<TwoDVal>(b);
+                                     return nearlyEqual(val.x, other.x, tolerance) &&
+                                            nearlyEqual(val.y, other.y, tolerance);
+                                 },
+                                 [&](const ThreeDVal &val) {
+                                     auto &other = std::get<ThreeDVal>(b);
+                                     return nearlyEqual(val.x, other.x, tolerance) &&
+                                            nearlyEqual(val.y, other.y, tolerance) &&
+                                            nearlyEqual(val.z, other.z, tolerance);
+                                 },
+                                 [&](const ColorVal &val) {
+                                     auto &other = std::get<ColorVal>(b);
+                                     return nearlyEqual(val.red, other.red, tolerance) &&
+                                            nearlyEqual(val.green, other.green, tolerance) &&
+                                            nearlyEqual(val.blue, other.blue, tolerance) &&
+                                            nearlyEqual(val.alpha, other.alpha, tolerance);
+                                 },
+                                 [&](std::monostate) { return true; }},
+                      a);
+}
+
+bool easeEqual(const KeyframeEase &a, const KeyframeEase &b, double tolerance)
+{
+    return nearlyEqual(a.speedF, b.speedF, tolerance) && nearlyEqual(a.influenceF, b.influenceF, tolerance);
+}
+
+AEGP_KeyframeFlags toFlagMask(const tk::vector<KeyframeFlag> &flags)
+{
+    AEGP_KeyframeFlags mask = AEGP_KeyframeFlag_NONE;
+    for (auto flag : flags)
+    {
+        mask |= AEGP_KeyframeFlags(flag);
+    }
+    return mask;
+}
+
+bool isSpatial(AEGP_StreamType type)
+{
+    return type == AEGP_StreamType_TwoD_SPATIAL || type == AEGP_StreamType_ThreeD_SPATIAL;
+}
+
+KeyFrame::TangentValue toTangentValue(AEGP_StreamType type, const AEGP_StreamValue2 &value)
+{
+    switch (type)
+    {
+    case AEGP_StreamType_OneD:
+        return value.val.one_d;
+    case AEGP_StreamType_TwoD:
+    case AEGP_StreamType_TwoD_SPATIAL:
+        return TwoDVal(value.val.two_d);
+    case AEGP_StreamType_ThreeD:
+    case AEGP_StreamType_ThreeD_SPATIAL:
+        return ThreeDVal(value.val.three_d);
+    case AEGP_StreamType_COLOR:
+        return ColorVal(value.val.color);
+    default:
+        return std::monostate();
+    }
+}
+
+AEGP_StreamValue2 toStreamValue(AEGP_StreamRefH stream, KeyFrame::TangentValue value)
+{
+    AEGP_StreamValue2 aeValue{};
+    aeValue.streamH = stream;
+    std::visit(overloaded{[&](double val) { aeValue.val.one_d = val; },
+                          [&](TwoDVal val) { aeValue.val.two_d = val.toAEGP(); },
+                          [&](ThreeDVal val) { aeValue.val.three_d = val.toAEGP(); },
+                          [&](ColorVal val) { aeValue.val.color = val.toAEGP(); }, [&](std::monostate) {}},
+               value);
+    return aeValue;
+}
+
+// Writes every attribute the desired key specifies. Must run on the main thread.
+void writeKey(AEGP_StreamRefH stream, AEGP_KeyframeIndex keyIndex, const KeyFrame &key, A_short temporalDims,
+              bool spatial)
+{
+    auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+
+    if (!std::holds_alternative<std::monostate>(key.value))
+    {
+        auto value = toStreamValue(stream, key.value);
+        AE_CHECK(suites.KeyframeSuite5()->AEGP_SetKeyframeValue(stream, keyIndex, &value));
+    }
+
+    if (key.interp.has_value())
+    {
+        auto [inInterp, outInterp] = key.interp.value();
+        AE_CHECK(suites.KeyframeSuite5()->AEGP_SetKeyframeInterpolation(stream, keyIndex, int(inInterp),
+                                                                         int(outInterp)));
+    }
+
+    if (key.easeIn.has_value())
+    {
+        KeyframeEase inEase = key.easeIn.value();
+        KeyframeEase outEase = key.easeOut.value_or(inEase);
+        AEGP_KeyframeEase aeIn = inEase.toAEGP();
+        AEGP_KeyframeEase aeOut = outEase.toAEGP();
+        for (A_short dim = 0; dim < temporalDims; ++dim)
+        {
+            AE_CHECK(suites.KeyframeSuite5()->AEGP_SetKeyframeTemporalEase(stream, keyIndex, dim, &aeIn, &aeOut));
+        }
+    }
+
+    if (!key.flags.empty())
+    {
+        AEGP_KeyframeFlags mask = toFlagMask(key.flags);
+        for (auto flag : kAllKeyframeFlags)
+        {
+            A_Boolean set = (mask & AEGP_KeyframeFlags(flag)) != 0;
+            AE_CHECK(suites.KeyframeSuite5()->AEGP_SetKeyframeFlag(stream, keyIndex, AEGP_KeyframeFlags(flag), set));
+        }
+    }
+
+    if (spatial && key.tangents.has_value())
+    {
+        auto inTan = toStreamValue(stream, key.tangents->first);
+        auto outTan = toStreamValue(stream, key.tangents->second);
+        AE_CHECK(suites.KeyframeSuite5()->AEGP_SetKeyframeSpatialTangents(stream, keyIndex, &inTan, &outTan));
+    }
+}
+
+} // namespace
+
+tk::vector<KeyFrame> KeyframeDiff::snapshotUnscheduled(AEGP_StreamRefH stream)
+{
+    auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+    AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+    A_long numKeys = 0;
+    AE_CHECK(suites.KeyframeSuite5()->AEGP_GetStreamNumKFs(stream, &numKeys));
+    if (numKeys <= 0) // AEGP_NumKF_NO_DATA
+    {
+        return {};
+    }
+
+    AEGP_StreamType type;
+    AE_CHECK(suites.StreamSuite6()->AEGP_GetStreamType(stream, &type));
+    const bool spatial = isSpatial(type);
+
+    tk::vector<KeyFrame> keys;
+    keys.reserve(numKeys);
+    for (A_long i = 0; i < numKeys; ++i)
+    {
+        A_Time time;
+        AE_CHECK(suites.KeyframeSuite5()->AEGP_GetKeyframeTime(stream, i, AEGP_LTimeMode_CompTime, &time));
+        KeyFrame key(static_cast<double>(time.value) / static_cast<double>(time.scale));
+
+        AEGP_StreamValue2 value;
+        AE_CHECK(suites.KeyframeSuite5()->AEGP_GetNewKeyframeValue(pluginID, stream, i, &value));
+        key.value = toTangentValue(type, value);
+        suites.StreamSuite6()->AEGP_DisposeStreamValue(&value);
+
+        AEGP_KeyframeFlags flags;
+        AE_CHECK(suites.KeyframeSuite5()->AEGP_GetKeyframeFlags(stream, i, &flags));
+        for (auto flag : kAllKeyframeFlags)
+        {
+            if (flags & AEGP_KeyframeFlags(flag))
+            {
+                key.flags.push_back(flag);
+            }
+        }
+
+        AEGP_KeyframeInterpolationType inInterp, outInterp;
+        AE_CHECK(suites.KeyframeSuite5()->AEGP_GetKeyframeInterpolation(stream, i, &inInterp, &outInterp));
+        key.interp = std::make_pair(KeyInterp(inInterp), KeyInterp(outInterp));
+
+        AEGP_KeyframeEase inEase, outEase;
+        AE_CHECK(suites.KeyframeSuite5()->AEGP_GetKeyframeTemporalEase(stream, i, 0, &inEase, &outEase));
+        key.easeIn = KeyframeEase(inEase);
+        key.easeOut = KeyframeEase(outEase);
+
+        if (spatial)
+        {
+            AEGP_StreamValue2 inTan, outTan;
+            AE_CHECK(suites.KeyframeSuite5()->AEGP_GetNewKeyframeSpatialTangents(pluginID, stream, i, &inTan,
+                                                                                 &outTan));
+            key.tangents = std::make_pair(toTangentValue(type, inTan), toTangentValue(type, outTan));
+            suites.StreamSuite6()->AEGP_DisposeStreamValue(&inTan);
+            suites.StreamSuite6()->AEGP_DisposeStreamValue(&outTan);
+        }
+        keys.push_back(std::move(key));
+    }
+    return keys;
+}
+
+tk::vector<KeyFrame> KeyframeDiff::snapshot(StreamRefPtr stream)
+{
+    auto future = ae::ScheduleOrExecute([stream]() {
+        CheckNotNull(stream.get(), "Error Getting Keyframe Snapshot. Stream is Null");
+        return snapshotUnscheduled(*stream);
+    });
+    return future.get();
+}
+
+tk::vector<tk::vector<KeyFrame>> KeyframeDiff::snapshot(const tk::vector<StreamRefPtr> &streams)
+{
+    auto future = ae::ScheduleOrExecute([streams]() {
+        tk::vector<tk::vector<KeyFrame>> snapshots;
+        snapshots.reserve(streams.size());
+        for (const auto &stream : streams)
+        {
+            CheckNotNull(stream.get(), "Error Getting Keyframe Snapshot. Stream is Null");
+            snapshots.push_back(snapshotUnscheduled(*stream));
+        }
+        return snapshots;
+    });
+    return future.get();
+}
+
+bool KeyframeDiff::matches(const KeyFrame &current, const KeyFrame &desired, const KeyframeDiffOptions &options)
+{
+    const double tol = options.valueTolerance;
+
+    if (!std::holds_alternative<std::monostate>(desired.value) && !valuesEqual(current.value, desired.value, tol))
+    {
+        return false;
+    }
+
+    if (desired.interp.has_value() && current.interp != desired.interp)
+    {
+        return false;
+    }
+
+    if (desired.easeIn.has_value())
+    {
+        KeyframeEase outEase = desired.easeOut.value_or(desired.easeIn.value());
+        if (!current.easeIn.has_value() || !current.easeOut.has_value() ||
+            !easeEqual(current.easeIn.value(), desired.easeIn.value(), tol) ||
+            !easeEqual(current.easeOut.value(), outEase, tol))
+        {
+            return false;
+        }
+    }
+
+    if (!desired.flags.empty() && toFlagMask(current.flags) != toFlagMask(desired.flags))
+    {
+        return false;
+    }
+
+    // Tangents are only read back for spatial streams, so only compare them when they exist.
+    if (desired.tangents.has_value() && current.tangents.has_value())
+    {
+        if (!valuesEqual(current.tangents->first, desired.tangents->first, tol) ||
+            !valuesEqual(current.tangents->second, desired.tangents->second, tol))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+KeyframePatch KeyframeDiff::diff(const tk::vector<KeyFrame> &current, const tk::vector<KeyFrame> &desired,
+                                 const KeyframeDiffOptions &options)
+{
+    const double tol = options.timeTolerance;
+
+    // Snapshots from AE are already ordered by time, but callers may hand us
+    // anything. Sort indices so the original snapshot index is kept.
+    tk::vector<int> cur(current.size());
+    std::iota(cur.begin(), cur.end(), 0);
+    std::stable_sort(cur.begin(), cur.end(), [&](int a, int b) { return current[a].time < current[b].time; });
+
+    tk::vector<int> sortedDesired(desired.size());
+    std::iota(sortedDesired.begin(), sortedDesired.end(), 0);
+    std::stable_sort(sortedDesired.begin(), sortedDesired.end(),
+                     [&](int a, int b) { return desired[a].time < desired[b].time; });
+
+    // Desired keys that land on the same time collapse into one; the later entry wins.
+    tk::vector<int> des;
+    des.reserve(sortedDesired.size());
+    for (int idx : sortedDesired)
+    {
+        if (!des.empty() && std::abs(desired[idx].time - desired[des.back()].time) <= tol)
+        {
+            des.back() = idx;
+        }
+        else
+        {
+            des.push_back(idx);
+        }
+    }
+
+    KeyframePatch patch;
+    size_t i = 0, j = 0;
+    while (i < cur.size() && j < des.size())
+    {
+        const KeyFrame &c = current[cur[i]];
+        const KeyFrame &d = desired[des[j]];
+        double dt = c.time - d.time;
+
+        if (std::abs(dt) <= tol)
+        {
+            if (!matches(c, d, options))
+            {
+                patch.ops.push_back({KeyframeOpType::Update, cur[i], d});
+            }
+            ++i;
+            ++j;
+        }
+        else if (dt < 0)
+        {
+            patch.ops.push_back({KeyframeOpType::Delete, cur[i], c});
+            ++i;
+        }
+        else
+        {
+            patch.ops.push_back({KeyframeOpType::Insert, -1, d});
+            ++j;
+        }
+    }
+    for (; i < cur.size(); ++i)
+    {
+        patch.ops.push_back({KeyframeOpType::Delete, cur[i], current[cur[i]]});
+    }
+    for (; j < des.size(); ++j)
+    {
+        patch.ops.push_back({KeyframeOpType::Insert, -1, desired[des[j]]});
+    }
+    return patch;
+}
+
+void KeyframeDiff::applyUnscheduled(AEGP_StreamRefH stream, const KeyframePatch &patch,
+                                    const ae::TimeContext &context)
+{
+    auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+
+    AEGP_StreamType type;
+    AE_CHECK(suites.StreamSuite6()->AEGP_GetStreamType(stream, &type));
+    const bool spatial = isSpatial(type);
+    A_short temporalDims = 0;
+    AE_CHECK(suites.KeyframeSuite5()->AEGP_GetStreamTemporalDimensionality(stream, &temporalDims));
+
+    tk::vector<int> deletes;
+    for (const auto &op : patch.ops)
+    {
+        if (op.type == KeyframeOpType::Delete)
+        {
+            deletes.push_back(op.index);
+        }
+    }
+    std::sort(deletes.begin(), deletes.end());
+
+    // Delete from the back so earlier indices stay valid.
+    for (auto it = deletes.rbegin(); it != deletes.rend(); ++it)
+    {
+        AE_CHECK(suites.KeyframeSuite5()->AEGP_DeleteKeyframe(stream, *it));
+    }
+
+    // Updates refer to snapshot indices; shift them past the keys deleted above.
+    for (const auto &op : patch.ops)
+    {
+        if (op.type != KeyframeOpType::Update)
+        {
+            continue;
+        }
+        auto shift = std::lower_bound(deletes.begin(), deletes.end(), op.index) - deletes.begin();
+        writeKey(stream, op.index - static_cast<int>(shift), op.key, temporalDims, spatial);
+    }
+
+    for (const auto &op : patch.ops)
+    {
+        if (op.type != KeyframeOpType::Insert)
+        {
+            continue;
+        }
+        A_Time time = context.toTime(op.key.time);
+        AEGP_KeyframeIndex keyIndex;
+        AE_CHECK(suites.KeyframeSuite5()->AEGP_InsertKeyframe(stream, AEGP_LTimeMode_CompTime, &time, &keyIndex));
+        writeKey(stream, keyIndex, op.key, temporalDims, spatial);
+    }
+}
+
+void KeyframeDiff::applyAll(const tk::vector<std::pair<StreamRefPtr, const KeyframePatch *>> &patches,
+                            const std::string &undoName, const std::optional<ae::TimeContext> &context)
+{
+    if (patches.empty())
+    {
+        return;
+    }
+
+    // Read before the edit task; the lookup is a task of its own.
+    const ae::TimeContext grid = context ? *context : ae::TimeContext::mostRecent();
+    Scoped_Undo_Guard undo(undoName);
+    auto future = ae::ScheduleOrExecute([&patches, grid]() {
+        for (const auto &[stream, patch] : patches)
+        {
+            CheckNotNull(stream.get(), "Error Applying Keyframe Patch. Stream is Null");
+            applyUnscheduled(*stream, *patch, grid);
+        }
+    });
+    future.get();
+}
+
+void KeyframeDiff::apply(StreamRefPtr stream, const KeyframePatch &patch, const std::string &undoName,
+                         const std::optional<ae::TimeContext> &context)
+{
+    if (patch.empty())
+    {
+        return;
+    }
+    applyAll({{stream, &patch}}, undoName, context);
+}
+
+KeyframePatch KeyframeDiff::sync(StreamRefPtr stream, const tk::vector<KeyFrame> &desired,
+                                 const KeyframeDiffOptions &options, const std::optional<ae::TimeContext> &context)
+{
+    auto patch = diff(snapshot(stream), desired, options);
+    apply(stream, patch, "Sync Keyframes", context);
+    return patch;
+}
+
+tk::vector<KeyframePatch> KeyframeDiff::sync(const tk::vector<KeyframeTrack> &tracks,
+                                             const KeyframeDiffOptions &options,
+                                             const std::optional<ae::TimeContext> &context)
+{
+    tk::vector<StreamRefPtr> streams;
+    streams.reserve(tracks.size());
+    for (const auto &track : tracks)
+    {
+        streams.push_back(track.stream);
+    }
+
+    auto snapshots = snapshot(streams);
+
+    tk::vector<KeyframePatch> patches;
+    patches.reserve(tracks.size());
+    tk::vector<std::pair<StreamRefPtr, const KeyframePatch *>> pending;
+    for (size_t i = 0; i < tracks.size(); ++i)
+    {
+        patches.push_back(diff(snapshots[i], tracks[i].keys, options));
+    }
+    for (size_t i = 0; i < tracks.size(); ++i)
+    {
+        if (!patches[i].empty())
+        {
+            pending.emplace_back(tracks[i].stream, &patches[i]);
+        }
+    }
+
+    applyAll(pending, "Sync Keyframes", context);
+    return patches;
+}
@@ -0,0 +1,160 @@
+#include "AETK/AEGP/Util/LayerQuery.hpp"
+#include "AETK/AEGP/Util/IdentityMap.hpp"
+#include "AETK/AEGP/Layers.hpp"
+
+namespace
+{
+
+bool has(LayerColumn columns, LayerColumn column)
+{
+    return (columns & column) != LayerColumn::None;
+}
+
+} // namespace
+
+tk::vector<LayerRow> LayerQuery::rows() const
+{
+    return fetch(m_columns, nullptr);
+}
+
+std::future<tk::vector<AEGP_LayerIDVal>> LayerQuery::run() const
+{
+    auto rows = std::make_shared<tk::vector<LayerRow>>(fetch(m_columns, nullptr));
+    return std::async(std::launch::async,
+                      [rows, predicate = m_predicate]() { return match(*rows, predicate); });
+}
+
+tk::vector<tk::shared_ptr<Layer>> LayerQuery::layers() const
+{
+    // The object type is needed to build the right wrapper.
+    AEGP_ProjectH project = nullptr;
+    auto rows = fetch(m_columns | LayerColumn::ObjectType, &project);
+    auto ids = match(rows, m_predicate);
+
+    tk::vector<tk::shared_ptr<Layer>> result;
+    result.reserve(ids.size());
+    auto &map = IdentityMap::GetInstance();
+    AEGP_CompH compH = *m_comp;
+    size_t next = 0;
+    for (const auto &row : rows) // ids are in row order
+    {
+        if (next < ids.size() && ids[next] == row.id)
+        {
+            result.push_back(map.layer(project, row.layer, compH, row.id, row.type));
+            ++next;
+        }
+    }
+    return result;
+}
+
+tk::vector<LayerRow> LayerQuery::fetch(LayerColumn columns, AEGP_ProjectH *project) const
+{
+    auto future = ae::ScheduleOrExecute([comp = m_comp, columns, seconds = m_time, wantProject = project != nullptr]() {
+        CheckNotNull(comp.get(), "Error Querying Layers. Comp is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+        AEGP_ProjectH projectH = nullptr;
+        if (wantProject)
+        {
+            AE_CHECK(suites.ProjSuite6()->AEGP_GetProjectByIndex(0, &projectH));
+        }
+
+        // The query time snaps to this comp's frame grid, not the most recently used comp's.
+        A_Time time{0, 1};
+        if (has(columns, LayerColumn::VideoActive))
+        {
+            A_Time frameDuration;
+            AE_CHECK(suites.CompSuite11()->AEGP_GetCompFrameDuration(*comp, &frameDuration));
+            time = ae::TimeContext(frameDuration).toTime(seconds);
+        }
+
+        A_long numLayers = 0;
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetCompNumLayers(*comp, &numLayers));
+
+        tk::vector<LayerRow> rows(numLayers);
+        for (A_long i = 0; i < numLayers; ++i)
+        {
+            LayerRow &row = rows[i];
+            AEGP_LayerH layerH;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(*comp, i, &layerH));
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &row.id));
+            row.index = i;
+            row.layer = makeLayerPtr(layerH);
+
+            if (has(columns, LayerColumn::Name))
+            {
+                AEGP_MemHandle nameH, sourceNameH;
+                AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerName(pluginID, layerH, &nameH, &sourceNameH));
+                row.name = memHandleToString(nameH);
+                row.sourceName = memHandleToString(sourceNameH);
+            }
+            if (has(columns, LayerColumn::Flags))
+            {
+                AEGP_LayerFlags flags;
+                AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerFlags(layerH, &flags));
+                row.flags = LayerFlag(flags);
+            }
+            if (has(columns, LayerColumn::Label))
+            {
+                AEGP_LabelID label;
+                AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerLabel(layerH, &label));
+                row.label = Label(label);
+            }
+            if (has(columns, LayerColumn::ObjectType))
+            {
+                AEGP_ObjectType type;
+                AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerObjectType(layerH, &type));
+                row.type = ObjectType(type);
+            }
+            if (has(columns, LayerColumn::InOut))
+            {
+                A_Time inPoint, duration;
+                AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerInPoint(layerH, AEGP_LTimeMode_CompTime, &inPoint));
+                AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerDuration(layerH, AEGP_LTimeMode_CompTime, &duration));
+                // Exact, rather than TimeToSeconds' 1/100 s rounding.
+                row.inPoint = ae::TimeContext::toSeconds(inPoint);
+                row.outPoint = (ae::RationalTime(inPoint) + ae::RationalTime(duration)).seconds();
+            }
+            if (has(columns, LayerColumn::Parent))
+            {
+                AEGP_LayerH parentH = nullptr;
+                AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerParent(layerH, &parentH));
+                if (parentH)
+                {
+                    AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerID(parentH, &row.parentID));
+                }
+            }
+            if (has(columns, LayerColumn::SourceItemID))
+            {
+                AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerSourceItemID(layerH, &row.sourceItemID));
+            }
+            if (has(columns, LayerColumn::VideoActive))
+            {
+                A_Boolean active = FALSE;
+                AE_CHECK(suites.LayerSuite9()->AEGP_IsVideoActive(layerH, AEGP_LTimeMode_CompTime, &time, &active));
+                row.videoActive = active != FALSE;
+            }
+        }
+        return std::make_pair(projectH, std::move(rows));
+    });
+    auto [projectH, rows] = future.get();
+    if (project)
+    {
+        *project = projectH;
+    }
+    return std::move(rows);
+}
+
+tk::vector<AEGP_LayerIDVal> LayerQuery::match(const tk::vector<LayerRow> &rows, const Predicate &predicate)
+{
+    tk::vector<AEGP_LayerIDVal> ids;
+    for (const auto &row : rows)
+    {
+        if (!predicate || predicate(row))
+        {
+            ids.push_back(row.id);
+        }
+    }
+    return ids;
+}
@@ -0,0 +1,184 @@
+#include "AETK/AEGP/Util/MarkerTrack.hpp"
+#include "AETK/AEGP/Util/Context.hpp"
+
+namespace
+{
+
+const std::pair<AEGP_MarkerStringType, std::string MarkerEntry::*> kStrings[] = {
+    {AEGP_MarkerString_COMMENT, &MarkerEntry::comment},
+    {AEGP_MarkerString_CHAPTER, &MarkerEntry::chapter},
+    {AEGP_MarkerString_URL, &MarkerEntry::url},
+    {AEGP_MarkerString_FRAME_TARGET, &MarkerEntry::frameTarget},
+    {AEGP_MarkerString_CUE_POINT_NAME, &MarkerEntry::cuePointName}};
+
+// Copies every field of a marker. Main thread only.
+void readMarker(AEGP_SuiteHandler &suites, AEGP_PluginID pluginID, AEGP_ConstMarkerValP markerP, MarkerEntry &entry)
+{
+    AE_CHECK(suites.MarkerSuite3()->AEGP_GetMarkerDuration(markerP, &entry.duration));
+    A_long label = 0;
+    AE_CHECK(suites.MarkerSuite3()->AEGP_GetMarkerLabel(markerP, &label));
+    entry.label = label;
+
+    for (const auto &[type, field] : kStrings)
+    {
+        AEGP_MemHandle stringH;
+        AE_CHECK(suites.MarkerSuite3()->AEGP_GetMarkerString(pluginID, markerP, type, &stringH));
+        entry.*field = memHandleToString(stringH);
+    }
+
+    A_Boolean flag = FALSE;
+    AE_CHECK(suites.MarkerSuite3()->AEGP_GetMarkerFlag(markerP, AEGP_MarkerFlag_NAVIGATION, &flag));
+    entry.navigation = flag != FALSE;
+    AE_CHECK(suites.MarkerSuite3()->AEGP_GetMarkerFlag(markerP, AEGP_MarkerFlag_PROTECT_REGION, &flag));
+    entry.protectRegion = flag != FALSE;
+
+    A_long numParams = 0;
+    AE_CHECK(suites.MarkerSuite3()->AEGP_CountCuePointParams(markerP, &numParams));
+    entry.cuePointParams.reserve(numParams);
+    for (A_long i = 0; i < numParams; ++i)
+    {
+        AEGP_MemHandle keyH, valueH;
+        AE_CHECK(suites.MarkerSuite3()->AEGP_GetIndCuePointParam(pluginID, markerP, i, &keyH, &valueH));
+        std::string key = memHandleToString(keyH);
+        entry.cuePointParams.emplace_back(std::move(key), memHandleToString(valueH));
+    }
+}
+
+// Copies entry into a new marker. Main thread only.
+void writeMarker(AEGP_SuiteHandler &suites, AEGP_MarkerValP markerP, const MarkerEntry &entry)
+{
+    AE_CHECK(suites.MarkerSuite3()->AEGP_SetMarkerDuration(markerP, &entry.duration));
+    AE_CHECK(suites.MarkerSuite3()->AEGP_SetMarkerLabel(markerP, entry.label));
+
+    for (const auto &[type, field] : kStrings)
+    {
+        const std::string &text = entry.*field;
+        if (text.empty())
+        {
+            continue;
+        }
+        auto utf16 = ConvertUTF8ToUTF16(text); // Null terminated
+        AE_CHECK(suites.MarkerSuite3()->AEGP_SetMarkerString(markerP, type, utf16.data(),
+                                                             static_cast<A_long>(utf16.size()) - 1));
+    }
+
+    AE_CHECK(suites.MarkerSuite3()->AEGP_SetMarkerFlag(markerP, AEGP_MarkerFlag_NAVIGATION, entry.navigation));
+    AE_CHECK(suites.MarkerSuite3()->AEGP_SetMarkerFlag(markerP, AEGP_MarkerFlag_PROTECT_REGION, entry.protectRegion));
+
+    for (size_t i = 0; i < entry.cuePointParams.size(); ++i)
+    {
+        auto key = ConvertUTF8ToUTF16(entry.cuePointParams[i].first);
+        auto value = ConvertUTF8ToUTF16(entry.cuePointParams[i].second);
+        A_long index = static_cast<A_long>(i);
+        AE_CHECK(suites.MarkerSuite3()->AEGP_InsertCuePointParam(markerP, index));
+        AE_CHECK(suites.MarkerSuite3()->AEGP_SetIndCuePointParam(markerP, index, key.data(),
+                                                                 static_cast<A_long>(key.size()) - 1, value.data(),
+                                                                 static_cast<A_long>(value.size()) - 1));
+    }
+}
+
+} // namespace
+
+MarkerTrack MarkerTrack::snapshot(StreamRefPtr stream)
+{
+    auto future = ae::ScheduleOrExecute([stream]() {
+        CheckNotNull(stream.get(), "Error Reading Markers. Stream is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+        MarkerTrack track;
+        A_long numKeys = 0;
+        AE_CHECK(suites.KeyframeSuite5()->AEGP_GetStreamNumKFs(*stream, &numKeys));
+        if (numKeys <= 0) // AEGP_NumKF_NO_DATA
+        {
+            return track;
+        }
+
+        track.markers.resize(numKeys);
+        for (A_long i = 0; i < numKeys; ++i)
+        {
+            auto &entry = track.markers[i];
+            AE_CHECK(suites.KeyframeSuite5()->AEGP_GetKeyframeTime(*stream, i, AEGP_LTimeMode_CompTime, &entry.time));
+
+            AEGP_StreamValue2 value;
+            AE_CHECK(suites.KeyframeSuite5()->AEGP_GetNewKeyframeValue(pluginID, *stream, i, &value));
+            try
+            {
+                readMarker(suites, pluginID, value.val.markerP, entry);
+            }
+            catch (...)
+            {
+                suites.StreamSuite6()->AEGP_DisposeStreamValue(&value);
+                throw;
+            }
+            suites.StreamSuite6()->AEGP_DisposeStreamValue(&value);
+        }
+        return track;
+    });
+    return future.get();
+}
+
+void MarkerTrack::apply(StreamRefPtr stream, const MarkerTrack &track, const std::string &undoName)
+{
+    Scoped_Undo_Guard undo(undoName);
+    auto future = ae::ScheduleOrExecute([stream, &track]() {
+        CheckNotNull(stream.get(), "Error Setting Markers. Stream is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+
+        A_long numKeys = 0;
+        AE_CHECK(suites.KeyframeSuite5()->AEGP_GetStreamNumKFs(*stream, &numKeys));
+        for (A_long i = numKeys - 1; i >= 0; --i)
+        {
+            AE_CHECK(suites.KeyframeSuite5()->AEGP_DeleteKeyframe(*stream, i));
+        }
+        if (track.empty())
+        {
+            return;
+        }
+
+        // The markers are owned here until every key has been committed.
+        tk::vector<AEGP_MarkerValP> markers;
+        markers.reserve(track.size());
+        auto dispose = [&]() {
+            for (auto markerP : markers)
+            {
+                suites.MarkerSuite3()->AEGP_DisposeMarker(markerP);
+            }
+        };
+
+        AEGP_AddKeyframesInfoH akH = nullptr;
+        try
+        {
+            AE_CHECK(suites.KeyframeSuite5()->AEGP_StartAddKeyframes(*stream, &akH));
+            for (const auto &entry : track.markers)
+            {
+                AEGP_MarkerValP markerP = nullptr;
+                AE_CHECK(suites.MarkerSuite3()->AEGP_NewMarker(&markerP));
+                markers.push_back(markerP);
+                writeMarker(suites, markerP, entry);
+
+                AEGP_KeyframeIndex keyIndex;
+                AE_CHECK(
+                    suites.KeyframeSuite5()->AEGP_AddKeyframes(akH, AEGP_LTimeMode_CompTime, &entry.time, &keyIndex));
+                AEGP_StreamValue2 value = {};
+                value.streamH = *stream;
+                value.val.markerP = markerP;
+                AE_CHECK(suites.KeyframeSuite5()->AEGP_SetAddKeyframe(akH, keyIndex, &value));
+            }
+            AEGP_AddKeyframesInfoH pending = akH;
+            akH = nullptr;
+            AE_CHECK(suites.KeyframeSuite5()->AEGP_EndAddKeyframes(true, pending));
+        }
+        catch (...)
+        {
+            if (akH)
+            {
+                suites.KeyframeSuite5()->AEGP_EndAddKeyframes(false, akH);
+            }
+            dispose();
+            throw;
+        }
+        dispose();
+    });
+    future.get();
+}
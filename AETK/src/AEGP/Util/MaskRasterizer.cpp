@@ -0,0 +1,509 @@
+#include "AETK/AEGP/Util/MaskRasterizer.hpp"
+#include "AETK/AEGP/Util/Masks.hpp"
+#include "AETK/AEGP/Util/Parallel.hpp"
+
+namespace ae
+{
+
+struct MaskRasterizer::Path
+{
+    struct Edge
+    {
+        double x0, y0, x1, y1;
+        double s0, s1; // Path parameter (segment + t) at either end
+    };
+
+    tk::vector<Edge> edges;
+    tk::vector<tk::vector<int>> rows; // Edges within reach of each row of tiles
+
+    bool closed = true;
+    bool active = false; // False when the mask cannot cover anything
+    double period = 0.0; // Number of segments; path parameters wrap at this on closed paths
+    double minX = 0.0, minY = 0.0, maxX = 0.0, maxY = 0.0;
+
+    // Buffer pixels from here on.
+    double expansion = 0.0;
+    double feather = 0.0; // Half of the mask feather, applied on both sides
+    double reach = 0.0;   // Beyond this distance from every edge, coverage is 0 or 1
+
+    // Feather points sorted by path parameter.
+    tk::vector<double> outerS, outerR;
+    tk::vector<double> innerS, innerR;
+};
+
+namespace
+{
+
+// Sorts feather points of one type by path parameter.
+void sortFeathers(tk::vector<double> &s, tk::vector<double> &r)
+{
+    tk::vector<size_t> order(s.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return s[a] < s[b]; });
+    tk::vector<double> sortedS, sortedR;
+    for (size_t i : order)
+    {
+        sortedS.push_back(s[i]);
+        sortedR.push_back(r[i]);
+    }
+    s = std::move(sortedS);
+    r = std::move(sortedR);
+}
+
+// Feather radius at path parameter at, interpolated between the surrounding points.
+double radiusAt(const tk::vector<double> &s, const tk::vector<double> &r, double at, double period, bool closed)
+{
+    const size_t n = s.size();
+    if (n == 0)
+    {
+        return 0.0;
+    }
+    if (n == 1)
+    {
+        return r[0];
+    }
+    size_t upper = std::upper_bound(s.begin(), s.end(), at) - s.begin();
+    double s0, r0, s1, r1;
+    if (upper == 0)
+    {
+        if (!closed)
+        {
+            return r.front();
+        }
+        s0 = s.back() - period;
+        r0 = r.back();
+        s1 = s.front();
+        r1 = r.front();
+    }
+    else if (upper == n)
+    {
+        if (!closed)
+        {
+            return r.back();
+        }
+        s0 = s.back();
+        r0 = r.back();
+        s1 = s.front() + period;
+        r1 = r.front();
+    }
+    else
+    {
+        s0 = s[upper - 1];
+        r0 = r[upper - 1];
+        s1 = s[upper];
+        r1 = r[upper];
+    }
+    double span = s1 - s0;
+    return span > 0.0 ? r0 + (r1 - r0) * (at - s0) / span : r0;
+}
+
+std::unique_ptr<MaskRasterizer::Path> flatten(const MaskShape &mask, const MaskRasterizerOptions &options)
+{
+    auto path = std::make_unique<MaskRasterizer::Path>();
+    const auto &outline = mask.outline;
+    const size_t numVertices = outline.numVertices();
+    const double scale = options.scale;
+
+    path->closed = !outline.open;
+    path->expansion = mask.expansion * scale;
+    path->feather = 0.5 * std::max(0.0, mask.feather) * scale;
+    path->active = mask.mode != MaskMode::NONE && numVertices >= 2 && (path->closed || path->expansion > 0.0);
+    if (!path->active)
+    {
+        return path;
+    }
+
+    const size_t numSegments = path->closed ? numVertices : numVertices - 1;
+    path->period = static_cast<double>(numSegments);
+    auto px = [&](double x) { return x * scale + options.offsetX; };
+    auto py = [&](double y) { return y * scale + options.offsetY; };
+    const double tolerance = std::max(options.tolerance, 1e-3);
+
+    for (size_t i = 0; i < numSegments; ++i)
+    {
+        const size_t j = (i + 1) % numVertices;
+        const double x0 = px(outline.x[i]), y0 = py(outline.y[i]);
+        const double x1 = px(outline.x[i] + outline.outX[i]), y1 = py(outline.y[i] + outline.outY[i]);
+        const double x2 = px(outline.x[j] + outline.inX[j]), y2 = py(outline.y[j] + outline.inY[j]);
+        const double x3 = px(outline.x[j]), y3 = py(outline.y[j]);
+
+        // Wang's formula: enough steps that the polyline stays within tolerance of the curve.
+        double dd = std::max(std::hypot(x0 - 2 * x1 + x2, y0 - 2 * y1 + y2),
+                             std::hypot(x1 - 2 * x2 + x3, y1 - 2 * y2 + y3));
+        int steps = std::clamp(static_cast<int>(std::ceil(std::sqrt(0.75 * dd / tolerance))), 1, 1024);
+
+        double lastX = x0, lastY = y0, lastS = static_cast<double>(i);
+        for (int k = 1; k <= steps; ++k)
+        {
+            double t = static_cast<double>(k) / steps;
+            double u = 1.0 - t;
+            double b0 = u * u * u, b1 = 3 * u * u * t, b2 = 3 * u * t * t, b3 = t * t * t;
+            double x = b0 * x0 + b1 * x1 + b2 * x2 + b3 * x3;
+            double y = b0 * y0 + b1 * y1 + b2 * y2 + b3 * y3;
+            double s = static_cast<double>(i) + t;
+            path->edges.push_back({lastX, lastY, x, y, lastS, s});
+            lastX = x;
+            lastY = y;
+            lastS = s;
+        }
+    }
+
+    for (size_t f = 0; f < outline.numFeathers(); ++f)
+    {
+        double s = outline.featherSegment[f] + outline.featherSegmentT[f];
+        double r = std::abs(outline.featherRadius[f]) * scale;
+        if (outline.featherType[f] == MaskFeatherType::INNER)
+        {
+            path->innerS.push_back(s);
+            path->innerR.push_back(r);
+        }
+        else
+        {
+            path->outerS.push_back(s);
+            path->outerR.push_back(r);
+        }
+    }
+    sortFeathers(path->outerS, path->outerR);
+    sortFeathers(path->innerS, path->innerR);
+
+    double maxOuter = path->outerR.empty() ? 0.0 : *std::max_element(path->outerR.begin(), path->outerR.end());
+    double maxInner = path->innerR.empty() ? 0.0 : *std::max_element(path->innerR.begin(), path->innerR.end());
+    path->reach = std::abs(path->expansion) + path->feather + std::max(maxOuter, maxInner) + 1.0;
+
+    path->minX = path->minY = std::numeric_limits<double>::max();
+    path->maxX = path->maxY = std::numeric_limits<double>::lowest();
+    for (const auto &e : path->edges)
+    {
+        path->minX = std::min({path->minX, e.x0, e.x1});
+        path->maxX = std::max({path->maxX, e.x0, e.x1});
+        path->minY = std::min({path->minY, e.y0, e.y1});
+        path->maxY = std::max({path->maxY, e.y0, e.y1});
+    }
+
+    const int tile = std::max(1, options.tileSize);
+    const int tileRows = (options.height + tile - 1) / tile;
+    path->rows.resize(tileRows);
+    for (size_t n = 0; n < path->edges.size(); ++n)
+    {
+        const auto &e = path->edges[n];
+        double lo = std::min(e.y0, e.y1) - path->reach;
+        double hi = std::max(e.y0, e.y1) + path->reach;
+        int r0 = std::max(0, static_cast<int>(std::floor(lo / tile)));
+        int r1 = std::min(tileRows - 1, static_cast<int>(std::floor(hi / tile)));
+        for (int r = r0; r <= r1; ++r)
+        {
+            path->rows[r].push_back(static_cast<int>(n));
+        }
+    }
+    return path;
+}
+
+struct Tile
+{
+    int x0, y0, width, height, row;
+};
+
+// Coverage of one mask over a tile, before inversion and opacity.
+void coverTile(const MaskRasterizer::Path &path, const Tile &tile, MaskFeatherFalloff falloff, float *cov,
+               tk::vector<int> &winding, tk::vector<float> &dist2, tk::vector<float> &param)
+{
+    const size_t count = static_cast<size_t>(tile.width) * tile.height;
+    const double reach = path.reach;
+    if (!path.active || tile.x0 + tile.width < path.minX - reach || tile.x0 > path.maxX + reach ||
+        tile.y0 + tile.height < path.minY - reach || tile.y0 > path.maxY + reach)
+    {
+        std::fill(cov, cov + count, 0.0f);
+        return;
+    }
+    const auto &band = path.rows[tile.row];
+
+    // Nonzero winding at each pixel centre. Crossings are accumulated as deltas at
+    // the first pixel to their right and summed along the row.
+    winding.assign(count, 0);
+    if (path.closed)
+    {
+        tk::vector<int> delta(tile.width + 1);
+        for (int y = 0; y < tile.height; ++y)
+        {
+            std::fill(delta.begin(), delta.end(), 0);
+            const double yc = tile.y0 + y + 0.5;
+            for (int n : band)
+            {
+                const auto &e = path.edges[n];
+                if ((e.y0 <= yc) == (e.y1 <= yc))
+                {
+                    continue;
+                }
+                double x = e.x0 + (yc - e.y0) * (e.x1 - e.x0) / (e.y1 - e.y0);
+                int index = static_cast<int>(std::ceil(x - 0.5)) - tile.x0;
+                delta[std::clamp(index, 0, tile.width)] += e.y1 > e.y0 ? 1 : -1;
+            }
+            int *row = winding.data() + static_cast<size_t>(y) * tile.width;
+            int sum = 0;
+            for (int x = 0; x < tile.width; ++x)
+            {
+                sum += delta[x];
+                row[x] = sum;
+            }
+        }
+    }
+
+    // Squared distance from each pixel centre to the nearest edge within reach.
+    const float far = static_cast<float>(reach * reach);
+    dist2.assign(count, far);
+    param.assign(count, 0.0f);
+    for (int n : band)
+    {
+        const auto &e = path.edges[n];
+        int bx0 = std::max(tile.x0, static_cast<int>(std::floor(std::min(e.x0, e.x1) - reach)));
+        int bx1 = std::min(tile.x0 + tile.width, static_cast<int>(std::ceil(std::max(e.x0, e.x1) + reach)));
+        int by0 = std::max(tile.y0, static_cast<int>(std::floor(std::min(e.y0, e.y1) - reach)));
+        int by1 = std::min(tile.y0 + tile.height, static_cast<int>(std::ceil(std::max(e.y0, e.y1) + reach)));
+        if (bx0 >= bx1 || by0 >= by1)
+        {
+            continue;
+        }
+        const double dx = e.x1 - e.x0, dy = e.y1 - e.y0;
+        const double len2 = dx * dx + dy * dy;
+        const double inv = len2 > 0.0 ? 1.0 / len2 : 0.0;
+        for (int y = by0; y < by1; ++y)
+        {
+            const double vy = y + 0.5 - e.y0;
+            float *d = dist2.data() + static_cast<size_t>(y - tile.y0) * tile.width - tile.x0;
+            float *p = param.data() + static_cast<size_t>(y - tile.y0) * tile.width - tile.x0;
+            // Branch-free inner loop, left for the compiler to vectorise.
+            for (int x = bx0; x < bx1; ++x)
+            {
+                const double vx = x + 0.5 - e.x0;
+                const double t = std::clamp((vx * dx + vy * dy) * inv, 0.0, 1.0);
+                const double ex = vx - t * dx, ey = vy - t * dy;
+                const float d2 = static_cast<float>(ex * ex + ey * ey);
+                const bool closer = d2 < d[x];
+                d[x] = closer ? d2 : d[x];
+                p[x] = closer ? static_cast<float>(e.s0 + t * (e.s1 - e.s0)) : p[x];
+            }
+        }
+    }
+
+    const bool variable = !path.outerS.empty() || !path.innerS.empty();
+    for (size_t i = 0; i < count; ++i)
+    {
+        const bool inside = winding[i] != 0;
+        if (dist2[i] >= far)
+        {
+            cov[i] = inside ? 1.0f : 0.0f;
+            continue;
+        }
+        const double dist = std::sqrt(static_cast<double>(dist2[i]));
+        const double e = (inside ? dist : -dist) + path.expansion;
+        double wOut = path.feather, wIn = path.feather;
+        if (variable)
+        {
+            wOut += radiusAt(path.outerS, path.outerR, param[i], path.period, path.closed);
+            wIn += radiusAt(path.innerS, path.innerR, param[i], path.period, path.closed);
+        }
+        wOut = std::max(wOut, 0.5);
+        wIn = std::max(wIn, 0.5);
+        double t = std::clamp((e + wOut) / (wIn + wOut), 0.0, 1.0);
+        if (falloff == MaskFeatherFalloff::SMOOTH)
+        {
+            t = t * t * (3.0 - 2.0 * t);
+        }
+        cov[i] = static_cast<float>(t);
+    }
+}
+
+inline void store(float c, float &dst)
+{
+    dst = c;
+}
+
+inline void store(float c, A_u_short &dst)
+{
+    dst = static_cast<A_u_short>(c * PF_MAX_CHAN16 + 0.5f);
+}
+
+inline void store(float c, A_u_char &dst)
+{
+    dst = static_cast<A_u_char>(c * PF_MAX_CHAN8 + 0.5f);
+}
+
+} // namespace
+
+MaskShape MaskShape::fromMask(const tk::shared_ptr<Mask> &mask, double time)
+{
+    CheckNotNull(mask.get(), "Error Reading Mask Shape. Mask is Null");
+    MaskShape shape(mask->outline()->getValue(LTimeMode::CompTime, time)->readAll(), mask->mode());
+    shape.inverted = mask->invert();
+    shape.opacity = mask->opacity()->getValue(LTimeMode::CompTime, time) / 100.0;
+    shape.expansion = mask->expansion()->getValue(LTimeMode::CompTime, time);
+    auto feather = mask->feather()->getValue(LTimeMode::CompTime, time);
+    shape.feather = std::max(feather.x, feather.y);
+    shape.falloff = mask->featherFalloff();
+    return shape;
+}
+
+MaskRasterizer::MaskRasterizer(const MaskRasterizerOptions &options) : m_options(options) {}
+
+MaskRasterizer::~MaskRasterizer() = default;
+
+void MaskRasterizer::add(const MaskShape &mask)
+{
+    m_masks.push_back(mask);
+    m_paths.push_back(flatten(mask, m_options));
+}
+
+void MaskRasterizer::clear()
+{
+    m_masks.clear();
+    m_paths.clear();
+}
+
+template <typename T> void MaskRasterizer::run(T *dst, size_t rowStride) const
+{
+    const int width = m_options.width, height = m_options.height;
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+    CheckNotNull(dst, "Error Rasterizing Masks. Buffer is Null");
+    const int tile = std::max(1, m_options.tileSize);
+    const int tilesX = (width + tile - 1) / tile;
+    const int tilesY = (height + tile - 1) / tile;
+
+    // AE starts from an empty layer when the first mask adds, and from a full one otherwise.
+    int first = -1;
+    for (size_t m = 0; m < m_masks.size() && first < 0; ++m)
+    {
+        if (m_masks[m].mode != MaskMode::NONE)
+        {
+            first = static_cast<int>(m);
+        }
+    }
+    float start = 1.0f;
+    if (first >= 0)
+    {
+        MaskMode mode = m_masks[first].mode;
+        if (mode == MaskMode::ADD || mode == MaskMode::ACCUM || mode == MaskMode::LIGHTEN || mode == MaskMode::DIFF)
+        {
+            start = 0.0f;
+        }
+    }
+
+    parallelFor(static_cast<size_t>(tilesX) * tilesY, m_options.maxThreads, [&](size_t index) {
+        Tile t;
+        t.row = static_cast<int>(index / tilesX);
+        t.x0 = static_cast<int>(index % tilesX) * tile;
+        t.y0 = t.row * tile;
+        t.width = std::min(tile, width - t.x0);
+        t.height = std::min(tile, height - t.y0);
+        const size_t count = static_cast<size_t>(t.width) * t.height;
+
+        tk::vector<float> result(count, start);
+        tk::vector<float> cov(count);
+        tk::vector<int> winding;
+        tk::vector<float> dist2, param;
+        for (size_t m = 0; m < m_masks.size(); ++m)
+        {
+            const MaskShape &mask = m_masks[m];
+            if (mask.mode == MaskMode::NONE)
+            {
+                continue;
+            }
+            coverTile(*m_paths[m], t, mask.falloff, cov.data(), winding, dist2, param);
+
+            // Opacity blends each mode's result with the stack so far.
+            const float opacity = static_cast<float>(std::clamp(mask.opacity, 0.0, 1.0));
+            for (size_t i = 0; i < count; ++i)
+            {
+                const float r = result[i];
+                const float c = mask.inverted ? 1.0f - cov[i] : cov[i];
+                float out;
+                switch (mask.mode)
+                {
+                case MaskMode::SUBTRACT:
+                    out = std::max(0.0f, r - c);
+                    break;
+                case MaskMode::INTERSECT:
+                    out = r * c;
+                    break;
+                case MaskMode::LIGHTEN:
+                    out = std::max(r, c);
+                    break;
+                case MaskMode::DARKEN:
+                    out = std::min(r, c);
+                    break;
+                case MaskMode::DIFF:
+                    out = std::abs(r - c);
+                    break;
+                default:
+                    out = std::min(1.0f, r + c);
+                    break;
+                }
+                result[i] = r + opacity * (out - r);
+            }
+        }
+
+        for (int y = 0; y < t.height; ++y)
+        {
+            const float *src = result.data() + static_cast<size_t>(y) * t.width;
+            T *row = dst + static_cast<size_t>(t.y0 + y) * rowStride + t.x0;
+            for (int x = 0; x < t.width; ++x)
+            {
+                store(src[x], row[x]);
+            }
+        }
+    });
+}
+
+tk::vector<float> MaskRasterizer::rasterize() const
+{
+    tk::vector<float> coverage(static_cast<size_t>(std::max(0, m_options.width)) * std::max(0, m_options.height));
+    run(coverage.data(), static_cast<size_t>(m_options.width));
+    return coverage;
+}
+
+void MaskRasterizer::rasterize(float *dst, size_t rowStride) const
+{
+    run(dst, rowStride);
+}
+
+void MaskRasterizer::rasterize(A_u_short *dst, size_t rowStride) const
+{
+    run(dst, rowStride);
+}
+
+void MaskRasterizer::rasterize(A_u_char *dst, size_t rowStride) const
+{
+    run(dst, rowStride);
+}
+
+MaskCoverageStats MaskRasterizer::analyze(const float *coverage, int width, int height, size_t rowStride)
+{
+    MaskCoverageStats stats;
+    double sumX = 0.0, sumY = 0.0;
+    for (int y = 0; y < height; ++y)
+    {
+        const float *row = coverage + static_cast<size_t>(y) * rowStride;
+        double rowSum = 0.0, rowX = 0.0;
+        for (int x = 0; x < width; ++x)
+        {
+            rowSum += row[x];
+            rowX += row[x] * (x + 0.5);
+        }
+        stats.area += rowSum;
+        sumX += rowX;
+        sumY += rowSum * (y + 0.5);
+    }
+    if (stats.area > 0.0)
+    {
+        stats.centroidX = sumX / stats.area;
+        stats.centroidY = sumY / stats.area;
+    }
+    return stats;
+}
+
+} // namespace ae
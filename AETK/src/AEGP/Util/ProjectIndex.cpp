@@ -0,0 +1,124 @@
+#include "AETK/AEGP/Util/ProjectIndex.hpp"
+#include "AETK/AEGP/Util/Factories.hpp"
+
+tk::shared_ptr<const ProjectIndex> ProjectIndex::build(ProjectPtr project)
+{
+    // Read before the walk, so an edit racing the build leaves the snapshot stale rather than wrong.
+    uint64_t generation = s_generation.load(std::memory_order_relaxed);
+
+    auto future = ae::ScheduleOrExecute([project]() {
+        CheckNotNull(project.get(), "Error Building Project Index. Project is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+        auto index = tk::make_shared<ProjectIndex>();
+        index->m_project = project;
+
+        A_Boolean dirty = FALSE;
+        AE_CHECK(suites.ProjSuite6()->AEGP_ProjectIsDirty(*project, &dirty));
+        index->m_dirty = dirty != FALSE;
+
+        AEGP_ItemH rootH;
+        AE_CHECK(suites.ProjSuite6()->AEGP_GetProjectRootFolder(*project, &rootH));
+
+        tk::vector<AEGP_ItemH> parentHandles;
+        auto add = [&](AEGP_ItemH itemH, AEGP_ItemH parentH) {
+            A_long id;
+            AE_CHECK(suites.ItemSuite9()->AEGP_GetItemID(itemH, &id));
+            AEGP_ItemType type;
+            AE_CHECK(suites.ItemSuite9()->AEGP_GetItemType(itemH, &type));
+            AEGP_MemHandle nameH;
+            AE_CHECK(suites.ItemSuite9()->AEGP_GetItemName(pluginID, itemH, &nameH));
+
+            int self = static_cast<int>(index->m_ids.size());
+            index->m_ids.push_back(id);
+            index->m_handles.push_back(itemH);
+            index->m_types.push_back(ItemType(type));
+            index->m_names.push_back(ae::intern(memHandleToString(nameH)));
+            index->m_byID.emplace(id, self);
+            index->m_byHandle.emplace(itemH, self);
+            parentHandles.push_back(parentH);
+        };
+
+        add(rootH, nullptr);
+
+        AEGP_ItemH itemH = nullptr;
+        AE_CHECK(suites.ItemSuite9()->AEGP_GetFirstProjItem(*project, &itemH));
+        while (itemH)
+        {
+            if (itemH != rootH)
+            {
+                AEGP_ItemH parentH = nullptr;
+                AE_CHECK(suites.ItemSuite9()->AEGP_GetItemParentFolder(itemH, &parentH));
+                add(itemH, parentH ? parentH : rootH);
+            }
+            AEGP_ItemH nextH = nullptr;
+            AE_CHECK(suites.ItemSuite9()->AEGP_GetNextProjItem(*project, itemH, &nextH));
+            itemH = nextH;
+        }
+        return std::make_pair(index, std::move(parentHandles));
+    });
+    auto [index, parentHandles] = future.get();
+
+    // Parents and children lists are resolved off the main thread.
+    const int n = index->size();
+    index->m_parents.assign(n, -1);
+    index->m_childStart.assign(n + 1, 0);
+    for (int i = 1; i < n; ++i)
+    {
+        auto it = index->m_byHandle.find(parentHandles[i]);
+        int parent = it != index->m_byHandle.end() ? it->second : 0;
+        index->m_parents[i] = parent;
+        ++index->m_childStart[parent + 1];
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        index->m_childStart[i + 1] += index->m_childStart[i];
+    }
+    index->m_childList.resize(n > 0 ? n - 1 : 0);
+    tk::vector<int> fill(index->m_childStart.begin(), index->m_childStart.end() - 1);
+    for (int i = 1; i < n; ++i)
+    {
+        index->m_childList[fill[index->m_parents[i]]++] = i;
+    }
+
+    index->m_generation = generation;
+    return index;
+}
+
+tk::shared_ptr<const ProjectIndex> ProjectIndex::current(ProjectPtr project)
+{
+    CheckNotNull(project.get(), "Error Getting Project Index. Project is Null");
+    // Never hold s_mutex across a task: a worker waiting on the main thread
+    // with the lock held would deadlock against a main-thread caller.
+    bool dirty = ProjSuite().ProjectIsDirty(project);
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (s_current && AEGP_ProjectH(*s_current->m_project) == AEGP_ProjectH(*project) &&
+            s_current->m_generation == s_generation.load(std::memory_order_relaxed) && s_current->m_dirty == dirty)
+        {
+            return s_current;
+        }
+    }
+    auto index = build(project);
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_current = index;
+    return index;
+}
+
+int ProjectIndex::findID(A_long id) const
+{
+    auto it = m_byID.find(id);
+    return it != m_byID.end() ? it->second : -1;
+}
+
+int ProjectIndex::find(AEGP_ItemH item) const
+{
+    auto it = m_byHandle.find(item);
+    return it != m_byHandle.end() ? it->second : -1;
+}
+
+tk::shared_ptr<Item> ProjectIndex::createItem(int i) const
+{
+    return IdentityMap::GetInstance().item(*m_project, item(i), id(i), type(i));
+}
@@ -1,11 +1,34 @@
 #include "AETK/AEGP/Util/Properties.hpp"
 #include "AETK/AEGP/Util/Factories.hpp"
+#include "AETK/AEGP/Util/Context.hpp"
+
+StreamRefPtr BaseProperty::stream() const
+{
+    auto property = std::atomic_load(&m_property);
+    if (!property && m_resolveStream)
+    {
+        // Two threads may both resolve; the loser's ref is simply released.
+        property = m_resolveStream();
+        std::atomic_store(&m_property, property);
+    }
+    return property;
+}
+
+A_Time BaseProperty::toTime(double seconds) const
+{
+    return m_timeContext ? m_timeContext->toTime(seconds) : SecondsToTime(seconds);
+}
+
+double BaseProperty::toSeconds(const A_Time &time) const
+{
+    return m_timeContext ? ae::TimeContext::toSeconds(time) : TimeToSeconds(time);
+}
 
 std::string BaseProperty::getName() const
 {
     try
     {
-        return StreamSuite().GetStreamName(m_property, TRUE);
+        return StreamSuite().GetStreamName(stream(), TRUE);
     }
     catch (const AEException &e)
     {
@@ -16,22 +39,23 @@ std::string BaseProperty::getName() const
 void BaseProperty::setName(const std::string &name)
 {
 
-    DynamicStreamSuite().SetStreamName(m_property, name);
+    DynamicStreamSuite().SetStreamName(stream(), name);
 }
 
 std::shared_ptr<BaseProperty> BaseProperty::duplicate()
 {
 
-    auto newStream = DynamicStreamSuite().DuplicateStream(m_property);
-    auto stream = DynamicStreamSuite().GetNewStreamRefByIndex(m_property, newStream);
-    return PropertyFactory::CreateProperty(stream);
+    auto newStream = DynamicStreamSuite().DuplicateStream(stream());
+    PropertyPathCache::invalidateAll();
+    auto childStream = DynamicStreamSuite().GetNewStreamRefByIndex(stream(), newStream);
+    return PropertyFactory::CreateProperty(childStream);
 }
 
 std::string BaseProperty::matchName() const
 {
     try
     {
-        return DynamicStreamSuite().GetMatchname(m_property);
+        return DynamicStreamSuite().GetMatchname(stream());
     }
     catch (const AEException &e)
     {
@@ -41,76 +65,80 @@ std::string BaseProperty::matchName() const
 
 void BaseProperty::reOrder(int index)
 {
-    DynamicStreamSuite().ReorderStream(m_property, index);
+    DynamicStreamSuite().ReorderStream(stream(), index);
+    PropertyPathCache::invalidateAll();
 }
 
 std::shared_ptr<BaseProperty> BaseProperty::getProperty(const std::string &name) const
 {
 
-    auto stream = DynamicStreamSuite().GetNewStreamRefByMatchname(m_property, name);
-    return PropertyFactory::CreateProperty(stream);
+    auto childStream = DynamicStreamSuite().GetNewStreamRefByMatchname(stream(), name);
+    return PropertyFactory::CreateProperty(childStream);
 }
 
 std::shared_ptr<BaseProperty> BaseProperty::getPropertyByIndex(int index) const
 {
 
-    auto stream = DynamicStreamSuite().GetNewStreamRefByIndex(m_property, index);
-    return PropertyFactory::CreateProperty(stream);
+    auto childStream = DynamicStreamSuite().GetNewStreamRefByIndex(stream(), index);
+    return PropertyFactory::CreateProperty(childStream);
 }
 
 void BaseProperty::addProperty(const std::string &name) const
 {
 
-    if (DynamicStreamSuite().CanAddStream(m_property, name))
+    if (DynamicStreamSuite().CanAddStream(stream(), name))
     {
-        DynamicStreamSuite().AddStream(m_property, name);
+        DynamicStreamSuite().AddStream(stream(), name);
+        PropertyPathCache::invalidateAll();
     }
 }
 
 void BaseProperty::removeProperty(const std::string &name) const
 {
 
-    auto stream = DynamicStreamSuite().GetNewStreamRefByMatchname(m_property, name);
-    if (stream)
+    auto childStream = DynamicStreamSuite().GetNewStreamRefByMatchname(stream(), name);
+    if (childStream)
     {
-        DynamicStreamSuite().DeleteStream(stream);
+        DynamicStreamSuite().DeleteStream(childStream);
+        PropertyPathCache::invalidateAll();
     }
 }
 
 void BaseProperty::removeProperty(int index) const
 {
 
-    auto stream = DynamicStreamSuite().GetNewStreamRefByIndex(m_property, index);
-    if (stream)
+    auto childStream = DynamicStreamSuite().GetNewStreamRefByIndex(stream(), index);
+    if (childStream)
     {
-        DynamicStreamSuite().DeleteStream(stream);
+        DynamicStreamSuite().DeleteStream(childStream);
+        PropertyPathCache::invalidateAll();
     }
 }
 
 int BaseProperty::numKeys()
 {
-    int numKeys = KeyframeSuite().GetStreamNumKFs(m_property);
+    int numKeys = KeyframeSuite().GetStreamNumKFs(stream());
     return numKeys;
 }
 
 KeyFrame BaseProperty::getKeyframe(int index) // Gets the Key at the given index.
 {
-    auto keyNum = KeyframeSuite().GetStreamNumKFs(m_property);
+    auto keyNum = KeyframeSuite().GetStreamNumKFs(stream());
     if (index >= keyNum)
     {
         throw std::out_of_range("Keyframe index out of range");
     }
     auto keyIndex = index;
-    auto time = KeyframeSuite().GetKeyframeTime(m_property, keyIndex, LTimeMode::CompTime).toSeconds();
-    auto value = KeyframeSuite().GetNewKeyframeValue(m_property, keyIndex);
-    auto flags = KeyframeSuite().GetKeyframeFlags(m_property, keyIndex);
-    auto interp = KeyframeSuite().GetKeyframeInterpolation(m_property, keyIndex);
+    auto time = toSeconds(KeyframeSuite().GetKeyframeTime(stream(), keyIndex, LTimeMode::CompTime).toAEGP());
+    auto value = KeyframeSuite().GetNewKeyframeValue(stream(), keyIndex);
+    auto flags = KeyframeSuite().GetKeyframeFlags(stream(), keyIndex);
+    auto interp = KeyframeSuite().GetKeyframeInterpolation(stream(), keyIndex);
     auto inInterp = std::get<0>(interp);
     auto outInterp = std::get<1>(interp);
-    auto tangents = KeyframeSuite().GetNewKeyframeSpatialTangents(m_property, keyIndex);
+    auto tangents = KeyframeSuite().GetNewKeyframeSpatialTangents(stream(), keyIndex);
     auto inTan = std::get<0>(tangents);
     auto outTan = std::get<1>(tangents);
-    auto ease = KeyframeSuite().GetKeyframeTemporalEase(m_property, keyIndex, 0);
+    auto ease = KeyframeSuite().GetKeyframeTemporalEase(stream(), keyIndex, 0);
     auto inEase = std::get<0>(ease);
     auto outEase = std::get<1>(ease);
     KeyFrame config(time);
@@ -126,7 +154,7 @@ KeyFrame BaseProperty::getKeyframe(int index) // Gets the Key at the given index
 
 inline tk::vector<KeyFrame> BaseProperty::getKeyframes() // Gets all the keys
 {
-    auto keyNum = KeyframeSuite().GetStreamNumKFs(m_property);
+    auto keyNum = KeyframeSuite().GetStreamNumKFs(stream());
     tk::vector<KeyFrame> keyframes;
     for (int i = 0; i < keyNum; i++)
     {
@@ -140,10 +168,10 @@ inline KeyFrame BaseProperty::getNearestKeyframe(double time) // Gets the neares
     double nearestTimeDifference = 1e308; // Set to a large number
     int nearestKeyIndex = -1;
 
-    int keyNum = KeyframeSuite().GetStreamNumKFs(m_property);
+    int keyNum = KeyframeSuite().GetStreamNumKFs(stream());
     for (int i = 0; i < keyNum; i++)
     {
-        auto keyTime = KeyframeSuite().GetKeyframeTime(m_property, i, LTimeMode::CompTime).toSeconds();
+        auto keyTime = toSeconds(KeyframeSuite().GetKeyframeTime(stream(), i, LTimeMode::CompTime).toAEGP());
         double timeDifference = std::abs(keyTime - time);
 
         if (timeDifference < nearestTimeDifference)
@@ -165,8 +193,8 @@ inline KeyFrame BaseProperty::getNearestKeyframe(double time) // Gets the neares
 
 inline void BaseProperty::addKey(const KeyFrame &keyframe) // Adds Keyframe to the property
 {
-    auto akH = KeyframeSuite().StartAddKeyframes(m_property);
-    auto keyIndex = KeyframeSuite().AddKeyframes(akH, LTimeMode::CompTime, SecondsToTime(keyframe.time));
+    auto akH = KeyframeSuite().StartAddKeyframes(stream());
+    auto keyIndex = KeyframeSuite().AddKeyframes(akH, LTimeMode::CompTime, toTime(keyframe.time));
     KeyframeSuite().SetAddKeyframe(akH, keyIndex, makeStreamValue2Ptr(convertToAEValue(keyframe.value)));
     //converttoAEValue(keyframe.value) make this accept streamrefptr as well (for binding)
     //makeStreaValue2otr take streamRefptr as arg, then std::variant, then return streamValue2Ptr
@@ -204,10 +232,10 @@ inline void BaseProperty::addKey(const KeyFrame &keyframe) // Adds Keyframe to t
 
 inline void BaseProperty::addKeys(const tk::vector<KeyFrame> &keyframes) // Adds multiple keyframes to the property
 {
-    auto akH = KeyframeSuite().StartAddKeyframes(m_property);
+    auto akH = KeyframeSuite().StartAddKeyframes(stream());
     for (const auto &keyframe : keyframes)
     {
-        auto keyIndex = KeyframeSuite().AddKeyframes(akH, LTimeMode::CompTime, SecondsToTime(keyframe.time));
+        auto keyIndex = KeyframeSuite().AddKeyframes(akH, LTimeMode::CompTime, toTime(keyframe.time));
         KeyframeSuite().SetAddKeyframe(akH, keyIndex, makeStreamValue2Ptr(convertToAEValue(keyframe.value)));
         setKeyFlags(keyIndex, keyframe.flags);
 
@@ -242,37 +270,42 @@ inline void BaseProperty::addKeys(const tk::vector<KeyFrame> &keyframes) // Adds
     KeyframeSuite().EndAddKeyframes(akH);
 }
 
+KeyframePatch BaseProperty::syncKeys(const tk::vector<KeyFrame> &keyframes, const KeyframeDiffOptions &options)
+{
+    return KeyframeDiff::sync(stream(), keyframes, options, m_timeContext);
+}
+
 inline void BaseProperty::setKeyFlags(AEGP_KeyframeIndex keyIndex, tk::vector<KeyframeFlag> flags)
 {
     for (auto flag : flags)
     {
-        KeyframeSuite().SetKeyframeFlag(m_property, keyIndex, flag, true);
+        KeyframeSuite().SetKeyframeFlag(stream(), keyIndex, flag, true);
     }
 }
 
 inline void BaseProperty::setKeyInterpolation(AEGP_KeyframeIndex keyIndex, KeyInterp inInterp, KeyInterp outInterp)
 {
-    KeyframeSuite().SetKeyframeInterpolation(m_property, keyIndex, inInterp, outInterp);
+    KeyframeSuite().SetKeyframeInterpolation(stream(), keyIndex, inInterp, outInterp);
 }
 
 inline void BaseProperty::setKeyTemporalEase(AEGP_KeyframeIndex keyIndex, A_long dimension, KeyframeEase inEase,
                                              KeyframeEase outEase)
 {
     KeyframeSuite().SetKeyframeTemporalEase(
-        m_property, keyIndex, KeyframeSuite().GetStreamTemporalDimensionality(m_property), inEase, outEase);
+        stream(), keyIndex, KeyframeSuite().GetStreamTemporalDimensionality(stream()), inEase, outEase);
 }
 
 inline void BaseProperty::setKeySpatialTangents(AEGP_KeyframeIndex keyIndex, AEGP_StreamValue2 inTan,
                                                 AEGP_StreamValue2 outTan)
 {
-    KeyframeSuite().SetKeyframeSpatialTangents(m_property, keyIndex, makeStreamValue2Ptr(inTan),
+    KeyframeSuite().SetKeyframeSpatialTangents(stream(), keyIndex, makeStreamValue2Ptr(inTan),
                                                makeStreamValue2Ptr(outTan));
 }
 
 inline AEGP_StreamValue2 BaseProperty::convertToAEValue(const KeyFrame::TangentValue &value)
 {
     AEGP_StreamValue2 aeValue;
-    aeValue.streamH = *m_property;
+    aeValue.streamH = *stream();
     std::visit(overloaded{
                    [&](double val) { aeValue.val.one_d = val; }, [&](TwoDVal val) { aeValue.val.two_d = val.toAEGP(); },
                    [&](ThreeDVal val) { aeValue.val.three_d = val.toAEGP(); },
@@ -286,7 +319,7 @@ inline AEGP_StreamValue2 BaseProperty::convertToAEValue(const KeyFrame::TangentV
 
 KeyFrame::TangentValue BaseProperty::convertToTangentValue(AEGP_StreamValue2 value)
 {
-    switch (StreamSuite().GetStreamType(m_property))
+    switch (StreamSuite().GetStreamType(stream()))
     {
     case StreamType::OneD:
         return value.val.one_d;
@@ -305,7 +338,7 @@ KeyFrame::TangentValue BaseProperty::convertToTangentValue(AEGP_StreamValue2 val
 
 double OneDProperty::getValue(LTimeMode timeMode, double time, bool preExpression) const
 {
-    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(m_property, timeMode, SecondsToTime(time), preExpression);
+    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(stream(), timeMode, toTime(time), preExpression);
     double value = val->get().val.one_d;
     return value;
 }
@@ -315,12 +348,12 @@ void OneDProperty::setValue(double value)
 
     AEGP_StreamValue2 val;
     val.val.one_d = value;
-    StreamSuite().SetStreamValue(m_property, makeStreamValue2Ptr(val));
+    StreamSuite().SetStreamValue(stream(), makeStreamValue2Ptr(val));
 }
 
 TwoDVal TwoDProperty::getValue(LTimeMode timeMode, double time, bool preExpression) const
 {
-    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(m_property, timeMode, SecondsToTime(time), preExpression);
+    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(stream(), timeMode, toTime(time), preExpression);
     TwoDVal value(val->get().val.two_d);
     return value;
 }
@@ -329,12 +362,12 @@ void TwoDProperty::setValue(TwoDVal value)
 {
     AEGP_StreamValue2 val;
     val.val.two_d = value.toAEGP();
-    StreamSuite().SetStreamValue(m_property, makeStreamValue2Ptr(val));
+    StreamSuite().SetStreamValue(stream(), makeStreamValue2Ptr(val));
 }
 
 ThreeDVal ThreeDProperty::getValue(LTimeMode timeMode, double time, bool preExpression) const
 {
-    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(m_property, timeMode, SecondsToTime(time), preExpression);
+    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(stream(), timeMode, toTime(time), preExpression);
     ThreeDVal value(val->get().val.three_d);
     return value;
 }
@@ -343,13 +376,13 @@ void ThreeDProperty::setValue(ThreeDVal value)
 {
     AEGP_StreamValue2 val;
     val.val.three_d = value.toAEGP();
-    StreamSuite().SetStreamValue(m_property, makeStreamValue2Ptr(val));
+    StreamSuite().SetStreamValue(stream(), makeStreamValue2Ptr(val));
 }
 
 ColorVal ColorProperty::getValue(LTimeMode timeMode, double time, bool preExpression) const
 {
 
-    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(m_property, timeMode, SecondsToTime(time), preExpression);
+    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(stream(), timeMode, toTime(time), preExpression);
     ColorVal value(val->get().val.color);
     return value;
 }
@@ -358,70 +391,165 @@ void ColorProperty::setValue(ColorVal value)
 {
     AEGP_StreamValue2 val;
     val.val.color = value.toAEGP();
-    StreamSuite().SetStreamValue(m_property, makeStreamValue2Ptr(val));
+    StreamSuite().SetStreamValue(stream(), makeStreamValue2Ptr(val));
 }
 
 std::shared_ptr<Marker> MarkerProperty::getValue(LTimeMode timeMode, double time, bool preExpression) const
 {
-    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(m_property, timeMode, SecondsToTime(time), preExpression);
+    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(stream(), timeMode, toTime(time), preExpression);
     return std::make_shared<Marker>(makeMarkerValPtr(val->get().val.markerP));
 }
 
 std::shared_ptr<Marker> MarkerProperty::addMarker(double time)
 {
-    auto idx = KeyframeSuite().InsertKeyframe(m_property, LTimeMode::CompTime, SecondsToTime(time));
+    auto idx = KeyframeSuite().InsertKeyframe(stream(), LTimeMode::CompTime, toTime(time));
     MarkerValPtr mrk = MarkerSuite().getNewMarker();
     AEGP_StreamValue2 val;
-    val.streamH = *m_property;
+    val.streamH = *stream();
     val.val.markerP = *mrk;
-    KeyframeSuite().SetKeyframeValue(m_property, idx, makeStreamValue2Ptr(val));
+    KeyframeSuite().SetKeyframeValue(stream(), idx, makeStreamValue2Ptr(val));
     return std::make_shared<Marker>(mrk);
 }
 
 int LayerIDProperty::getValue(LTimeMode timeMode, double time, bool preExpression) const
 {
-    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(m_property, timeMode, SecondsToTime(time), preExpression);
+    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(stream(), timeMode, toTime(time), preExpression);
     int value = val->get().val.layer_id;
     return value;
 }
 
 int MaskIDProperty::getValue(LTimeMode timeMode, double time, bool preExpression) const
 {
-    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(m_property, timeMode, SecondsToTime(time), preExpression);
+    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(stream(), timeMode, toTime(time), preExpression);
     int value = val->get().val.mask_id;
     return value;
 }
 
 std::shared_ptr<MaskOutline> MaskOutlineProperty::getValue(LTimeMode timeMode, double time, bool preExpression) const
 {
-    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(m_property, timeMode, SecondsToTime(time), preExpression);
-    return std::make_shared<MaskOutline>(makeMaskOutlineValPtr(val->get().val.mask));
+    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(stream(), timeMode, toTime(time), preExpression);
+    return std::make_shared<MaskOutline>(makeMaskOutlineValPtr(val->get().val.mask), val);
+}
+
+void MaskOutlineProperty::setValue(const MaskOutlineData &outline)
+{
+    auto future = ae::ScheduleOrExecute([stream = stream(), &outline]() {
+        CheckNotNull(stream.get(), "Error Setting Mask Outline. Stream is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+        // Start from the current value so AE owns the outline handle being edited.
+        A_Time zero{0, 1};
+        AEGP_StreamValue2 value;
+        AE_CHECK(suites.StreamSuite6()->AEGP_GetNewStreamValue(pluginID, *stream, AEGP_LTimeMode_CompTime, &zero,
+                                                               TRUE, &value));
+        A_Err err = A_Err_NONE;
+        try
+        {
+            MaskOutline::writeUnscheduled(value.val.mask, outline);
+            err = suites.StreamSuite6()->AEGP_SetStreamValue(pluginID, *stream, &value);
+        }
+        catch (...)
+        {
+            suites.StreamSuite6()->AEGP_DisposeStreamValue(&value);
+            throw;
+        }
+        suites.StreamSuite6()->AEGP_DisposeStreamValue(&value);
+        AE_CHECK(err);
+    });
+    future.get();
+}
+
+void MaskOutlineProperty::setKeys(const tk::vector<double> &times, const tk::vector<MaskOutlineData> &outlines,
+                                  const std::string &undoName)
+{
+    if (times.size() != outlines.size())
+    {
+        throw AEException("Error Setting Mask Keyframes. Times and Outlines Differ in Length");
+    }
+    if (times.empty())
+    {
+        return;
+    }
+
+    // Read before the edit task; the lookup is a task of its own.
+    const ae::TimeContext grid = m_timeContext ? *m_timeContext : ae::TimeContext::mostRecent();
+    Scoped_Undo_Guard undo(undoName);
+    auto future = ae::ScheduleOrExecute([stream = stream(), grid, &times, &outlines]() {
+        CheckNotNull(stream.get(), "Error Setting Mask Keyframes. Stream is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+        // Each key needs an outline handle AE allocated; take one per key from the
+        // stream and release them all once the keys are committed.
+        tk::vector<AEGP_StreamValue2> values;
+        values.reserve(times.size());
+        auto dispose = [&]() {
+            for (auto &value : values)
+            {
+                suites.StreamSuite6()->AEGP_DisposeStreamValue(&value);
+            }
+        };
+
+        AEGP_AddKeyframesInfoH akH = nullptr;
+        try
+        {
+            AE_CHECK(suites.KeyframeSuite5()->AEGP_StartAddKeyframes(*stream, &akH));
+            for (size_t i = 0; i < times.size(); ++i)
+            {
+                A_Time time = grid.toTimeExact(times[i]);
+                AEGP_KeyframeIndex keyIndex;
+                AE_CHECK(suites.KeyframeSuite5()->AEGP_AddKeyframes(akH, AEGP_LTimeMode_CompTime, &time, &keyIndex));
+
+                AEGP_StreamValue2 value;
+                AE_CHECK(suites.StreamSuite6()->AEGP_GetNewStreamValue(pluginID, *stream, AEGP_LTimeMode_CompTime,
+                                                                       &time, TRUE, &value));
+                values.push_back(value);
+                MaskOutline::writeUnscheduled(value.val.mask, outlines[i]);
+                AE_CHECK(suites.KeyframeSuite5()->AEGP_SetAddKeyframe(akH, keyIndex, &value));
+            }
+            AEGP_AddKeyframesInfoH pending = akH;
+            akH = nullptr;
+            AE_CHECK(suites.KeyframeSuite5()->AEGP_EndAddKeyframes(true, pending));
+        }
+        catch (...)
+        {
+            if (akH)
+            {
+                suites.KeyframeSuite5()->AEGP_EndAddKeyframes(false, akH);
+            }
+            dispose();
+            throw;
+        }
+        dispose();
+    });
+    future.get();
 }
 
 std::shared_ptr<TextDocument> TextDocumentProperty::getValue(LTimeMode timeMode, double time, bool preExpression) const
 {
-    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(m_property, timeMode, SecondsToTime(time), preExpression);
+    StreamValue2Ptr val = StreamSuite().GetNewStreamValue(stream(), timeMode, toTime(time), preExpression);
 
     return std::make_shared<TextDocument>(makeTextDocumentPtr(val->get().val.text_documentH));
 }
 
 int PropertyGroup::getNumProperties() const
 {
-    return DynamicStreamSuite().GetNumStreamsInGroup(m_property);
+    return DynamicStreamSuite().GetNumStreamsInGroup(stream());
 }
 
 std::shared_ptr<BaseProperty> PropertyGroup::getProperty(const std::string &name) const
 {
-    auto stream = DynamicStreamSuite().GetNewStreamRefByMatchname(m_property, name);
-    return PropertyFactory::CreateProperty(stream);
+    auto childStream = DynamicStreamSuite().GetNewStreamRefByMatchname(stream(), name);
+    return PropertyFactory::CreateProperty(childStream);
 }
 
 std::shared_ptr<BaseProperty> PropertyGroup::getPropertyByIndex(int index) const
 {
     try
     {
-        auto stream = DynamicStreamSuite().GetNewStreamRefByIndex(m_property, index);
-        return PropertyFactory::CreateProperty(stream);
+        auto childStream = DynamicStreamSuite().GetNewStreamRefByIndex(stream(), index);
+        return PropertyFactory::CreateProperty(childStream);
     }
     catch (const AEException &e)
     {
@@ -431,26 +559,160 @@ std::shared_ptr<BaseProperty> PropertyGroup::getPropertyByIndex(int index) const
 
 void PropertyGroup::addProperty(const std::string &name) const
 {
-    if (DynamicStreamSuite().CanAddStream(m_property, name))
+    if (DynamicStreamSuite().CanAddStream(stream(), name))
     {
-        DynamicStreamSuite().AddStream(m_property, name);
+        DynamicStreamSuite().AddStream(stream(), name);
+        PropertyPathCache::invalidateAll();
     }
 }
 
 void PropertyGroup::removeProperty(const std::string &name) const
 {
-    auto stream = DynamicStreamSuite().GetNewStreamRefByMatchname(m_property, name);
-    if (stream)
+    auto childStream = DynamicStreamSuite().GetNewStreamRefByMatchname(stream(), name);
+    if (childStream)
     {
-        DynamicStreamSuite().DeleteStream(stream);
+        DynamicStreamSuite().DeleteStream(childStream);
+        PropertyPathCache::invalidateAll();
     }
 }
 
 void PropertyGroup::removeProperty(int index) const
 {
-    auto stream = DynamicStreamSuite().GetNewStreamRefByIndex(m_property, index);
-    if (stream)
+    auto childStream = DynamicStreamSuite().GetNewStreamRefByIndex(stream(), index);
+    if (childStream)
     {
-        DynamicStreamSuite().DeleteStream(stream);
+        DynamicStreamSuite().DeleteStream(childStream);
+        PropertyPathCache::invalidateAll();
     }
 }
+
+std::shared_ptr<BaseProperty> PropertyPathCache::get(const std::string &path)
+{
+    // Entries are keyed on the normalized path, without empty segments, so "A//B/" and "A/B" share one.
+    tk::vector<std::string> segments;
+    tk::vector<ae::Atom> prefixes;
+    std::string prefix;
+    size_t start = 0;
+    while (start <= path.size())
+    {
+        size_t slash = path.find('/', start);
+        std::string segment = path.substr(start, slash == std::string::npos ? std::string::npos : slash - start);
+        if (!segment.empty())
+        {
+            prefix += prefix.empty() ? segment : "/" + segment;
+            segments.push_back(segment);
+            prefixes.push_back(ae::intern(prefix));
+        }
+        if (slash == std::string::npos)
+        {
+            break;
+        }
+        start = slash + 1;
+    }
+    if (segments.empty())
+    {
+        return nullptr;
+    }
+    const ae::Atom key = prefixes.back();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const uint64_t generation = s_generation.load(std::memory_order_relaxed);
+    if (generation != m_generation)
+    {
+        m_cache.clear();
+        m_generation = generation;
+    }
+
+    auto hit = m_cache.find(key);
+    if (hit != m_cache.end())
+    {
+        return hit->second;
+    }
+
+    // Start from the longest prefix that is already resolved.
+    size_t first = segments.size();
+    StreamRefPtr parent = m_root;
+    while (first > 0)
+    {
+        auto cached = m_cache.find(prefixes[first - 1]);
+        if (cached != m_cache.end() && cached->second)
+        {
+            parent = cached->second->getStream();
+            break;
+        }
+        --first;
+    }
+
+    struct Resolved
+    {
+        StreamRefPtr stream;
+        StreamGroupingType grouping;
+        StreamType type;
+    };
+
+    // Resolve the remaining segments in a single main-thread task. The lock is
+    // released meanwhile so a main-thread caller can't deadlock against us.
+    lock.unlock();
+    auto future = ae::ScheduleOrExecute([parent, &segments, first]() {
+        CheckNotNull(parent.get(), "Error Resolving Property Path. Root Stream is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+        tk::vector<Resolved> resolved;
+        AEGP_StreamRefH parentH = *parent;
+        for (size_t i = first; i < segments.size(); ++i)
+        {
+            AEGP_StreamRefH streamH = nullptr;
+            if (suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByMatchname(pluginID, parentH, segments[i].c_str(),
+                                                                              &streamH) != A_Err_NONE ||
+                streamH == nullptr)
+            {
+                break;
+            }
+            Resolved entry{makeStreamRefPtr(streamH), StreamGroupingType::NONE, StreamType::NONE};
+
+            AEGP_StreamGroupingType grouping;
+            AE_CHECK(suites.DynamicStreamSuite4()->AEGP_GetStreamGroupingType(streamH, &grouping));
+            entry.grouping = StreamGroupingType(grouping);
+            if (entry.grouping == StreamGroupingType::LEAF)
+            {
+                AEGP_StreamType type;
+                AE_CHECK(suites.StreamSuite6()->AEGP_GetStreamType(streamH, &type));
+                entry.type = StreamType(type);
+            }
+            resolved.push_back(entry);
+            parentH = streamH;
+        }
+        return resolved;
+    });
+    auto resolved = future.get();
+
+    if (first + resolved.size() < segments.size())
+    {
+        return nullptr; // Path does not exist; misses are not cached since streams may be added later
+    }
+    tk::vector<std::shared_ptr<BaseProperty>> properties;
+    properties.reserve(resolved.size());
+    for (const auto &entry : resolved)
+    {
+        properties.push_back(PropertyFactory::CreateProperty(entry.stream, entry.grouping, entry.type));
+    }
+    std::shared_ptr<BaseProperty> result = properties.back(); // key itself missed, so at least it was resolved
+
+    // An invalidation while the task ran may have made these refs stale; hand them out, but don't cache them.
+    lock.lock();
+    if (s_generation.load(std::memory_order_relaxed) == generation && m_generation == generation)
+    {
+        for (size_t i = 0; i < properties.size(); ++i)
+        {
+            m_cache[prefixes[first + i]] = properties[i];
+        }
+    }
+    return result;
+}
+
+void PropertyPathCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cache.clear();
+}
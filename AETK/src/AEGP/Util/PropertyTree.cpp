@@ -0,0 +1,239 @@
+#include "AETK/AEGP/Util/PropertyTree.hpp"
+#include "AETK/AEGP/Util/Factories.hpp"
+
+namespace
+{
+
+// Appends stream and its subtree to nodes. Must run on the main thread.
+void walkStream(AEGP_StreamRefH stream, int parent, int depth, int index, tk::vector<PropertyNode> &nodes)
+{
+    auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+    AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+    PropertyNode node;
+    node.parent = parent;
+    node.depth = depth;
+    node.index = index;
+
+    AEGP_StreamGroupingType grouping;
+    AE_CHECK(suites.DynamicStreamSuite4()->AEGP_GetStreamGroupingType(stream, &grouping));
+    node.grouping = StreamGroupingType(grouping);
+
+    if (node.isLeaf())
+    {
+        AEGP_StreamType type;
+        AE_CHECK(suites.StreamSuite6()->AEGP_GetStreamType(stream, &type));
+        node.type = StreamType(type);
+        if (type != AEGP_StreamType_NO_DATA)
+        {
+            A_long numKeys = 0;
+            AE_CHECK(suites.KeyframeSuite5()->AEGP_GetStreamNumKFs(stream, &numKeys));
+            node.numKeys = std::max<A_long>(numKeys, 0); // AEGP_NumKF_NO_DATA is negative
+        }
+    }
+
+    A_char matchName[AEGP_MAX_STREAM_MATCH_NAME_SIZE];
+    AE_CHECK(suites.DynamicStreamSuite4()->AEGP_GetMatchName(stream, matchName));
+    node.matchName = ae::intern(matchName);
+
+    AEGP_MemHandle nameH;
+    AE_CHECK(suites.StreamSuite6()->AEGP_GetStreamName(pluginID, stream, FALSE, &nameH));
+    node.name = memHandleToString(nameH);
+
+    AEGP_DynStreamFlags flags;
+    AE_CHECK(suites.DynamicStreamSuite4()->AEGP_GetDynamicStreamFlags(stream, &flags));
+    node.flags = DynStreamFlag(flags);
+
+    A_long numChildren = 0;
+    if (node.isGroup())
+    {
+        AE_CHECK(suites.DynamicStreamSuite4()->AEGP_GetNumStreamsInGroup(stream, &numChildren));
+    }
+    node.numChildren = numChildren;
+
+    int self = static_cast<int>(nodes.size());
+    nodes.push_back(std::move(node));
+
+    for (A_long i = 0; i < numChildren; ++i)
+    {
+        AEGP_StreamRefH childH = nullptr;
+        AE_CHECK(suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByIndex(pluginID, stream, i, &childH));
+        try
+        {
+            walkStream(childH, self, depth + 1, i, nodes);
+        }
+        catch (...)
+        {
+            suites.StreamSuite2()->AEGP_DisposeStream(childH);
+            throw;
+        }
+        suites.StreamSuite2()->AEGP_DisposeStream(childH);
+    }
+    nodes[self].end = static_cast<int>(nodes.size());
+}
+
+} // namespace
+
+PropertyTree PropertyTree::snapshot(LayerPtr layer)
+{
+    auto future = ae::ScheduleOrExecute([layer]() {
+        CheckNotNull(layer.get(), "Error Getting Property Tree. Layer is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+
+        AEGP_StreamRefH rootH;
+        AE_CHECK(suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefForLayer(*SuiteManager::GetInstance().GetPluginID(),
+                                                                           *layer, &rootH));
+        // Keep the root ref; nearly every lazy lookup starts from it.
+        StreamRefPtr root = makeStreamRefPtr(rootH);
+
+        tk::vector<PropertyNode> nodes;
+        walkStream(rootH, -1, 0, 0, nodes);
+        return std::make_pair(std::move(nodes), root);
+    });
+    auto [nodes, root] = future.get();
+
+    PropertyTree tree;
+    tree.m_layer = layer;
+    tree.m_nodes = std::move(nodes);
+    tree.m_streams.resize(tree.m_nodes.size());
+    tree.m_streams[0] = root;
+    return tree;
+}
+
+tk::vector<int> PropertyTree::children(int i) const
+{
+    const auto &node = m_nodes.at(i);
+    tk::vector<int> result;
+    result.reserve(node.numChildren);
+    for (int child = i + 1; child < node.end; child = m_nodes[child].end)
+    {
+        result.push_back(child);
+    }
+    return result;
+}
+
+int PropertyTree::find(int parent, const std::string &matchName) const
+{
+    ae::Atom atom = ae::AtomTable::GetInstance().find(matchName);
+    if (atom == ae::InvalidAtom)
+    {
+        return -1;
+    }
+    const auto &node = m_nodes.at(parent);
+    for (int child = parent + 1; child < node.end; child = m_nodes[child].end)
+    {
+        if (m_nodes[child].matchName == atom)
+        {
+            return child;
+        }
+    }
+    return -1;
+}
+
+int PropertyTree::find(const std::string &path) const
+{
+    if (m_nodes.empty())
+    {
+        return -1;
+    }
+    int current = 0;
+    size_t start = 0;
+    while (start <= path.size() && current != -1)
+    {
+        size_t slash = path.find('/', start);
+        std::string part = path.substr(start, slash == std::string::npos ? std::string::npos : slash - start);
+        if (!part.empty())
+        {
+            current = find(current, part);
+        }
+        if (slash == std::string::npos)
+        {
+            break;
+        }
+        start = slash + 1;
+    }
+    return current;
+}
+
+std::string PropertyTree::path(int i) const
+{
+    tk::vector<int> chain;
+    for (int node = i; node > 0; node = m_nodes.at(node).parent)
+    {
+        chain.push_back(node);
+    }
+    std::string result;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+    {
+        if (!result.empty())
+        {
+            result += '/';
+        }
+        result += matchName(*it);
+    }
+    return result;
+}
+
+StreamRefPtr PropertyTree::stream(int i) const
+{
+    std::unique_lock<std::mutex> lock(*m_streamsMutex);
+    if (m_streams.at(i))
+    {
+        return m_streams[i];
+    }
+
+    // Resolve every missing ancestor in the same task as the node itself.
+    tk::vector<int> chain;
+    int ancestor = i;
+    while (ancestor != -1 && !m_streams[ancestor])
+    {
+        chain.push_back(ancestor);
+        ancestor = m_nodes[ancestor].parent;
+    }
+    std::reverse(chain.begin(), chain.end());
+    StreamRefPtr start = ancestor == -1 ? nullptr : m_streams[ancestor];
+
+    // Don't hold the lock across the task; a main-thread caller would deadlock against us.
+    lock.unlock();
+    auto future = ae::ScheduleOrExecute([this, &chain, start]() {
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+        tk::vector<StreamRefPtr> resolved;
+        resolved.reserve(chain.size());
+        AEGP_StreamRefH parentH = start ? AEGP_StreamRefH(*start) : nullptr;
+        for (int node : chain)
+        {
+            AEGP_StreamRefH streamH = nullptr;
+            if (parentH == nullptr)
+            {
+                CheckNotNull(m_layer.get(), "Error Getting Stream. Layer is Null");
+                AE_CHECK(suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefForLayer(pluginID, *m_layer, &streamH));
+            }
+            else
+            {
+                AE_CHECK(suites.DynamicStreamSuite4()->AEGP_GetNewStreamRefByIndex(pluginID, parentH,
+                                                                                  m_nodes[node].index, &streamH));
+            }
+            resolved.push_back(makeStreamRefPtr(streamH));
+            parentH = streamH;
+        }
+        return resolved;
+    });
+    auto resolved = future.get();
+
+    lock.lock();
+    for (size_t k = 0; k < chain.size(); ++k)
+    {
+        if (!m_streams[chain[k]])
+        {
+            m_streams[chain[k]] = resolved[k];
+        }
+    }
+    return m_streams[i];
+}
+
+tk::shared_ptr<BaseProperty> PropertyTree::property(int i) const
+{
+    const auto &node = m_nodes.at(i);
+    return PropertyFactory::CreateProperty(stream(i), node.grouping, node.type);
+}
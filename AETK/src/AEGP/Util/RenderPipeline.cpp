@@ -0,0 +1,421 @@
+#include "AETK/AEGP/Util/RenderPipeline.hpp"
+#include "AETK/AEGP/Util/WorldUtil.hpp"
+
+#include <cstring>
+#include <deque>
+
+namespace ae
+{
+
+struct RenderPipeline::State : std::enable_shared_from_this<State>
+{
+    // One AE request. Slots never move, so a Slot * is the request's refcon.
+    struct Slot
+    {
+        bool busy = false;
+        bool requested = false; // id is valid
+        size_t index = 0;
+        A_Time time{0, 1};
+        AEGP_AsyncRequestId id = 0;
+        AEGP_LayerRenderOptionsH options = nullptr; // Duplicated once and reused for every request of this slot
+        std::shared_ptr<State> keepAlive;           // Set while busy, so callbacks outlive the pipeline
+    };
+
+    struct PooledWorld
+    {
+        AEGP_WorldH world;
+        AEGP_WorldType type;
+        A_long width;
+        A_long height;
+    };
+
+    State(LayerRenderOptionsPtr options, const RenderPipelineOptions &config)
+        : options(std::move(options)), config(config), slots(std::max<size_t>(config.maxInFlight, 1))
+    {
+        this->config.maxInFlight = slots.size();
+    }
+
+    ~State()
+    {
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        for (auto &slot : slots)
+        {
+            if (slot.options)
+            {
+                suites.LayerRenderOptionsSuite2()->AEGP_Dispose(slot.options);
+            }
+        }
+        for (auto &pooled : pool)
+        {
+            suites.WorldSuite3()->AEGP_Dispose(pooled.world);
+        }
+    }
+
+    size_t capacity() const { return config.maxInFlight + config.maxBuffered; }
+    bool isFull() const { return submitted - delivered >= capacity(); }
+
+    void pump();
+    void complete(Slot &slot, RenderedFrame frame);
+    WorldPtr copyReceipt(AEGP_FrameReceiptH receiptH);
+    WorldPtr wrapWorld(const PooledWorld &pooled);
+
+    static A_Err onFrameReady(AEGP_AsyncRequestId requestId, A_Boolean wasCanceled, A_Err error,
+                              AEGP_FrameReceiptH receiptH, AEGP_AsyncFrameRequestRefcon refcon);
+
+    LayerRenderOptionsPtr options;
+    RenderPipelineOptions config;
+
+    // Guards everything below. Never held across an AE call that may run a callback, or while a world is released.
+    std::mutex mutex;
+    std::condition_variable changed;
+    tk::vector<Slot> slots;
+    std::deque<std::pair<size_t, A_Time>> waiting; // Submitted, not yet requested
+    std::map<size_t, RenderedFrame> done;           // Finished, not yet delivered, by index
+    tk::vector<PooledWorld> pool;
+    size_t submitted = 0;
+    size_t delivered = 0;
+    bool closed = false;
+    bool canceled = false;
+};
+
+// Issues queued times into free slots. Main thread only; the caller holds a reference to the state.
+void RenderPipeline::State::pump()
+{
+    auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+    AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+    for (;;)
+    {
+        Slot *slot = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (canceled || waiting.empty())
+            {
+                return;
+            }
+            for (auto &candidate : slots)
+            {
+                if (!candidate.busy)
+                {
+                    slot = &candidate;
+                    break;
+                }
+            }
+            if (!slot)
+            {
+                return;
+            }
+            slot->busy = true;
+            slot->requested = false;
+            slot->index = waiting.front().first;
+            slot->time = waiting.front().second;
+            slot->keepAlive = shared_from_this();
+            waiting.pop_front();
+        }
+
+        const size_t index = slot->index;
+        const A_Time time = slot->time;
+        try
+        {
+            if (!slot->options)
+            {
+                AE_CHECK(suites.LayerRenderOptionsSuite2()->AEGP_Duplicate(pluginID, *options, &slot->options));
+            }
+            AE_CHECK(suites.LayerRenderOptionsSuite2()->AEGP_SetTime(slot->options, time));
+            AEGP_AsyncRequestId id = 0;
+            AE_CHECK(suites.RenderSuite5()->AEGP_RenderAndCheckoutLayerFrame_Async(
+                slot->options, &State::onFrameReady, reinterpret_cast<AEGP_AsyncFrameRequestRefcon>(slot), &id));
+
+            bool cancelNow = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (slot->busy && slot->index == index) // Not already completed
+                {
+                    slot->id = id;
+                    slot->requested = true;
+                    cancelNow = canceled;
+                }
+            }
+            if (cancelNow) // cancel() ran before the id was known
+            {
+                suites.RenderSuite5()->AEGP_CancelAsyncRequest(id);
+            }
+        }
+        catch (const AEException &)
+        {
+            RenderedFrame frame;
+            frame.index = index;
+            frame.time = time;
+            frame.error = A_Err_GENERIC;
+            complete(*slot, std::move(frame));
+        }
+    }
+}
+
+// Frees slot and queues frame for delivery. frame is released, if dropped, after the lock.
+void RenderPipeline::State::complete(Slot &slot, RenderedFrame frame)
+{
+    std::shared_ptr<State> keepAlive;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        keepAlive = std::move(slot.keepAlive);
+        slot.busy = false;
+        slot.requested = false;
+        if (!canceled)
+        {
+            done.emplace(frame.index, std::move(frame));
+        }
+    }
+    changed.notify_all();
+}
+
+// Copies the receipt's world into a pooled world, so the receipt can go back to AE with the callback. Main thread only.
+WorldPtr RenderPipeline::State::copyReceipt(AEGP_FrameReceiptH receiptH)
+{
+    auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+    AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+
+    AEGP_WorldH source = nullptr;
+    AE_CHECK(suites.RenderSuite5()->AEGP_GetReceiptWorld(receiptH, &source));
+    if (!source)
+    {
+        return nullptr;
+    }
+
+    PooledWorld target{nullptr, AEGP_WorldType_NONE, 0, 0};
+    A_u_long sourceRowBytes = 0;
+    AE_CHECK(suites.WorldSuite3()->AEGP_GetType(source, &target.type));
+    AE_CHECK(suites.WorldSuite3()->AEGP_GetSize(source, &target.width, &target.height));
+    AE_CHECK(suites.WorldSuite3()->AEGP_GetRowBytes(source, &sourceRowBytes));
+    const size_t rowSize = static_cast<size_t>(target.width) * pixelBytes(target.type);
+    if (rowSize == 0 || target.height <= 0)
+    {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = pool.begin(); it != pool.end(); ++it)
+        {
+            if (it->type == target.type && it->width == target.width && it->height == target.height)
+            {
+                target.world = it->world;
+                pool.erase(it);
+                break;
+            }
+        }
+    }
+    if (!target.world)
+    {
+        AE_CHECK(suites.WorldSuite3()->AEGP_New(pluginID, target.type, target.width, target.height, &target.world));
+    }
+    WorldPtr world = wrapWorld(target); // Returns target to the pool if the copy throws
+
+    A_u_long targetRowBytes = 0;
+    AE_CHECK(suites.WorldSuite3()->AEGP_GetRowBytes(target.world, &targetRowBytes));
+    const char *src = baseAddr(suites, source, target.type);
+    char *dst = baseAddr(suites, target.world, target.type);
+    CheckNotNull(src, "Error Copying Rendered Frame. Receipt World has no Pixels");
+    CheckNotNull(dst, "Error Copying Rendered Frame. Pooled World has no Pixels");
+    for (A_long y = 0; y < target.height; ++y)
+    {
+        std::memcpy(dst + y * static_cast<size_t>(targetRowBytes), src + y * static_cast<size_t>(sourceRowBytes),
+                    rowSize);
+    }
+    return world;
+}
+
+// A WorldPtr that puts the world back in the pool on release, or disposes it once the pool is full or gone.
+WorldPtr RenderPipeline::State::wrapWorld(const PooledWorld &pooled)
+{
+    std::weak_ptr<State> weak = shared_from_this();
+    return std::make_shared<WorldH>(pooled.world, [weak, pooled](AEGP_WorldH) {
+        if (auto state = weak.lock())
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->pool.size() < state->capacity())
+            {
+                state->pool.push_back(pooled);
+                return;
+            }
+        }
+        disposeWorld(pooled.world);
+    });
+}
+
+// AE owns receiptH and checks it in after this returns. Main thread.
+A_Err RenderPipeline::State::onFrameReady(AEGP_AsyncRequestId, A_Boolean wasCanceled, A_Err error,
+                                          AEGP_FrameReceiptH receiptH, AEGP_AsyncFrameRequestRefcon refcon)
+{
+    auto *slot = reinterpret_cast<Slot *>(refcon);
+    std::shared_ptr<State> state = slot ? slot->keepAlive : nullptr;
+    if (!state)
+    {
+        return A_Err_NONE;
+    }
+
+    RenderedFrame frame;
+    frame.index = slot->index;
+    frame.time = slot->time;
+    frame.canceled = wasCanceled != FALSE;
+    frame.error = error;
+    bool dropped = false;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        dropped = state->canceled;
+    }
+    if (!dropped && !frame.canceled && error == A_Err_NONE && receiptH)
+    {
+        try
+        {
+            frame.world = state->copyReceipt(receiptH);
+        }
+        catch (const AEException &)
+        {
+            frame.error = A_Err_GENERIC;
+        }
+    }
+    state->complete(*slot, std::move(frame));
+    state->pump();
+    return A_Err_NONE;
+}
+
+RenderPipeline::RenderPipeline(LayerRenderOptionsPtr options, const RenderPipelineOptions &pipelineOptions)
+{
+    CheckNotNull(options.get(), "Error Creating Render Pipeline. Options are Null");
+    m_state = std::make_shared<State>(std::move(options), pipelineOptions);
+}
+
+RenderPipeline::~RenderPipeline()
+{
+    cancel();
+}
+
+size_t RenderPipeline::submit(const A_Time &time)
+{
+    auto state = m_state;
+    size_t index = 0;
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->changed.wait(lock, [&]() { return state->canceled || !state->isFull(); });
+        if (state->canceled)
+        {
+            throw AEException("Error Submitting Render. The Pipeline was Canceled");
+        }
+        if (state->closed)
+        {
+            throw AEException("Error Submitting Render. The Pipeline is Closed");
+        }
+        index = state->submitted++;
+        state->waiting.emplace_back(index, time);
+    }
+    // Not waited on: the request is issued at the next idle, and completions issue the rest.
+    ae::ScheduleOrExecute([state]() { state->pump(); });
+    return index;
+}
+
+bool RenderPipeline::full() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->isFull();
+}
+
+void RenderPipeline::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->closed = true;
+    }
+    m_state->changed.notify_all();
+}
+
+std::optional<RenderedFrame> RenderPipeline::next()
+{
+    auto &state = *m_state;
+    std::unique_lock<std::mutex> lock(state.mutex);
+    for (;;)
+    {
+        if (state.canceled)
+        {
+            return std::nullopt;
+        }
+        auto it = state.config.ordered ? state.done.find(state.delivered) : state.done.begin();
+        if (it != state.done.end())
+        {
+            RenderedFrame frame = std::move(it->second);
+            state.done.erase(it);
+            ++state.delivered;
+            lock.unlock();
+            state.changed.notify_all(); // Room for another submit
+            return frame;
+        }
+        if (state.closed && state.delivered == state.submitted)
+        {
+            return std::nullopt;
+        }
+        state.changed.wait(lock);
+    }
+}
+
+void RenderPipeline::cancel()
+{
+    auto state = m_state;
+    tk::vector<AEGP_AsyncRequestId> ids;
+    std::map<size_t, RenderedFrame> dropped; // Released after the lock, since worlds return to the pool
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->canceled)
+        {
+            return;
+        }
+        state->canceled = true;
+        state->waiting.clear();
+        dropped.swap(state->done);
+        for (const auto &slot : state->slots)
+        {
+            if (slot.busy && slot.requested)
+            {
+                ids.push_back(slot.id);
+            }
+        }
+    }
+    state->changed.notify_all();
+
+    if (!ids.empty())
+    {
+        // Not waited on, so this is safe from the destructor on any thread. Callbacks still arrive and free the slots.
+        ae::ScheduleOrExecute([ids]() {
+            auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+            for (auto id : ids)
+            {
+                suites.RenderSuite5()->AEGP_CancelAsyncRequest(id);
+            }
+        });
+    }
+}
+
+void RenderPipeline::run(LayerRenderOptionsPtr options, const tk::vector<A_Time> &times,
+                         const std::function<void(RenderedFrame &)> &sink, const RenderPipelineOptions &pipelineOptions)
+{
+    RenderPipeline pipeline(std::move(options), pipelineOptions);
+    for (const auto &time : times)
+    {
+        while (pipeline.full()) // Backpressure: hand frames to sink until there is room
+        {
+            auto frame = pipeline.next();
+            if (!frame)
+            {
+                return;
+            }
+            sink(*frame);
+        }
+        pipeline.submit(time);
+    }
+    pipeline.close();
+    while (auto frame = pipeline.next())
+    {
+        sink(*frame);
+    }
+}
+
+} // namespace ae
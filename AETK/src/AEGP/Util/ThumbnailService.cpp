@@ -0,0 +1,852 @@
+#include "AETK/AEGP/Util/ThumbnailService.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+constexpr char kMagic[4] = {'A', 'E', 'T', 'N'};
+constexpr uint32_t kVersion = 1;
+constexpr A_u_long kTimeScale = 30000; // Frame grid of items without a frame rate, such as stills and solids
+constexpr int kMaxDownsample = 16;     // Beyond this, render time no longer drops much
+constexpr const char *kExtension = ".thumb";
+
+// Cache file layout: this header, then width * height * 4 bytes of RGBA.
+struct FileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint64_t session;     // Process that wrote the file
+    int64_t projectTime;  // Project file write time, if the project was saved when rendering; otherwise 0
+    AEGP_TimeStamp stamp; // Taken before the render
+    uint32_t reserved;
+};
+static_assert(sizeof(FileHeader) == 40, "Thumbnail file header must not be padded");
+
+uint64_t sessionToken()
+{
+    static const uint64_t token = []() {
+        std::random_device device;
+        const uint64_t high = device(), low = device();
+        return (high << 32) ^ low ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    }();
+    return token;
+}
+
+struct Fnv
+{
+    uint64_t hash = 14695981039346656037ull;
+
+    void add(const void *data, size_t size)
+    {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    template <typename T> void add(const T &value) { add(&value, sizeof(value)); }
+};
+
+// The duration of one frame at fps, exact for integer and NTSC (x/1.001) rates; the fallback grid if fps is unset.
+A_Time frameDuration(double fps)
+{
+    if (!(fps > 0.0))
+    {
+        return {1, kTimeScale};
+    }
+    if (std::abs(fps - std::round(fps)) < 1e-6)
+    {
+        return {1, static_cast<A_u_long>(std::lround(fps))};
+    }
+    const double ntsc = fps * 1.001;
+    if (std::abs(ntsc - std::round(ntsc)) < 1e-3)
+    {
+        return {1001, static_cast<A_u_long>(std::lround(ntsc)) * 1000};
+    }
+    return {static_cast<A_long>(std::max(1L, std::lround(kTimeScale / fps))), kTimeScale};
+}
+
+// File name for a thumbnail: everything that changes its pixels, except the item's contents.
+std::string address(const std::string &projectPath, A_long itemID, const A_Time &time,
+                    const ae::ThumbnailRequest &request)
+{
+    Fnv fnv;
+    fnv.add(projectPath.data(), projectPath.size());
+    fnv.add(itemID);
+    fnv.add(time.value);
+    fnv.add(time.scale);
+    fnv.add(request.width);
+    fnv.add(request.height);
+    fnv.add(static_cast<int>(request.fit));
+    fnv.add(static_cast<int>(request.filter));
+    fnv.add(kVersion);
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(fnv.hash));
+    return std::string(name) + kExtension;
+}
+
+int64_t writeTime(const std::string &utf8Path)
+{
+    if (utf8Path.empty())
+    {
+        return 0;
+    }
+    std::error_code ec;
+    const auto time = fs::last_write_time(fs::u8path(utf8Path), ec);
+    return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+bool readHeader(std::ifstream &in, FileHeader &header)
+{
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)))
+    {
+        return false;
+    }
+    return std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion;
+}
+
+bool readThumbnail(const fs::path &file, ae::Thumbnail &thumb)
+{
+    std::ifstream in(file, std::ios::binary);
+    FileHeader header;
+    if (!in || !readHeader(in, header) || header.width != static_cast<uint32_t>(thumb.width) ||
+        header.height != static_cast<uint32_t>(thumb.height))
+    {
+        return false;
+    }
+    thumb.pixels.resize(static_cast<size_t>(thumb.width) * thumb.height * 4);
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(thumb.pixels.data()), thumb.pixels.size()));
+}
+
+// Written to a private file and renamed over, so readers never see half a thumbnail. Failures only cost a re-render.
+void writeThumbnail(const fs::path &file, const FileHeader &header, const ae::Thumbnail &thumb)
+{
+    std::error_code ec;
+    fs::path temp = file;
+    temp += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(thumb.pixels.data()), thumb.pixels.size());
+        if (!out)
+        {
+            out.close();
+            fs::remove(temp, ec);
+            return;
+        }
+    }
+    fs::rename(temp, file, ec);
+    if (ec)
+    {
+        fs::remove(temp, ec);
+    }
+}
+
+// What to render for a request: output size, downsample, and the crop in full resolution item pixels.
+struct Plan
+{
+    int width = 0;
+    int height = 0;
+    A_short downsample = 1;
+    A_LRect roi{0, 0, 0, 0};
+};
+
+Plan plan(int itemWidth, int itemHeight, const ae::ThumbnailRequest &request)
+{
+    const double sx = static_cast<double>(request.width) / itemWidth;
+    const double sy = static_cast<double>(request.height) / itemHeight;
+    Plan p;
+    double scale;
+    if (request.fit == ae::ThumbnailFit::Fit)
+    {
+        scale = std::min(sx, sy);
+        p.width = std::clamp(static_cast<int>(std::lround(itemWidth * scale)), 1, request.width);
+        p.height = std::clamp(static_cast<int>(std::lround(itemHeight * scale)), 1, request.height);
+        p.roi = {0, 0, itemWidth, itemHeight};
+    }
+    else
+    {
+        scale = std::max(sx, sy);
+        p.width = request.width;
+        p.height = request.height;
+        const int cropWidth = std::clamp(static_cast<int>(std::lround(request.width / scale)), 1, itemWidth);
+        const int cropHeight = std::clamp(static_cast<int>(std::lround(request.height / scale)), 1, itemHeight);
+        const int left = (itemWidth - cropWidth) / 2;
+        const int top = (itemHeight - cropHeight) / 2;
+        p.roi = {left, top, left + cropWidth, top + cropHeight};
+    }
+    // The largest factor that still renders at least the output size; the resample does the rest.
+    if (scale < 1.0)
+    {
+        p.downsample = static_cast<A_short>(std::clamp(static_cast<int>(std::floor(1.0 / scale)), 1, kMaxDownsample));
+    }
+    return p;
+}
+
+// The render of one miss, as RGBA8.
+struct Source
+{
+    int width = 0;
+    int height = 0;
+    tk::vector<A_u_char> pixels;
+    AEGP_TimeStamp stamp;
+    bool clean = false; // The project was saved when rendering started
+};
+
+// Renders the planned region of item at time and converts it to RGBA. Main thread only.
+Source renderSource(AEGP_SuiteHandler &suites, AEGP_PluginID pluginID, AEGP_ProjectH projectH, AEGP_ItemH item,
+                    const A_Time &time, int itemWidth, int itemHeight, const Plan &p)
+{
+    Source source;
+    A_Boolean dirty = TRUE;
+    AE_CHECK(suites.ProjSuite6()->AEGP_ProjectIsDirty(projectH, &dirty));
+    source.clean = !dirty;
+
+    AEGP_RenderOptionsH options = nullptr;
+    AE_CHECK(suites.RenderOptionsSuite3()->AEGP_NewFromItem(pluginID, item, &options));
+    AEGP_FrameReceiptH receiptH = nullptr;
+    try
+    {
+        AE_CHECK(suites.RenderOptionsSuite3()->AEGP_SetTime(options, time));
+        AE_CHECK(suites.RenderOptionsSuite3()->AEGP_SetWorldType(options, AEGP_WorldType_8));
+        AE_CHECK(suites.RenderOptionsSuite3()->AEGP_SetDownsampleFactor(options, p.downsample, p.downsample));
+        AE_CHECK(suites.RenderOptionsSuite3()->AEGP_SetRegionOfInterest(options, &p.roi));
+        AE_CHECK(suites.RenderSuite5()->AEGP_GetCurrentTimestamp(&source.stamp));
+        AE_CHECK(suites.RenderSuite5()->AEGP_RenderAndCheckoutFrame(options, NULL, NULL, &receiptH));
+
+        AEGP_WorldH world = nullptr;
+        A_long worldWidth = 0, worldHeight = 0;
+        A_u_long worldRowBytes = 0;
+        A_LRect rendered{0, 0, 0, 0};
+        PF_Pixel8 *base = nullptr;
+        AE_CHECK(suites.RenderSuite5()->AEGP_GetReceiptWorld(receiptH, &world));
+        CheckNotNull(world, "Error Rendering Thumbnail. Receipt has no World");
+        AE_CHECK(suites.WorldSuite3()->AEGP_GetSize(world, &worldWidth, &worldHeight));
+        AE_CHECK(suites.WorldSuite3()->AEGP_GetRowBytes(world, &worldRowBytes));
+        AE_CHECK(suites.WorldSuite3()->AEGP_GetBaseAddr8(world, &base));
+        AE_CHECK(suites.RenderSuite5()->AEGP_GetRenderedRegion(receiptH, &rendered));
+        CheckNotNull(base, "Error Rendering Thumbnail. World has no Pixels");
+
+        // A frame-sized world holds the ROI in place; a smaller one starts at the rendered region.
+        const int d = p.downsample;
+        int originX = 0, originY = 0;
+        if (worldWidth < (itemWidth + d - 1) / d || worldHeight < (itemHeight + d - 1) / d)
+        {
+            originX = rendered.left / d;
+            originY = rendered.top / d;
+        }
+        const int x0 = p.roi.left / d, y0 = p.roi.top / d;
+        source.width = std::max(1, static_cast<int>(p.roi.right - p.roi.left) / d);
+        source.height = std::max(1, static_cast<int>(p.roi.bottom - p.roi.top) / d);
+        source.pixels.assign(static_cast<size_t>(source.width) * source.height * 4, 0);
+        for (int row = 0; row < source.height; ++row)
+        {
+            const int srcY = y0 + row - originY;
+            if (srcY < 0 || srcY >= worldHeight)
+            {
+                continue;
+            }
+            const auto *in = reinterpret_cast<const PF_Pixel8 *>(reinterpret_cast<const char *>(base) +
+                                                                 srcY * static_cast<size_t>(worldRowBytes));
+            A_u_char *out = source.pixels.data() + static_cast<size_t>(row) * source.width * 4;
+            for (int col = 0; col < source.width; ++col)
+            {
+                const int srcX = x0 + col - originX;
+                if (srcX < 0 || srcX >= worldWidth)
+                {
+                    continue;
+                }
+                const PF_Pixel8 &px = in[srcX];
+                out[col * 4 + 0] = px.red;
+                out[col * 4 + 1] = px.green;
+                out[col * 4 + 2] = px.blue;
+                out[col * 4 + 3] = px.alpha;
+            }
+        }
+    }
+    catch (...)
+    {
+        if (receiptH)
+        {
+            suites.RenderSuite5()->AEGP_CheckinFrame(receiptH);
+        }
+        suites.RenderOptionsSuite3()->AEGP_Dispose(options);
+        throw;
+    }
+    suites.RenderSuite5()->AEGP_CheckinFrame(receiptH);
+    suites.RenderOptionsSuite3()->AEGP_Dispose(options);
+    return source;
+}
+
+// Source pixels and weights for each output pixel along one axis, count taps each, padded to stride.
+struct Taps
+{
+    int stride = 0;
+    tk::vector<int> count;
+    tk::vector<int> index;
+    tk::vector<float> weight;
+};
+
+double lanczos3(double t)
+{
+    t = std::abs(t);
+    if (t < 1e-8)
+    {
+        return 1.0;
+    }
+    if (t >= 3.0)
+    {
+        return 0.0;
+    }
+    const double pt = 3.14159265358979323846 * t;
+    return 3.0 * std::sin(pt) * std::sin(pt / 3.0) / (pt * pt);
+}
+
+Taps taps(int src, int dst, ae::ThumbnailFilter filter)
+{
+    const double scale = static_cast<double>(src) / dst;
+    const double filterScale = std::max(scale, 1.0); // Widen the kernel when shrinking
+    const double radius = (filter == ae::ThumbnailFilter::Box ? 0.5 : 3.0) * filterScale;
+
+    Taps t;
+    t.stride = static_cast<int>(std::ceil(radius * 2.0)) + 2;
+    t.count.assign(dst, 0);
+    t.index.assign(static_cast<size_t>(dst) * t.stride, 0);
+    t.weight.assign(static_cast<size_t>(dst) * t.stride, 0.0f);
+    for (int i = 0; i < dst; ++i)
+    {
+        const double center = (i + 0.5) * scale; // Source pixel j covers [j, j + 1)
+        const int first = static_cast<int>(std::floor(center - radius));
+        const int last = std::min(static_cast<int>(std::ceil(center + radius)), first + t.stride);
+        double sum = 0.0;
+        int n = 0;
+        for (int j = first; j < last; ++j)
+        {
+            double w;
+            if (filter == ae::ThumbnailFilter::Box)
+            {
+                w = std::min(j + 1.0, center + radius) - std::max(static_cast<double>(j), center - radius);
+            }
+            else
+            {
+                w = lanczos3((j + 0.5 - center) / filterScale);
+            }
+            if (w == 0.0 || (filter == ae::ThumbnailFilter::Box && w < 0.0))
+            {
+                continue;
+            }
+            t.index[static_cast<size_t>(i) * t.stride + n] = std::clamp(j, 0, src - 1); // Edges repeat
+            t.weight[static_cast<size_t>(i) * t.stride + n] = static_cast<float>(w);
+            sum += w;
+            ++n;
+        }
+        if (n == 0) // Only when upscaling past the kernel; take the nearest pixel
+        {
+            t.index[static_cast<size_t>(i) * t.stride] = std::clamp(static_cast<int>(center), 0, src - 1);
+            t.weight[static_cast<size_t>(i) * t.stride] = 1.0f;
+            n = 1;
+            sum = 1.0;
+        }
+        for (int k = 0; k < n; ++k)
+        {
+            t.weight[static_cast<size_t>(i) * t.stride + k] /= static_cast<float>(sum);
+        }
+        t.count[i] = n;
+    }
+    return t;
+}
+
+} // namespace
+
+namespace ae
+{
+
+struct ThumbnailService::State
+{
+    fs::path directory;
+    std::string directoryUtf8;
+    unsigned int threads = 1;
+    size_t chunkSize = 64;
+    uint64_t session = 0;
+    AEGP_TimeStamp baseline;     // When the service was created
+    bool baselineClean = false;  // The project was saved then, so earlier sessions' files can still apply
+    std::atomic<uint64_t> generation{0}; // Bumped by cancel()
+
+    mutable std::mutex mutex;
+    ThumbnailStats stats;
+
+    std::chrono::milliseconds renderInterval{0};
+    std::mutex renderMutex;
+    std::chrono::steady_clock::time_point nextRender; // Earliest start of the next render, across batches
+
+    void count(size_t ThumbnailStats::*field)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++(stats.*field);
+    }
+
+    // Resamples a render to the planned size and writes it to the cache. Worker threads.
+    Thumbnail finish(const Source &source, const Plan &p, ThumbnailFilter filter, const fs::path &file,
+                     int64_t projectTime) const
+    {
+        Thumbnail thumb = ThumbnailService::resample(source.pixels.data(), source.width, source.height,
+                                                     static_cast<size_t>(source.width) * 4, p.width, p.height, filter);
+        const FileHeader header{{kMagic[0], kMagic[1], kMagic[2], kMagic[3]},
+                                kVersion,
+                                static_cast<uint32_t>(p.width),
+                                static_cast<uint32_t>(p.height),
+                                session,
+                                source.clean ? projectTime : 0,
+                                source.stamp,
+                                0};
+        writeThumbnail(file, header, thumb);
+        return thumb;
+    }
+
+    // Renders item in a main-thread task, at least renderInterval after the last render ended. The wait is spent on
+    // the calling thread, so AE's idle passes in between run no thumbnail work. Worker and caller threads.
+    Source render(AEGP_ProjectH project, ItemPtr item, const A_Time &time, int itemWidth, int itemHeight,
+                  const Plan &p)
+    {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point start;
+        {
+            std::lock_guard<std::mutex> lock(renderMutex);
+            start = std::max(Clock::now(), nextRender);
+            nextRender = start + renderInterval; // Reserved, so concurrent callers queue up behind each other
+        }
+        std::this_thread::sleep_until(start);
+
+        auto task = ae::ScheduleOrExecute([project, item, time, itemWidth, itemHeight, p]() {
+            return renderSource(SuiteManager::GetInstance().GetSuiteHandler(),
+                                *SuiteManager::GetInstance().GetPluginID(), project, *item, time, itemWidth, itemHeight,
+                                p);
+        });
+        auto ended = [this]() {
+            std::lock_guard<std::mutex> lock(renderMutex);
+            nextRender = std::max(nextRender, Clock::now() + renderInterval);
+        };
+        try
+        {
+            Source source = task.get();
+            ended();
+            return source;
+        }
+        catch (...)
+        {
+            ended();
+            throw;
+        }
+    }
+
+    void run(const tk::vector<ItemPtr> &items, const ThumbnailRequest &request,
+             const std::function<void(size_t, const Thumbnail &)> &onReady, uint64_t batch);
+};
+
+namespace
+{
+
+// One item of a chunk, as the describe task, the header read and the check task found it.
+struct Candidate
+{
+    size_t index = 0;
+    ItemPtr item;
+    bool renderable = false;
+    bool hit = false;
+    int itemWidth = 0;
+    int itemHeight = 0;
+    A_long id = 0;
+    A_Time time{0, 1}; // The request time, snapped to the item's frame grid
+    A_Time step{1, kTimeScale};
+    fs::path file;
+    bool check = false;    // Has a usable cache file, current if the item is unchanged since `since`
+    AEGP_TimeStamp since{};
+};
+
+struct Chunk
+{
+    AEGP_ProjectH project = nullptr;
+    std::string projectPath;
+    int64_t projectTime = 0;
+    tk::vector<Candidate> candidates;
+};
+
+} // namespace
+
+void ThumbnailService::State::run(const tk::vector<ItemPtr> &items, const ThumbnailRequest &request,
+                                  const std::function<void(size_t, const Thumbnail &)> &onReady, uint64_t batch)
+{
+    if (request.width <= 0 || request.height <= 0)
+    {
+        throw AEException("Error Making Thumbnails. Size must be Positive");
+    }
+    // Resampling, file I/O and onReady run here while the main thread renders the next miss.
+    std::deque<std::future<void>> running;
+    auto launch = [&](std::function<void()> job) {
+        if (running.size() >= threads)
+        {
+            running.front().get();
+            running.pop_front();
+        }
+        running.push_back(std::async(std::launch::async, std::move(job)));
+    };
+    auto canceled = [&]() { return generation.load() != batch; };
+
+    for (size_t start = 0; start < items.size() && !canceled(); start += chunkSize)
+    {
+        const size_t end = std::min(items.size(), start + chunkSize);
+
+        // One task reads the IDs, sizes and frame grids of the whole chunk.
+        auto describe = ae::ScheduleOrExecute([&items, &request, start, end]() {
+            auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+            Chunk chunk;
+            AE_CHECK(suites.ProjSuite6()->AEGP_GetProjectByIndex(0, &chunk.project));
+            AEGP_MemHandle pathH = nullptr;
+            AE_CHECK(suites.ProjSuite6()->AEGP_GetProjectPath(chunk.project, &pathH));
+            chunk.projectPath = memHandleToString(pathH);
+
+            for (size_t i = start; i < end; ++i)
+            {
+                Candidate c;
+                c.index = i;
+                c.item = items[i];
+                try
+                {
+                    CheckNotNull(c.item.get(), "Error Making Thumbnail. Item is Null");
+                    AEGP_ItemType type = AEGP_ItemType_NONE;
+                    A_long width = 0, height = 0;
+                    AE_CHECK(suites.ItemSuite9()->AEGP_GetItemType(*c.item, &type));
+                    AE_CHECK(suites.ItemSuite9()->AEGP_GetItemID(*c.item, &c.id));
+                    AE_CHECK(suites.ItemSuite9()->AEGP_GetItemDimensions(*c.item, &width, &height));
+                    c.itemWidth = static_cast<int>(width);
+                    c.itemHeight = static_cast<int>(height);
+                    c.renderable = type != AEGP_ItemType_FOLDER && width > 0 && height > 0;
+                    if (!c.renderable)
+                    {
+                        chunk.candidates.push_back(std::move(c));
+                        continue;
+                    }
+
+                    // Snap to the item's own frames, so 23.976 and 29.97 times land exactly on a frame and the
+                    // times of one frame share a file.
+                    if (type == AEGP_ItemType_COMP)
+                    {
+                        AEGP_CompH comp = nullptr;
+                        AE_CHECK(suites.CompSuite11()->AEGP_GetCompFromItem(*c.item, &comp));
+                        AE_CHECK(suites.CompSuite11()->AEGP_GetCompFrameDuration(comp, &c.step));
+                        if (c.step.value <= 0 || c.step.scale == 0)
+                        {
+                            c.step = {1, kTimeScale};
+                        }
+                    }
+                    else
+                    {
+                        // Solids and placeholders may have no interpretation; they keep the fallback grid.
+                        AEGP_FootageInterp interp{};
+                        if (suites.FootageSuite5()->AEGP_GetFootageInterpretation(*c.item, FALSE, &interp) ==
+                            A_Err_NONE)
+                        {
+                            c.step = frameDuration(interp.conform_fpsF);
+                        }
+                    }
+                    c.time = TimeContext(c.step).toTime(request.time);
+                }
+                catch (const AEException &)
+                {
+                    c.renderable = false;
+                }
+                chunk.candidates.push_back(std::move(c));
+            }
+            return chunk;
+        });
+        Chunk chunk = describe.get();
+
+        // Cache headers are read here, off the main thread.
+        chunk.projectTime = writeTime(chunk.projectPath);
+        bool anyCheck = false;
+        for (auto &c : chunk.candidates)
+        {
+            if (!c.renderable)
+            {
+                continue;
+            }
+            c.file = directory / address(chunk.projectPath, c.id, c.time, request);
+            std::ifstream in(c.file, std::ios::binary);
+            FileHeader header;
+            const Plan p = plan(c.itemWidth, c.itemHeight, request);
+            if (!in || !readHeader(in, header) || header.width != static_cast<uint32_t>(p.width) ||
+                header.height != static_cast<uint32_t>(p.height))
+            {
+                continue;
+            }
+            // Earlier sessions' stamps mean nothing now; their files need a saved, unchanged project.
+            if (header.session == session)
+            {
+                c.since = header.stamp;
+                c.check = true;
+            }
+            else if (header.projectTime != 0 && header.projectTime == chunk.projectTime && baselineClean)
+            {
+                c.since = baseline;
+                c.check = true;
+            }
+            anyCheck = anyCheck || c.check;
+        }
+
+        // One more task asks AE which of the cached items changed; a cold chunk skips it.
+        if (anyCheck)
+        {
+            auto check = ae::ScheduleOrExecute([&chunk]() {
+                auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+                for (auto &c : chunk.candidates)
+                {
+                    if (!c.check)
+                    {
+                        continue;
+                    }
+                    A_Boolean changed = TRUE;
+                    if (suites.RenderSuite5()->AEGP_HasItemChangedSinceTimestamp(*c.item, &c.time, &c.step, &c.since,
+                                                                                 &changed) == A_Err_NONE)
+                    {
+                        c.hit = !changed;
+                    }
+                }
+            });
+            check.get();
+        }
+
+        for (auto &c : chunk.candidates)
+        {
+            if (canceled())
+            {
+                break;
+            }
+            if (!c.renderable)
+            {
+                count(&ThumbnailStats::failures);
+                launch([&onReady, index = c.index]() { onReady(index, Thumbnail{}); });
+                continue;
+            }
+            const Plan p = plan(c.itemWidth, c.itemHeight, request);
+            if (c.hit)
+            {
+                launch([this, &onReady, hit = c, p, &request, project = chunk.project,
+                        projectTime = chunk.projectTime]() {
+                    Thumbnail thumb;
+                    thumb.width = p.width;
+                    thumb.height = p.height;
+                    thumb.cached = true;
+                    if (readThumbnail(hit.file, thumb))
+                    {
+                        count(&ThumbnailStats::hits);
+                        onReady(hit.index, thumb);
+                        return;
+                    }
+                    // Removed or replaced by a torn write since validation: render after all.
+                    Source source;
+                    try
+                    {
+                        source = render(project, hit.item, hit.time, hit.itemWidth, hit.itemHeight, p);
+                    }
+                    catch (const AEException &)
+                    {
+                        count(&ThumbnailStats::failures);
+                        onReady(hit.index, Thumbnail{});
+                        return;
+                    }
+                    count(&ThumbnailStats::misses);
+                    onReady(hit.index, finish(source, p, request.filter, hit.file, projectTime));
+                });
+                continue;
+            }
+
+            // One task per render, so other idle work gets a turn between misses.
+            Source source;
+            try
+            {
+                source = render(chunk.project, c.item, c.time, c.itemWidth, c.itemHeight, p);
+            }
+            catch (const AEException &)
+            {
+                count(&ThumbnailStats::failures);
+                launch([&onReady, index = c.index]() { onReady(index, Thumbnail{}); });
+                continue;
+            }
+            count(&ThumbnailStats::misses);
+            launch([this, &onReady, &request, index = c.index, file = c.file, p, source = std::move(source),
+                    projectTime = chunk.projectTime]() {
+                onReady(index, finish(source, p, request.filter, file, projectTime));
+            });
+        }
+    }
+
+    while (!running.empty())
+    {
+        running.front().get();
+        running.pop_front();
+    }
+}
+
+ThumbnailService::ThumbnailService(const ThumbnailServiceOptions &options) : m_state(std::make_shared<State>())
+{
+    std::error_code ec;
+    m_state->directory = options.cacheDirectory.empty() ? fs::temp_directory_path(ec) / "AETK Thumbnails"
+                                                        : fs::u8path(options.cacheDirectory);
+    fs::create_directories(m_state->directory, ec);
+    if (ec)
+    {
+        throw AEException("Error Creating Thumbnail Cache Directory: " + ec.message());
+    }
+    m_state->directoryUtf8 = m_state->directory.u8string();
+    const unsigned int threads = options.maxThreads ? options.maxThreads : std::thread::hardware_concurrency();
+    m_state->threads = std::max(1u, threads);
+    m_state->chunkSize = std::max<size_t>(options.chunkSize, 1);
+    m_state->renderInterval = std::max(options.renderInterval, std::chrono::milliseconds(0));
+    m_state->session = sessionToken();
+
+    auto future = ae::ScheduleOrExecute([]() {
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        AEGP_ProjectH projectH = nullptr;
+        AEGP_TimeStamp stamp;
+        A_Boolean dirty = TRUE;
+        AE_CHECK(suites.RenderSuite5()->AEGP_GetCurrentTimestamp(&stamp));
+        AE_CHECK(suites.ProjSuite6()->AEGP_GetProjectByIndex(0, &projectH));
+        AE_CHECK(suites.ProjSuite6()->AEGP_ProjectIsDirty(projectH, &dirty));
+        return std::make_pair(stamp, !dirty);
+    });
+    std::tie(m_state->baseline, m_state->baselineClean) = future.get();
+}
+
+ThumbnailService::~ThumbnailService()
+{
+    cancel();
+}
+
+Thumbnail ThumbnailService::get(ItemPtr item, const ThumbnailRequest &request)
+{
+    Thumbnail result;
+    m_state->run({item}, request, [&result](size_t, const Thumbnail &thumb) { result = thumb; },
+                 m_state->generation.load());
+    return result;
+}
+
+std::future<void> ThumbnailService::generate(tk::vector<ItemPtr> items, const ThumbnailRequest &request,
+                                             std::function<void(size_t, const Thumbnail &)> onReady)
+{
+    return std::async(std::launch::async, [state = m_state, items = std::move(items), request,
+                                           onReady = std::move(onReady), batch = m_state->generation.load()]() {
+        state->run(items, request, onReady, batch);
+    });
+}
+
+void ThumbnailService::cancel()
+{
+    ++m_state->generation;
+}
+
+void ThumbnailService::purge()
+{
+    std::error_code ec;
+    for (fs::directory_iterator it(m_state->directory, ec), end; !ec && it != end; it.increment(ec))
+    {
+        const std::string name = it->path().filename().u8string();
+        if (name.find(kExtension) != std::string::npos)
+        {
+            std::error_code removeError;
+            fs::remove(it->path(), removeError);
+        }
+    }
+}
+
+const std::string &ThumbnailService::cacheDirectory() const
+{
+    return m_state->directoryUtf8;
+}
+
+ThumbnailStats ThumbnailService::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->stats;
+}
+
+Thumbnail ThumbnailService::resample(const A_u_char *pixels, int srcWidth, int srcHeight, size_t rowBytes, int width,
+                                     int height, ThumbnailFilter filter)
+{
+    Thumbnail thumb;
+    if (!pixels || srcWidth <= 0 || srcHeight <= 0 || width <= 0 || height <= 0)
+    {
+        return thumb;
+    }
+    thumb.width = width;
+    thumb.height = height;
+    thumb.pixels.resize(static_cast<size_t>(width) * height * 4);
+
+    const Taps horizontal = taps(srcWidth, width, filter);
+    const Taps vertical = taps(srcHeight, height, filter);
+    const size_t lineFloats = static_cast<size_t>(width) * 4;
+
+    // Rows first, into floats; the four channels of a pixel are one short loop the compiler vectorizes.
+    tk::vector<float> rows(lineFloats * srcHeight);
+    for (int y = 0; y < srcHeight; ++y)
+    {
+        const A_u_char *in = pixels + y * rowBytes;
+        float *out = rows.data() + y * lineFloats;
+        for (int x = 0; x < width; ++x)
+        {
+            const int *index = horizontal.index.data() + static_cast<size_t>(x) * horizontal.stride;
+            const float *weight = horizontal.weight.data() + static_cast<size_t>(x) * horizontal.stride;
+            float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (int k = 0; k < horizontal.count[x]; ++k)
+            {
+                const A_u_char *px = in + index[k] * 4;
+                for (int c = 0; c < 4; ++c)
+                {
+                    acc[c] += weight[k] * px[c];
+                }
+            }
+            for (int c = 0; c < 4; ++c)
+            {
+                out[x * 4 + c] = acc[c];
+            }
+        }
+    }
+
+    // Then columns: whole rows of floats scaled and summed, contiguous and branch free.
+    tk::vector<float> line(lineFloats);
+    for (int y = 0; y < height; ++y)
+    {
+        const int *index = vertical.index.data() + static_cast<size_t>(y) * vertical.stride;
+        const float *weight = vertical.weight.data() + static_cast<size_t>(y) * vertical.stride;
+        std::fill(line.begin(), line.end(), 0.0f);
+        for (int k = 0; k < vertical.count[y]; ++k)
+        {
+            const float *in = rows.data() + static_cast<size_t>(index[k]) * lineFloats;
+            const float w = weight[k];
+            for (size_t i = 0; i < lineFloats; ++i)
+            {
+                line[i] += w * in[i];
+            }
+        }
+        A_u_char *out = thumb.pixels.data() + static_cast<size_t>(y) * lineFloats;
+        for (size_t i = 0; i < lineFloats; ++i)
+        {
+            out[i] = static_cast<A_u_char>(std::min(std::max(line[i], 0.0f), 255.0f) + 0.5f); // Lanczos overshoots
+        }
+    }
+    return thumb;
+}
+
+} // namespace ae
@@ -0,0 +1,328 @@
+#include "AETK/AEGP/Util/TiledRenderer.hpp"
+#include "AETK/AEGP/Util/WorldUtil.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <deque>
+
+namespace
+{
+
+struct TileBuffer
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    tk::vector<char> pixels; // Reused from tile to tile
+};
+
+// Shared by the caller, the tile workers and the main-thread tile tasks, which may outlive render() after an error.
+struct TileQueue
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<TileBuffer> ready; // Rendered, waiting for a worker
+    tk::vector<TileBuffer> spare; // Buffers to reuse
+    size_t pending = 0;           // Requested and not yet processed
+    size_t rendering = 0;         // Requested and not yet rendered
+    bool requested = false;       // Every tile has been requested
+    std::exception_ptr error;
+
+    void fail(std::exception_ptr e)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error)
+            {
+                error = e;
+            }
+        }
+        changed.notify_all();
+    }
+};
+
+struct TileGeometry
+{
+    A_short downsampleX;
+    A_short downsampleY;
+    int frameWidth;
+    int frameHeight;
+    AEGP_WorldType type;
+};
+
+// Renders the ROI of tile and copies it into tile.pixels. Main thread only.
+void renderTile(AEGP_SuiteHandler &suites, AEGP_RenderOptionsH options, const TileGeometry &geometry, TileBuffer &tile)
+{
+    // ROIs are in full resolution comp pixels; tiles are in output pixels.
+    const A_LRect roi{tile.x * geometry.downsampleX, tile.y * geometry.downsampleY,
+                      (tile.x + tile.width) * geometry.downsampleX, (tile.y + tile.height) * geometry.downsampleY};
+    AE_CHECK(suites.RenderOptionsSuite3()->AEGP_SetRegionOfInterest(options, &roi));
+
+    AEGP_FrameReceiptH receiptH = nullptr;
+    AE_CHECK(suites.RenderSuite5()->AEGP_RenderAndCheckoutFrame(options, NULL, NULL, &receiptH));
+    try
+    {
+        AEGP_WorldH world = nullptr;
+        A_long worldWidth = 0, worldHeight = 0;
+        A_u_long worldRowBytes = 0;
+        A_LRect rendered{0, 0, 0, 0};
+        AE_CHECK(suites.RenderSuite5()->AEGP_GetReceiptWorld(receiptH, &world));
+        CheckNotNull(world, "Error Rendering Tile. Receipt has no World");
+        AE_CHECK(suites.WorldSuite3()->AEGP_GetSize(world, &worldWidth, &worldHeight));
+        AE_CHECK(suites.WorldSuite3()->AEGP_GetRowBytes(world, &worldRowBytes));
+        AE_CHECK(suites.RenderSuite5()->AEGP_GetRenderedRegion(receiptH, &rendered));
+        const char *base = ae::baseAddr(suites, world, geometry.type);
+        CheckNotNull(base, "Error Rendering Tile. World has no Pixels");
+
+        // A frame-sized world holds the ROI in place; a smaller one starts at the rendered region.
+        int originX = 0, originY = 0;
+        if (worldWidth < geometry.frameWidth || worldHeight < geometry.frameHeight)
+        {
+            originX = rendered.left / geometry.downsampleX;
+            originY = rendered.top / geometry.downsampleY;
+        }
+
+        const size_t px = ae::pixelBytes(geometry.type);
+        const size_t tileRowBytes = static_cast<size_t>(tile.width) * px;
+        tile.pixels.assign(tileRowBytes * tile.height, 0);
+        const int srcX = tile.x - originX;
+        const int first = std::max(0, -srcX);
+        const int last = std::min(tile.width, static_cast<int>(worldWidth) - srcX);
+        for (int row = 0; row < tile.height && first < last; ++row)
+        {
+            const int srcY = tile.y + row - originY;
+            if (srcY < 0 || srcY >= worldHeight)
+            {
+                continue;
+            }
+            std::memcpy(tile.pixels.data() + row * tileRowBytes + first * px,
+                        base + srcY * static_cast<size_t>(worldRowBytes) + (srcX + first) * px, (last - first) * px);
+        }
+    }
+    catch (...)
+    {
+        suites.RenderSuite5()->AEGP_CheckinFrame(receiptH);
+        throw;
+    }
+    suites.RenderSuite5()->AEGP_CheckinFrame(receiptH);
+}
+
+} // namespace
+
+namespace ae
+{
+
+TiledRenderer::TiledRenderer(ItemPtr item, RenderOptionsPtr options, const TiledRenderOptions &tileOptions)
+    : m_item(item), m_options(options), m_tileOptions(tileOptions)
+{
+    CheckNotNull(item.get(), "Error Creating Tiled Renderer. Item is Null");
+    CheckNotNull(options.get(), "Error Creating Tiled Renderer. Options are Null");
+    auto future = ae::ScheduleOrExecute([item, options]() {
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        A_long width = 0, height = 0;
+        A_short dsx = 1, dsy = 1;
+        AEGP_WorldType type = AEGP_WorldType_NONE;
+        AE_CHECK(suites.ItemSuite9()->AEGP_GetItemDimensions(*item, &width, &height));
+        AE_CHECK(suites.RenderOptionsSuite3()->AEGP_GetDownsampleFactor(*options, &dsx, &dsy));
+        AE_CHECK(suites.RenderOptionsSuite3()->AEGP_GetWorldType(*options, &type));
+        return std::make_tuple(width, height, dsx, dsy, type);
+    });
+    A_long width, height;
+    std::tie(width, height, m_downsampleX, m_downsampleY, m_type) = future.get();
+    m_downsampleX = std::max<A_short>(m_downsampleX, 1);
+    m_downsampleY = std::max<A_short>(m_downsampleY, 1);
+    m_width = static_cast<int>((width + m_downsampleX - 1) / m_downsampleX);
+    m_height = static_cast<int>((height + m_downsampleY - 1) / m_downsampleY);
+    m_tileSize = m_tileOptions.tileSize > 0 ? m_tileOptions.tileSize
+                                            : suggestTileSize(m_type, m_tileOptions.cacheBytes);
+}
+
+size_t TiledRenderer::pixelBytes() const
+{
+    return ae::pixelBytes(m_type);
+}
+
+int TiledRenderer::suggestTileSize(AEGP_WorldType type, size_t cacheBytes)
+{
+    const size_t px = std::max<size_t>(ae::pixelBytes(type), 1);
+    int side = static_cast<int>(std::sqrt(static_cast<double>(cacheBytes / px)));
+    return std::max(64, side / 64 * 64);
+}
+
+void TiledRenderer::render(const std::function<void(const RenderTile &)> &onTile)
+{
+    render(nullptr, 0, onTile);
+}
+
+void TiledRenderer::render(void *dst, size_t rowBytes, const std::function<void(const RenderTile &)> &onTile)
+{
+    if (m_width <= 0 || m_height <= 0)
+    {
+        return;
+    }
+    const size_t px = pixelBytes();
+    if (px == 0)
+    {
+        throw AEException("Error Rendering Tiles. Unknown World Type");
+    }
+
+    // A private copy, so the caller's ROI is left alone.
+    auto duplicate = ae::ScheduleOrExecute([options = m_options]() {
+        AEGP_RenderOptionsH copy = nullptr;
+        AE_CHECK(SuiteManager::GetInstance().GetSuiteHandler().RenderOptionsSuite3()->AEGP_Duplicate(
+            *SuiteManager::GetInstance().GetPluginID(), *options, &copy));
+        return makeRenderOptionsPtr(copy);
+    });
+    RenderOptionsPtr tileOptions = duplicate.get();
+
+    const TileGeometry geometry{m_downsampleX, m_downsampleY, m_width, m_height, m_type};
+    const int tile = std::max(m_tileSize, 1);
+    const int tilesX = (m_width + tile - 1) / tile;
+    const int tilesY = (m_height + tile - 1) / tile;
+
+    unsigned int threads = m_tileOptions.maxThreads ? m_tileOptions.maxThreads : std::thread::hardware_concurrency();
+    threads = std::max(1u, std::min<unsigned int>(threads, static_cast<unsigned int>(tilesX * tilesY)));
+    const size_t maxPending = m_tileOptions.maxPendingTiles ? m_tileOptions.maxPendingTiles : size_t(threads) * 2;
+
+    auto queue = std::make_shared<TileQueue>();
+
+    auto worker = [&, queue]() {
+        for (;;)
+        {
+            TileBuffer buffer;
+            {
+                std::unique_lock<std::mutex> lock(queue->mutex);
+                queue->changed.wait(lock, [&]() {
+                    return queue->error || !queue->ready.empty() || (queue->requested && queue->rendering == 0);
+                });
+                if (queue->error || queue->ready.empty())
+                {
+                    return;
+                }
+                buffer = std::move(queue->ready.front());
+                queue->ready.pop_front();
+            }
+
+            try
+            {
+                const size_t tileRowBytes = static_cast<size_t>(buffer.width) * px;
+                if (dst)
+                {
+                    char *out = static_cast<char *>(dst) + buffer.y * rowBytes + buffer.x * px;
+                    for (int row = 0; row < buffer.height; ++row)
+                    {
+                        std::memcpy(out + row * rowBytes, buffer.pixels.data() + row * tileRowBytes, tileRowBytes);
+                    }
+                }
+                if (onTile)
+                {
+                    RenderTile view;
+                    view.x = buffer.x;
+                    view.y = buffer.y;
+                    view.width = buffer.width;
+                    view.height = buffer.height;
+                    view.type = m_type;
+                    view.pixels = buffer.pixels.data();
+                    view.rowBytes = tileRowBytes;
+                    onTile(view);
+                }
+            }
+            catch (...)
+            {
+                queue->fail(std::current_exception());
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                queue->spare.push_back(std::move(buffer));
+                --queue->pending;
+            }
+            queue->changed.notify_all();
+        }
+    };
+
+    tk::vector<std::future<void>> workers;
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        workers.push_back(std::async(std::launch::async, worker));
+    }
+
+    // Request tiles in row order, never more than maxPending ahead of the workers.
+    for (int index = 0; index < tilesX * tilesY; ++index)
+    {
+        TileBuffer buffer;
+        {
+            std::unique_lock<std::mutex> lock(queue->mutex);
+            queue->changed.wait(lock, [&]() { return queue->error || queue->pending < maxPending; });
+            if (queue->error)
+            {
+                break;
+            }
+            ++queue->pending;
+            ++queue->rendering;
+            if (!queue->spare.empty())
+            {
+                buffer = std::move(queue->spare.back());
+                queue->spare.pop_back();
+            }
+        }
+        buffer.x = (index % tilesX) * tile;
+        buffer.y = (index / tilesX) * tile;
+        buffer.width = std::min(tile, m_width - buffer.x);
+        buffer.height = std::min(tile, m_height - buffer.y);
+
+        // Not waited on: the tile reaches the workers through the queue.
+        ae::ScheduleOrExecute([queue, tileOptions, geometry, buffer = std::move(buffer)]() mutable {
+            bool skip = false;
+            {
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                skip = static_cast<bool>(queue->error);
+            }
+            try
+            {
+                if (!skip)
+                {
+                    renderTile(SuiteManager::GetInstance().GetSuiteHandler(), *tileOptions, geometry, buffer);
+                }
+            }
+            catch (...)
+            {
+                queue->fail(std::current_exception());
+                skip = true;
+            }
+            {
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                --queue->rendering;
+                if (!skip)
+                {
+                    queue->ready.push_back(std::move(buffer));
+                }
+            }
+            queue->changed.notify_all();
+        });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->requested = true;
+    }
+    queue->changed.notify_all();
+    for (auto &w : workers)
+    {
+        w.get();
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        error = queue->error;
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace ae
@@ -0,0 +1,451 @@
+#include "AETK/AEGP/Util/TransformGraph.hpp"
+#include "AETK/AEGP/Util/Parallel.hpp"
+
+namespace
+{
+
+enum TransformStream
+{
+    Anchor,
+    Position,
+    Scale,
+    Orientation,
+    RotateX,
+    RotateY,
+    RotateZ,
+    NumTransformStreams
+};
+
+const AEGP_LayerStream kStreams[NumTransformStreams] = {
+    AEGP_LayerStream_ANCHORPOINT, AEGP_LayerStream_POSITION, AEGP_LayerStream_SCALE,   AEGP_LayerStream_ORIENTATION,
+    AEGP_LayerStream_ROTATE_X,    AEGP_LayerStream_ROTATE_Y, AEGP_LayerStream_ROTATE_Z};
+
+ae::Vec3 toVec3(const AEGP_StreamVal2 &value, AEGP_StreamType type)
+{
+    switch (StreamType(type))
+    {
+    case StreamType::ThreeD:
+    case StreamType::ThreeD_SPATIAL:
+        return {value.three_d.x, value.three_d.y, value.three_d.z};
+    case StreamType::TwoD:
+    case StreamType::TwoD_SPATIAL:
+        return {value.two_d.x, value.two_d.y, 0.0};
+    default:
+        return {value.one_d, 0.0, 0.0};
+    }
+}
+
+ae::Mat4 toMat4(const A_Matrix4 &matrix)
+{
+    ae::Mat4 r;
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            r.m[i * 4 + j] = matrix.mat[i][j];
+        }
+    }
+    return r;
+}
+
+// time moved by direction ticks of a scale of at least 10000, for position path tangents.
+A_Time nudge(const A_Time &time, int direction)
+{
+    const int64_t factor = std::max<int64_t>(1, 10000 / std::max<int64_t>(1, time.scale));
+    const int64_t value = static_cast<int64_t>(time.value) * factor + direction;
+    const int64_t scale = static_cast<int64_t>(time.scale) * factor;
+    if (value > INT32_MAX || value < INT32_MIN || scale > UINT32_MAX)
+    {
+        return {time.value + direction, time.scale};
+    }
+    return {static_cast<A_long>(value), static_cast<A_u_long>(scale)};
+}
+
+// Value of one transform stream at comp time, post-expression. Main thread only.
+ae::Vec3 readStream(AEGP_SuiteHandler &suites, AEGP_LayerH layerH, int k, const A_Time &time)
+{
+    AEGP_StreamVal2 value;
+    AEGP_StreamType type;
+    AE_CHECK(suites.StreamSuite6()->AEGP_GetLayerStreamValue(layerH, kStreams[k], AEGP_LTimeMode_CompTime, &time,
+                                                             FALSE, &value, &type));
+    return toVec3(value, type);
+}
+
+} // namespace
+
+void TransformGraph::evaluate(double start, double end)
+{
+    auto future = ae::ScheduleOrExecute([comp = m_comp]() {
+        CheckNotNull(comp.get(), "Error Evaluating Transforms. Comp is Null");
+        A_Time frameDuration;
+        AE_CHECK(SuiteManager::GetInstance().GetSuiteHandler().CompSuite11()->AEGP_GetCompFrameDuration(
+            *comp, &frameDuration));
+        return frameDuration;
+    });
+    A_Time frameDuration = future.get();
+
+    // Frame times are built on the comp's own time base, so no frame drifts.
+    const double framesPerSecond = double(frameDuration.scale) / double(frameDuration.value);
+    A_long first = static_cast<A_long>(std::ceil(start * framesPerSecond - 1e-6));
+    A_long last = static_cast<A_long>(std::floor(end * framesPerSecond + 1e-6));
+
+    tk::vector<A_Time> times;
+    times.reserve(last >= first ? last - first + 1 : 0);
+    for (A_long frame = first; frame <= last; ++frame)
+    {
+        times.push_back({frame * frameDuration.value, frameDuration.scale});
+    }
+    sample(times);
+    compose();
+}
+
+void TransformGraph::evaluate(const tk::vector<double> &times)
+{
+    auto future = ae::ScheduleOrExecute([comp = m_comp]() {
+        CheckNotNull(comp.get(), "Error Evaluating Transforms. Comp is Null");
+        A_Time frameDuration;
+        AE_CHECK(SuiteManager::GetInstance().GetSuiteHandler().CompSuite11()->AEGP_GetCompFrameDuration(
+            *comp, &frameDuration));
+        return frameDuration.scale;
+    });
+    A_u_long scale = future.get();
+
+    tk::vector<A_Time> aeTimes;
+    aeTimes.reserve(times.size());
+    for (double t : times)
+    {
+        aeTimes.push_back({static_cast<A_long>(std::llround(t * scale)), scale});
+    }
+    sample(aeTimes);
+    compose();
+}
+
+int TransformGraph::find(AEGP_LayerIDVal id) const
+{
+    auto it = std::find(m_layerIDs.begin(), m_layerIDs.end(), id);
+    return it == m_layerIDs.end() ? -1 : static_cast<int>(it - m_layerIDs.begin());
+}
+
+void TransformGraph::sample(const tk::vector<A_Time> &times)
+{
+    struct Structure
+    {
+        tk::vector<AEGP_LayerH> handles;
+        tk::vector<AEGP_LayerIDVal> ids;
+        tk::vector<AEGP_LayerIDVal> parentIDs;
+        tk::vector<ObjectType> types;
+        tk::vector<char> is3D;
+        tk::vector<char> lookAt;
+        tk::vector<char> autoOrient;
+        tk::vector<char> exact;
+        tk::vector<char> animated; // layers x NumTransformStreams; legal streams that can change
+        tk::vector<Sample> statics; // Values of the legal streams that cannot
+    };
+
+    const auto store = [](Sample &s, int k, const ae::Vec3 &v) {
+        switch (k)
+        {
+        case Anchor:
+            s.anchor = v;
+            break;
+        case Position:
+            s.position = v;
+            break;
+        case Scale:
+            s.scale = v;
+            break;
+        case Orientation:
+            s.orientation = v;
+            break;
+        case RotateX:
+            s.rotateX = v.x;
+            break;
+        case RotateY:
+            s.rotateY = v.x;
+            break;
+        case RotateZ:
+            s.rotateZ = v.x;
+            break;
+        }
+    };
+
+    // Hierarchy, flags, which streams change over time and the values of those that do not, once.
+    const A_Time first = times.empty() ? A_Time{0, 1} : times.front();
+    auto structureFuture = ae::ScheduleOrExecute([comp = m_comp, exactAll = m_options.exact, first, &store]() {
+        CheckNotNull(comp.get(), "Error Evaluating Transforms. Comp is Null");
+        auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+        const AEGP_PluginID pluginID = *SuiteManager::GetInstance().GetPluginID();
+        A_long numLayers = 0;
+        AE_CHECK(suites.LayerSuite9()->AEGP_GetCompNumLayers(*comp, &numLayers));
+
+        Structure s;
+        s.animated.resize(static_cast<size_t>(numLayers) * NumTransformStreams);
+        s.statics.resize(static_cast<size_t>(numLayers));
+        for (A_long i = 0; i < numLayers; ++i)
+        {
+            AEGP_LayerH layerH;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetCompLayerByIndex(*comp, i, &layerH));
+            AEGP_LayerIDVal id;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerID(layerH, &id));
+            AEGP_LayerH parentH = nullptr;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerParent(layerH, &parentH));
+            AEGP_LayerIDVal parentID = 0;
+            if (parentH)
+            {
+                AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerID(parentH, &parentID));
+            }
+            AEGP_ObjectType type;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerObjectType(layerH, &type));
+            AEGP_LayerFlags flags;
+            AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerFlags(layerH, &flags));
+
+            const bool cameraOrLight = type == AEGP_ObjectType_CAMERA || type == AEGP_ObjectType_LIGHT;
+            const bool threeD = cameraOrLight || (flags & AEGP_LayerFlag_LAYER_IS_3D);
+            const bool alongPath = (flags & AEGP_LayerFlag_AUTO_ORIENT_ROTATION) != 0;
+            // A 3D layer's orientation along its path, or towards whichever camera is active, is left to AE.
+            const bool exact =
+                exactAll || (threeD && !cameraOrLight && (alongPath || (flags & AEGP_LayerFlag_LOOK_AT_CAMERA)));
+            s.handles.push_back(layerH);
+            s.ids.push_back(id);
+            s.parentIDs.push_back(parentID);
+            s.types.push_back(ObjectType(type));
+            s.is3D.push_back(threeD);
+            s.lookAt.push_back(cameraOrLight && (flags & AEGP_LayerFlag_LOOK_AT_POI));
+            s.autoOrient.push_back(alongPath && !exact);
+            s.exact.push_back(exact);
+            if (exact)
+            {
+                continue;
+            }
+            for (int k = 0; k < NumTransformStreams; ++k)
+            {
+                A_Boolean legal = FALSE;
+                AE_CHECK(suites.StreamSuite6()->AEGP_IsStreamLegal(layerH, kStreams[k], &legal));
+                if (!legal)
+                {
+                    continue;
+                }
+                AEGP_StreamRefH streamH = nullptr;
+                AE_CHECK(suites.StreamSuite6()->AEGP_GetNewLayerStream(pluginID, layerH, kStreams[k], &streamH));
+                A_long numKeys = 0;
+                A_Boolean expression = FALSE;
+                A_Err err = suites.KeyframeSuite5()->AEGP_GetStreamNumKFs(streamH, &numKeys);
+                if (!err)
+                {
+                    err = suites.StreamSuite6()->AEGP_GetExpressionState(pluginID, streamH, &expression);
+                }
+                suites.StreamSuite6()->AEGP_DisposeStream(streamH);
+                AE_CHECK(err);
+                const bool animated = numKeys > 0 || expression;
+                s.animated[i * NumTransformStreams + k] = animated;
+                if (!animated)
+                {
+                    store(s.statics[i], k, readStream(suites, layerH, k, first));
+                }
+            }
+        }
+        return s;
+    });
+    Structure structure = structureFuture.get();
+
+    const size_t numLayers = structure.ids.size();
+    const size_t numFrames = times.size();
+    m_times.resize(numFrames);
+    for (size_t f = 0; f < numFrames; ++f)
+    {
+        m_times[f] = double(times[f].value) / double(times[f].scale);
+    }
+    m_layerIDs = structure.ids;
+    m_types = structure.types;
+    m_is3D = structure.is3D;
+    m_lookAt = structure.lookAt;
+    m_autoOrient = structure.autoOrient;
+    m_exact = structure.exact;
+    std::unordered_map<AEGP_LayerIDVal, int> rows;
+    for (size_t i = 0; i < numLayers; ++i)
+    {
+        rows.emplace(m_layerIDs[i], static_cast<int>(i));
+    }
+    m_parents.assign(numLayers, -1);
+    for (size_t i = 0; i < numLayers; ++i)
+    {
+        auto it = rows.find(structure.parentIDs[i]);
+        if (structure.parentIDs[i] && it != rows.end())
+        {
+            m_parents[i] = it->second;
+        }
+    }
+    m_samples.resize(numLayers * numFrames);
+    for (size_t i = 0; i < numLayers; ++i)
+    {
+        std::fill_n(m_samples.begin() + i * numFrames, numFrames, structure.statics[i]);
+    }
+    m_world.assign(numLayers * numFrames, ae::Mat4());
+
+    // Only animated streams, path tangents and exact layers are read per frame, a bounded number of frames per task.
+    const size_t chunk = std::max<size_t>(1, m_options.framesPerTask);
+    for (size_t begin = 0; begin < numFrames; begin += chunk)
+    {
+        size_t end = std::min(numFrames, begin + chunk);
+        ae::ScheduleOrExecute([&structure, &times, &store, this, begin, end, numLayers, numFrames]() {
+            auto &suites = SuiteManager::GetInstance().GetSuiteHandler();
+            for (size_t i = 0; i < numLayers; ++i)
+            {
+                const AEGP_LayerH layerH = structure.handles[i];
+                if (structure.exact[i])
+                {
+                    for (size_t f = begin; f < end; ++f)
+                    {
+                        A_Matrix4 matrix;
+                        AE_CHECK(suites.LayerSuite9()->AEGP_GetLayerToWorldXform(layerH, &times[f], &matrix));
+                        m_world[i * numFrames + f] = toMat4(matrix);
+                    }
+                    continue;
+                }
+                const char *animated = &structure.animated[i * NumTransformStreams];
+                const bool tangent = structure.autoOrient[i] && animated[Position];
+                for (size_t f = begin; f < end; ++f)
+                {
+                    Sample &s = m_samples[i * numFrames + f];
+                    for (int k = 0; k < NumTransformStreams; ++k)
+                    {
+                        if (animated[k])
+                        {
+                            store(s, k, readStream(suites, layerH, k, times[f]));
+                        }
+                    }
+                    if (tangent)
+                    {
+                        s.tangent = readStream(suites, layerH, Position, nudge(times[f], 1)) -
+                                    readStream(suites, layerH, Position, nudge(times[f], -1));
+                    }
+                }
+            }
+        }).get();
+    }
+}
+
+void TransformGraph::compose()
+{
+    const size_t numLayers = m_layerIDs.size();
+    const size_t numFrames = m_times.size();
+    m_local.assign(numLayers * numFrames, ae::Mat4());
+    m_singular.assign(numLayers * numFrames, 0);
+    if (numFrames == 0)
+    {
+        return;
+    }
+
+    // Local matrices of in-process layers are independent per layer.
+    ae::parallelFor(numLayers, m_options.maxThreads, [&](size_t i) {
+        if (m_exact[i])
+        {
+            return;
+        }
+        const ObjectType type = m_types[i];
+        const bool cameraOrLight = type == ObjectType::CAMERA || type == ObjectType::LIGHT;
+        const bool threeD = m_is3D[i] != 0;
+        const bool lookAt = m_lookAt[i] != 0;
+        const bool autoOrient = m_autoOrient[i] != 0;
+        for (size_t f = 0; f < numFrames; ++f)
+        {
+            const Sample &s = m_samples[i * numFrames + f];
+            ae::Mat4 m;
+            if (!cameraOrLight) // For cameras and lights the anchor stream is the point of interest
+            {
+                ae::Vec3 anchor = threeD ? s.anchor : ae::Vec3(s.anchor.x, s.anchor.y, 0.0);
+                ae::Vec3 scale = s.scale * 0.01;
+                if (!threeD)
+                {
+                    scale.z = 1.0;
+                }
+                m = ae::Mat4::translation(-anchor) * ae::Mat4::scale(scale);
+            }
+            if (threeD)
+            {
+                m = m * ae::Mat4::orientation(s.orientation) * ae::Mat4::rotationX(s.rotateX) *
+                    ae::Mat4::rotationY(s.rotateY) * ae::Mat4::rotationZ(s.rotateZ);
+                if (lookAt)
+                {
+                    m = m * ae::Mat4::lookAt(s.position, s.anchor);
+                }
+                else if (autoOrient) // Only cameras and lights; 3D layers along a path are exact
+                {
+                    m = m * ae::Mat4::lookAt(s.position, s.position + s.tangent);
+                }
+                m = m * ae::Mat4::translation(s.position);
+            }
+            else
+            {
+                double rotation = s.rotateZ;
+                if (autoOrient && (s.tangent.x != 0.0 || s.tangent.y != 0.0))
+                {
+                    rotation += std::atan2(s.tangent.y, s.tangent.x) * (180.0 / 3.14159265358979323846);
+                }
+                m = m * ae::Mat4::rotationZ(rotation) * ae::Mat4::translation({s.position.x, s.position.y, 0.0});
+            }
+            m_local[i * numFrames + f] = m;
+        }
+    });
+
+    // Group layers by depth in the parent hierarchy; each level only reads the one above it.
+    tk::vector<int> depth(numLayers, -1);
+    int maxDepth = 0;
+    for (size_t i = 0; i < numLayers; ++i)
+    {
+        int d = 0;
+        for (int p = m_parents[i]; p >= 0 && d <= static_cast<int>(numLayers); p = m_parents[p])
+        {
+            ++d;
+        }
+        depth[i] = d;
+        maxDepth = std::max(maxDepth, d);
+    }
+    tk::vector<tk::vector<size_t>> levels(maxDepth + 1);
+    for (size_t i = 0; i < numLayers; ++i)
+    {
+        levels[depth[i]].push_back(i);
+    }
+
+    for (const auto &level : levels)
+    {
+        ae::parallelFor(level.size(), m_options.maxThreads, [&](size_t n) {
+            size_t i = level[n];
+            int p = m_parents[i];
+            ae::Mat4 *world = &m_world[i * numFrames];
+            ae::Mat4 *local = &m_local[i * numFrames];
+            if (m_exact[i])
+            {
+                // world = local * parentWorld, so local = world * inverse(parentWorld).
+                if (p < 0)
+                {
+                    std::copy(world, world + numFrames, local);
+                    return;
+                }
+                const ae::Mat4 *parentWorld = &m_world[p * numFrames];
+                for (size_t f = 0; f < numFrames; ++f)
+                {
+                    if (auto inverse = parentWorld[f].affineInverse())
+                    {
+                        local[f] = world[f] * *inverse;
+                    }
+                    else
+                    {
+                        m_singular[i * numFrames + f] = 1;
+                    }
+                }
+                return;
+            }
+            if (p < 0)
+            {
+                std::copy(local, local + numFrames, world);
+                return;
+            }
+            const ae::Mat4 *parentWorld = &m_world[p * numFrames];
+            for (size_t f = 0; f < numFrames; ++f)
+            {
+                world[f] = local[f] * parentWorld[f];
+            }
+        });
+    }
+}